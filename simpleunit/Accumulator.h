@@ -0,0 +1,296 @@
+#pragma once
+
+#include "simpleunit/UnitSpan.h"
+#include <cmath>
+#include <cstdint>
+
+namespace sunit {
+
+// Summation policies. Each accumulates values of T and returns the total as a T:
+//
+//     void add(const T& x);
+//     void add(const T* x, std::size_t n);  // bulk
+//     void merge(const Policy& rhs);        // combine partial sums, e.g. from other threads
+//     T result() const;
+//
+// The bulk variants keep several independent partial sums ("lanes") so that the loop carries no
+// single dependency chain and can be vectorized. The compensated policies rely on strict IEEE
+// semantics and must not be built with -ffast-math.
+
+template <typename T> struct Widen { using type = T; };
+template <> struct Widen<float> { using type = double; };
+template <> struct Widen<double> { using type = long double; };
+
+constexpr std::size_t accumulator_lanes = 8;
+
+// Plain summation in a wider type
+template <typename T>
+class WideSum
+{
+public:
+	using wide_type = typename Widen<T>::type;
+
+	void add(const T& x) { sum_ += x; }
+
+	void add(const T* x, std::size_t n)
+	{
+		wide_type lanes[accumulator_lanes] = {};
+		std::size_t i = 0;
+		for (; i + accumulator_lanes <= n; i += accumulator_lanes)
+			for (std::size_t l = 0; l < accumulator_lanes; ++l)
+				lanes[l] += x[i + l];
+		for (; i < n; ++i)
+			sum_ += x[i];
+		for (std::size_t l = 0; l < accumulator_lanes; ++l)
+			sum_ += lanes[l];
+	}
+
+	void merge(const WideSum& rhs) { sum_ += rhs.sum_; }
+
+	T result() const { return static_cast<T>(sum_); }
+
+private:
+	wide_type sum_ = 0;
+};
+
+// Kahan summation: the running compensation holds the low-order bits lost by each addition
+template <typename T>
+class KahanSum
+{
+public:
+	void add(const T& x)
+	{
+		const T y = x - c_;
+		const T t = sum_ + y;
+		c_ = (t - sum_) - y;
+		sum_ = t;
+	}
+
+	void add(const T* x, std::size_t n)
+	{
+		T sum[accumulator_lanes] = {};
+		T c[accumulator_lanes] = {};
+		std::size_t i = 0;
+		for (; i + accumulator_lanes <= n; i += accumulator_lanes) {
+			for (std::size_t l = 0; l < accumulator_lanes; ++l) {
+				const T y = x[i + l] - c[l];
+				const T t = sum[l] + y;
+				c[l] = (t - sum[l]) - y;
+				sum[l] = t;
+			}
+		}
+		for (; i < n; ++i)
+			add(x[i]);
+		for (std::size_t l = 0; l < accumulator_lanes; ++l) {
+			add(sum[l]);
+			add(-c[l]);
+		}
+	}
+
+	void merge(const KahanSum& rhs) { add(rhs.sum_); add(-rhs.c_); }
+
+	T result() const { return sum_ - c_; }
+
+private:
+	T sum_ = 0;
+	T c_ = 0;
+};
+
+// Neumaier's variant of Kahan summation, which stays accurate when an addend is larger than the
+// running sum
+template <typename T>
+class NeumaierSum
+{
+public:
+	void add(const T& x)
+	{
+		const T t = sum_ + x;
+		c_ += std::abs(sum_) >= std::abs(x) ? (sum_ - t) + x : (x - t) + sum_;
+		sum_ = t;
+	}
+
+	void add(const T* x, std::size_t n)
+	{
+		T sum[accumulator_lanes] = {};
+		T c[accumulator_lanes] = {};
+		std::size_t i = 0;
+		for (; i + accumulator_lanes <= n; i += accumulator_lanes) {
+			for (std::size_t l = 0; l < accumulator_lanes; ++l) {
+				const T v = x[i + l];
+				const T t = sum[l] + v;
+				c[l] += std::abs(sum[l]) >= std::abs(v) ? (sum[l] - t) + v : (v - t) + sum[l];
+				sum[l] = t;
+			}
+		}
+		for (; i < n; ++i)
+			add(x[i]);
+		for (std::size_t l = 0; l < accumulator_lanes; ++l) {
+			add(sum[l]);
+			c_ += c[l];
+		}
+	}
+
+	void merge(const NeumaierSum& rhs) { add(rhs.sum_); c_ += rhs.c_; }
+
+	T result() const { return sum_ + c_; }
+
+private:
+	T sum_ = 0;
+	T c_ = 0;
+};
+
+// Pairwise (cascade) summation. Values are summed in blocks, and block sums are combined as a
+// binary counter so that every addition is between partial sums of similar size.
+template <typename T>
+class PairwiseSum
+{
+public:
+	static constexpr std::size_t block_size = 128;
+
+	void add(const T& x)
+	{
+		block_[fill_++] = x;
+		if (fill_ == block_size) {
+			carry(block_sum(block_, block_size), 0);
+			fill_ = 0;
+		}
+	}
+
+	void add(const T* x, std::size_t n)
+	{
+		while (fill_ != 0 && n != 0) {
+			add(*x++);
+			--n;
+		}
+		// Whole blocks in chunks of 2^k blocks, each entering the cascade at level k
+		std::size_t blocks = n / block_size;
+		for (int level = 63; level >= 0 && blocks != 0; --level) {
+			const std::size_t chunk = std::size_t(1) << level;
+			if (blocks & chunk) {
+				carry(pairwise(x, chunk * block_size), level);
+				x += chunk * block_size;
+				blocks -= chunk;
+			}
+		}
+		for (std::size_t i = 0; i < n % block_size; ++i)
+			add(x[i]);
+	}
+
+	void merge(const PairwiseSum& rhs)
+	{
+		for (int level = 0; level < 64; ++level)
+			if (rhs.occupied_ & (std::uint64_t(1) << level))
+				carry(rhs.levels_[level], level);
+		add(rhs.block_, rhs.fill_);
+	}
+
+	T result() const
+	{
+		T sum = block_sum(block_, fill_);
+		for (int level = 0; level < 64; ++level)
+			if (occupied_ & (std::uint64_t(1) << level))
+				sum += levels_[level];
+		return sum;
+	}
+
+private:
+	static T block_sum(const T* x, std::size_t n)
+	{
+		T lanes[accumulator_lanes] = {};
+		std::size_t i = 0;
+		for (; i + accumulator_lanes <= n; i += accumulator_lanes)
+			for (std::size_t l = 0; l < accumulator_lanes; ++l)
+				lanes[l] += x[i + l];
+		T sum = 0;
+		for (; i < n; ++i)
+			sum += x[i];
+		for (std::size_t s = accumulator_lanes / 2; s > 0; s /= 2)
+			for (std::size_t l = 0; l < s; ++l)
+				lanes[l] += lanes[l + s];
+		return lanes[0] + sum;
+	}
+
+	static T pairwise(const T* x, std::size_t n)
+	{
+		if (n <= block_size)
+			return block_sum(x, n);
+		const std::size_t half = n / 2;
+		return pairwise(x, half) + pairwise(x + half, n - half);
+	}
+
+	void carry(T sum, int level)
+	{
+		while (occupied_ & (std::uint64_t(1) << level)) {
+			sum = levels_[level] + sum;
+			occupied_ &= ~(std::uint64_t(1) << level);
+			++level;
+		}
+		levels_[level] = sum;
+		occupied_ |= std::uint64_t(1) << level;
+	}
+
+	T block_[block_size];
+	std::size_t fill_ = 0;
+	T levels_[64];
+	std::uint64_t occupied_ = 0;
+};
+
+template <typename T>
+constexpr std::size_t PairwiseSum<T>::block_size;
+
+
+// A running sum of units, accumulated under the summation policy and returned in the original
+// unit. Only values of the accumulator's unit (or those implicitly convertible to it) may be added
+//
+//     Accumulator<Seconds, KahanSum> total;
+//     for (auto t : durations) total += t;
+//     Seconds elapsed = total.sum();
+template <typename U, template <typename> class Policy = NeumaierSum>
+class Accumulator;
+
+template <typename T, typename B, template <typename> class Policy>
+class Accumulator<Unit<T,B>, Policy>
+{
+public:
+	using unit = Unit<T,B>;
+	using policy = Policy<T>;
+
+	Accumulator& operator+=(const unit& x)
+	{
+		policy_.add(x.value());
+		++count_;
+		return *this;
+	}
+
+	Accumulator& operator+=(UnitSpan<const T,B> values)
+	{
+		policy_.add(values.values(), values.size());
+		count_ += values.size();
+		return *this;
+	}
+
+	Accumulator& merge(const Accumulator& rhs)
+	{
+		policy_.merge(rhs.policy_);
+		count_ += rhs.count_;
+		return *this;
+	}
+
+	unit sum() const { return unit(policy_.result()); }
+	std::size_t count() const { return count_; }
+
+private:
+	policy policy_;
+	std::size_t count_ = 0;
+};
+
+// Sum a span of units under a summation policy
+template <template <typename> class Policy = NeumaierSum, typename T, typename B>
+Unit<std::remove_const_t<T>,B> sum(UnitSpan<T,B> values)
+{
+	Accumulator<Unit<std::remove_const_t<T>,B>, Policy> acc;
+	acc += values;
+	return acc.sum();
+}
+
+} // sunit
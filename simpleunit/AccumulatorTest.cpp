@@ -0,0 +1,99 @@
+#include "simpleunit/Accumulator.h"
+#include <vector>
+#include "gtest/gtest.h"
+
+using namespace std;
+using namespace sunit;
+
+namespace
+{
+	// Many small values: a plain float sum stalls well short of the true total
+	UnitArray<float, Time<si::second>> samples(std::size_t n)
+	{
+		UnitArray<float, Time<si::second>> values;
+		for (std::size_t i = 0; i < n; ++i)
+			values.push_back(si::Seconds(0.1f + 0.001f * (i % 7)));
+		return values;
+	}
+
+	long double exact(const UnitArray<float, Time<si::second>>& values)
+	{
+		long double total = 0;
+		for (const auto& v : values) total += v.value();
+		return total;
+	}
+
+	template <template <typename> class Policy>
+	void check_policy(const UnitArray<float, Time<si::second>>& values)
+	{
+		// Within a few ulps, where the plain float sum is out by tens of seconds
+		const float expected = static_cast<float>(exact(values));
+		const float tolerance = expected * 1e-6f;
+
+		Accumulator<si::Seconds, Policy> streamed;
+		for (const auto& v : values) streamed += v;
+		EXPECT_NEAR(expected, streamed.sum().value(), tolerance);
+		EXPECT_EQ(values.size(), streamed.count());
+
+		Accumulator<si::Seconds, Policy> bulk;
+		bulk += make_span(values);
+		EXPECT_NEAR(expected, bulk.sum().value(), tolerance);
+
+		// Partial sums over uneven chunks, merged
+		auto span = make_span(values);
+		Accumulator<si::Seconds, Policy> a, b, c;
+		a += span.subspan(0, 1001);
+		b += span.subspan(1001, 250000);
+		for (std::size_t i = 251001; i < span.size(); ++i) c += span[i];
+		a.merge(b).merge(c);
+		EXPECT_NEAR(expected, a.sum().value(), tolerance);
+		EXPECT_EQ(values.size(), a.count());
+	}
+}
+
+TEST(AccumulatorTest, NaiveDrift)
+{
+	const auto values = samples(1000000);
+	si::Seconds naive(0);
+	for (const auto& v : values) naive += v;
+	EXPECT_GT(std::abs(naive.value() - exact(values)), 50);
+}
+
+TEST(AccumulatorTest, Policies)
+{
+	const auto values = samples(1000000);
+	{ SCOPED_TRACE("WideSum"); check_policy<WideSum>(values); }
+	{ SCOPED_TRACE("KahanSum"); check_policy<KahanSum>(values); }
+	{ SCOPED_TRACE("NeumaierSum"); check_policy<NeumaierSum>(values); }
+	{ SCOPED_TRACE("PairwiseSum"); check_policy<PairwiseSum>(values); }
+}
+
+TEST(AccumulatorTest, Neumaier)
+{
+	// Kahan's compensation is lost when an addend exceeds the running sum
+	const double values[] = {1.0, 1e100, 1.0, -1e100};
+
+	NeumaierSum<double> neumaier;
+	neumaier.add(values, 4);
+	EXPECT_DOUBLE_EQ(2.0, neumaier.result());
+
+	KahanSum<double> kahan;
+	for (double v : values) kahan.add(v);
+	EXPECT_DOUBLE_EQ(0.0, kahan.result());
+}
+
+TEST(AccumulatorTest, UnitChecked)
+{
+	using namespace si;
+
+	Accumulator<Meters> total;
+	total += Meters(1);
+	total += Centimeters(50);  // implicit conversion
+	//total += Seconds(1);  // Should not compile: no viable overloaded '+='
+	EXPECT_FLOAT_EQ(1.5f, total.sum().value());
+	EXPECT_EQ(1, (std::is_same<Meters, decltype(total.sum())>::value));
+
+	UnitArray<float, Length<meter>> lengths = {Meters(1), Meters(2), Meters(3)};
+	EXPECT_FLOAT_EQ(6, sum(make_span(lengths)).value());
+	EXPECT_FLOAT_EQ(6, sum<PairwiseSum>(make_span(lengths)).value());
+}
@@ -0,0 +1,318 @@
+#pragma once
+
+#include "simpleunit/UnitSpan.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <vector>
+
+namespace sunit {
+
+// Aggregation of timestamped values over windows of time. Timestamps are units of any scale of
+// time (Unit<Tt,Bt>); window lengths may be given in any other scale, converted at construction
+// with the ratio fixed at compile time, e.g. a window of Minutes(5) over timestamps in Seconds.
+// Timestamps must not decrease.
+//
+// Storage is allocated up front for a given number of events, and reused from window to window.
+
+namespace detail
+{
+	// Sum and range of a set of values: a monoid, so partial summaries combine in any grouping
+	template <typename T>
+	struct Summary
+	{
+		T sum = 0;
+		T min = std::numeric_limits<T>::max();
+		T max = std::numeric_limits<T>::lowest();
+
+		static Summary of(T x) { return Summary{x, x, x}; }
+
+		friend Summary operator+(const Summary& a, const Summary& b)
+		{
+			return Summary{a.sum + b.sum, std::min(a.min, b.min), std::max(a.max, b.max)};
+		}
+	};
+
+	// The q-quantile (0 <= q <= 1) of n values, interpolating between order statistics (as R's
+	// default, type 7). Reorders the values
+	template <typename T>
+	T quantile(T* x, std::size_t n, double q)
+	{
+		assert(n > 0 && q >= 0 && q <= 1);
+		const double h = (n - 1) * q;
+		const std::size_t lo = static_cast<std::size_t>(h);
+		std::nth_element(x, x + lo, x + n);
+		if (lo + 1 >= n)
+			return x[lo];
+		const T next = *std::min_element(x + lo + 1, x + n);
+		return x[lo] + static_cast<T>(h - lo) * (next - x[lo]);
+	}
+}
+
+// The values of one window, and its bounds: passed to the callback as each tumbling or session
+// window closes
+template <typename V, typename Time>
+class WindowAggregate;
+
+template <typename T, typename B, typename Tt, typename Bt>
+class WindowAggregate<Unit<T,B>, Unit<Tt,Bt>>
+{
+public:
+	using value_type = Unit<T,B>;
+	using time_type = Unit<Tt,Bt>;
+
+	explicit WindowAggregate(std::size_t capacity)
+	{
+		values_.reserve(capacity);
+		scratch_.reserve(capacity);
+	}
+
+	// The start of the window (for a session, its first event) and the time of its last event
+	time_type start() const { return start_; }
+	time_type end() const { return end_; }
+
+	std::size_t count() const { return values_.size(); }
+	bool empty() const { return values_.empty(); }
+
+	value_type sum() const { return value_type(summary_.sum); }
+	value_type mean() const { return value_type(empty() ? T(0) : summary_.sum / static_cast<T>(count())); }
+	value_type min() const { return value_type(summary_.min); }
+	value_type max() const { return value_type(summary_.max); }
+
+	value_type quantile(double q) const
+	{
+		scratch_.assign(values_.begin(), values_.end());
+		return value_type(detail::quantile(scratch_.data(), scratch_.size(), q));
+	}
+
+	UnitSpan<const T,B> values() const { return UnitSpan<const T,B>(values_.data(), values_.size()); }
+
+	void add(const time_type& t, const value_type& v)
+	{
+		values_.push_back(v.value());
+		summary_ = summary_ + detail::Summary<T>::of(v.value());
+		end_ = t;
+	}
+
+	void clear(const time_type& start)
+	{
+		values_.clear();
+		summary_ = detail::Summary<T>();
+		start_ = end_ = start;
+	}
+
+private:
+	std::vector<T> values_;
+	mutable std::vector<T> scratch_;
+	detail::Summary<T> summary_;
+	time_type start_ = time_type(0);
+	time_type end_ = time_type(0);
+};
+
+// Fixed, non-overlapping windows aligned to multiples of the length. Each window is passed to the
+// callback when an event arrives beyond its end (or on flush); empty windows are skipped
+//
+//     TumblingWindow<Meters_Second, Seconds> speeds(Minutes(1), [](const auto& w) { ... w.mean() ... });
+template <typename V, typename Time>
+class TumblingWindow
+{
+public:
+	using value_type = V;
+	using time_type = Time;
+	using window_type = WindowAggregate<V, Time>;
+	using callback = std::function<void(const window_type&)>;
+
+	template <typename X, typename Bx>
+	TumblingWindow(const Unit<X,Bx>& length, callback on_close, std::size_t capacity = 1024)
+		: length_(unit_cast<Time>(length).value()), on_close_(std::move(on_close)), window_(capacity)
+	{
+		assert(length_ > 0);
+	}
+
+	void push(const Time& t, const V& v)
+	{
+		if (open_ && t.value() >= window_.start().value() + length_)
+			flush();
+		if (!open_) {
+			window_.clear(Time(static_cast<typename Time::rep>(std::floor(t.value() / length_) * length_)));
+			open_ = true;
+		}
+		window_.add(t, v);
+	}
+
+	// Close the current window, if any
+	void flush()
+	{
+		if (!open_) return;
+		on_close_(window_);
+		open_ = false;
+	}
+
+	// The window currently open
+	const window_type& current() const { return window_; }
+
+private:
+	typename Time::rep length_;
+	callback on_close_;
+	window_type window_;
+	bool open_ = false;
+};
+
+// Windows of activity separated by gaps of at least the given length. A session is passed to the
+// callback when an event arrives more than the gap after the last (or on flush)
+template <typename V, typename Time>
+class SessionWindow
+{
+public:
+	using value_type = V;
+	using time_type = Time;
+	using window_type = WindowAggregate<V, Time>;
+	using callback = std::function<void(const window_type&)>;
+
+	template <typename X, typename Bx>
+	SessionWindow(const Unit<X,Bx>& gap, callback on_close, std::size_t capacity = 1024)
+		: gap_(unit_cast<Time>(gap).value()), on_close_(std::move(on_close)), window_(capacity)
+	{
+	}
+
+	void push(const Time& t, const V& v)
+	{
+		if (open_ && t.value() - window_.end().value() > gap_)
+			flush();
+		if (!open_) {
+			window_.clear(t);
+			open_ = true;
+		}
+		window_.add(t, v);
+	}
+
+	void flush()
+	{
+		if (!open_) return;
+		on_close_(window_);
+		open_ = false;
+	}
+
+	const window_type& current() const { return window_; }
+
+private:
+	typename Time::rep gap_;
+	callback on_close_;
+	window_type window_;
+	bool open_ = false;
+};
+
+// The events of the last `length` of time, (now - length, now], queried at any point.
+//
+// Events are held in a ring buffer, evicted from the front as time advances. Sums and ranges use
+// two-stack aggregation: events behind a split point carry the summary of themselves and all
+// later events before the split, recomputed (once per event) when the front empties, and events
+// since the split are summarised as they arrive. So every operation is O(1) amortised, and sums
+// never subtract, so do not drift. The buffer grows if more than `capacity` events are in a window.
+template <typename V, typename Time>
+class SlidingWindow;
+
+template <typename T, typename B, typename Tt, typename Bt>
+class SlidingWindow<Unit<T,B>, Unit<Tt,Bt>>
+{
+public:
+	using value_type = Unit<T,B>;
+	using time_type = Unit<Tt,Bt>;
+
+	template <typename X, typename Bx>
+	SlidingWindow(const Unit<X,Bx>& length, std::size_t capacity = 1024)
+		: length_(unit_cast<time_type>(length).value())
+	{
+		std::size_t size = 1;
+		while (size < capacity) size *= 2;
+		resize(size);
+	}
+
+	void push(const time_type& t, const value_type& v)
+	{
+		advance(t);
+		if (tail_ - head_ == times_.size())
+			resize(2 * times_.size());
+		const std::size_t i = tail_++ & mask_;
+		times_[i] = t.value();
+		values_[i] = v.value();
+		back_ = back_ + detail::Summary<T>::of(v.value());
+	}
+
+	// Move the end of the window to t, evicting older events
+	void advance(const time_type& t)
+	{
+		const Tt oldest = t.value() - length_;
+		while (head_ != tail_ && times_[head_ & mask_] <= oldest) {
+			if (head_ == split_)
+				flip();
+			++head_;
+		}
+	}
+
+	std::size_t count() const { return tail_ - head_; }
+	bool empty() const { return head_ == tail_; }
+
+	value_type sum() const { return value_type(summary().sum); }
+	value_type mean() const { return value_type(empty() ? T(0) : summary().sum / static_cast<T>(count())); }
+	value_type min() const { return value_type(summary().min); }
+	value_type max() const { return value_type(summary().max); }
+
+	value_type quantile(double q) const
+	{
+		scratch_.clear();
+		for (std::size_t i = head_; i != tail_; ++i)
+			scratch_.push_back(values_[i & mask_]);
+		return value_type(detail::quantile(scratch_.data(), scratch_.size(), q));
+	}
+
+private:
+	detail::Summary<T> summary() const
+	{
+		return head_ == split_ ? back_ : suffix_[head_ & mask_] + back_;
+	}
+
+	// Move the split to the back, summarising each event with those after it
+	void flip()
+	{
+		detail::Summary<T> s;
+		for (std::size_t i = tail_; i != head_; --i) {
+			s = detail::Summary<T>::of(values_[(i - 1) & mask_]) + s;
+			suffix_[(i - 1) & mask_] = s;
+		}
+		split_ = tail_;
+		back_ = detail::Summary<T>();
+	}
+
+	void resize(std::size_t size)
+	{
+		std::vector<Tt> times(size);
+		std::vector<T> values(size);
+		std::vector<detail::Summary<T>> suffix(size);
+		for (std::size_t i = head_; i != tail_; ++i) {
+			times[i & (size - 1)] = times_[i & mask_];
+			values[i & (size - 1)] = values_[i & mask_];
+			suffix[i & (size - 1)] = suffix_[i & mask_];
+		}
+		times_.swap(times);
+		values_.swap(values);
+		suffix_.swap(suffix);
+		mask_ = size - 1;
+		scratch_.reserve(size);
+	}
+
+	Tt length_;
+	std::vector<Tt> times_;
+	std::vector<T> values_;
+	std::vector<detail::Summary<T>> suffix_;
+	mutable std::vector<T> scratch_;
+	std::size_t mask_ = 0;
+	std::size_t head_ = 0;
+	std::size_t split_ = 0;
+	std::size_t tail_ = 0;
+	detail::Summary<T> back_;
+};
+
+} // sunit
@@ -0,0 +1,110 @@
+#include "simpleunit/Aggregate.h"
+#include <random>
+#include "gtest/gtest.h"
+
+using namespace std;
+using namespace sunit;
+
+TEST(AggregateTest, Quantile)
+{
+	std::vector<float> x = {5, 1, 4, 2, 3};
+	EXPECT_EQ(1, detail::quantile(x.data(), x.size(), 0));
+	EXPECT_EQ(3, detail::quantile(x.data(), x.size(), 0.5));
+	EXPECT_EQ(5, detail::quantile(x.data(), x.size(), 1));
+	EXPECT_FLOAT_EQ(1.4f, detail::quantile(x.data(), x.size(), 0.1));
+}
+
+TEST(AggregateTest, Tumbling)
+{
+	using namespace si;
+
+	// One-minute windows over timestamps in seconds
+	std::vector<std::pair<float, float>> closed;  // start, sum
+	std::vector<std::size_t> counts;
+	TumblingWindow<Meters_Second, Seconds> window(Minutes(1), [&](const WindowAggregate<Meters_Second, Seconds>& w) {
+		closed.emplace_back(w.start().value(), w.sum().value());
+		counts.push_back(w.count());
+		EXPECT_FLOAT_EQ(w.sum().value() / w.count(), w.mean().value());
+	});
+
+	for (int t = 0; t < 150; t += 10)
+		window.push(Seconds(float(t)), Meters_Second(1));
+	window.push(Seconds(400), Meters_Second(5));  // after two empty minutes
+	window.flush();
+
+	ASSERT_EQ(4u, closed.size());
+	EXPECT_FLOAT_EQ(0, closed[0].first);
+	EXPECT_EQ(6u, counts[0]);
+	EXPECT_FLOAT_EQ(60, closed[1].first);
+	EXPECT_FLOAT_EQ(6, closed[1].second);
+	EXPECT_FLOAT_EQ(120, closed[2].first);
+	EXPECT_EQ(3u, counts[2]);
+	EXPECT_FLOAT_EQ(360, closed[3].first);
+	EXPECT_FLOAT_EQ(5, closed[3].second);
+}
+
+TEST(AggregateTest, Session)
+{
+	using namespace si;
+
+	std::vector<Meters_Second> maxima, medians;
+	SessionWindow<Meters_Second, Seconds> sessions(Seconds(30), [&](const WindowAggregate<Meters_Second, Seconds>& w) {
+		maxima.push_back(w.max());
+		medians.push_back(w.quantile(0.5));
+	});
+
+	for (float t : {0.f, 10.f, 20.f, 100.f, 110.f})
+		sessions.push(Seconds(t), Meters_Second(t));
+	EXPECT_EQ(1u, maxima.size());
+	EXPECT_FLOAT_EQ(100, sessions.current().start().value());
+	sessions.flush();
+
+	ASSERT_EQ(2u, maxima.size());
+	EXPECT_FLOAT_EQ(20, maxima[0].value());
+	EXPECT_FLOAT_EQ(10, medians[0].value());
+	EXPECT_FLOAT_EQ(105, medians[1].value());
+}
+
+TEST(AggregateTest, Sliding)
+{
+	using namespace si;
+
+	// Compare against a brute-force window, through several growths of the buffer
+	std::mt19937 rng(3);
+	std::uniform_real_distribution<float> value(-10, 10);
+	std::exponential_distribution<float> gap(20);
+
+	SlidingWindow<Meters_Second, Seconds> window(Minutes(0.05f), 4);  // 3 s
+	std::vector<std::pair<float, float>> events;
+	float t = 0;
+	for (int i = 0; i < 5000; ++i) {
+		t += i % 1000 < 500 ? gap(rng) : 10 * gap(rng);
+		const float v = value(rng);
+		window.push(Seconds(t), Meters_Second(v));
+		events.emplace_back(t, v);
+
+		if (i % 97 != 0) continue;
+		double sum = 0;
+		float lo = 1e9f, hi = -1e9f;
+		std::vector<float> in;
+		for (const auto& e : events)
+			if (e.first > t - 3) {
+				sum += e.second;
+				lo = std::min(lo, e.second);
+				hi = std::max(hi, e.second);
+				in.push_back(e.second);
+			}
+		ASSERT_EQ(in.size(), window.count());
+		ASSERT_NEAR(sum, window.sum().value(), 1e-3);
+		ASSERT_EQ(lo, window.min().value());
+		ASSERT_EQ(hi, window.max().value());
+		ASSERT_FLOAT_EQ(detail::quantile(in.data(), in.size(), 0.9), window.quantile(0.9).value());
+	}
+
+	// Advancing past the window empties it
+	window.advance(Seconds(t + 10));
+	EXPECT_TRUE(window.empty());
+	EXPECT_EQ(0, window.sum().value());
+	window.push(Seconds(t + 11), Meters_Second(2));
+	EXPECT_FLOAT_EQ(2, window.mean().value());
+}
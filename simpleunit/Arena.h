@@ -0,0 +1,192 @@
+#pragma once
+
+#include "simpleunit/UnitSpan.h"
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#endif
+
+namespace sunit {
+
+// A monotonic arena: allocations are carved from large blocks and never freed one at a time, only
+// all together, by reset() or when the arena is destroyed. Many short-lived arrays built while
+// handling a request then cost a pointer bump each rather than a call to malloc:
+//
+//     MonotonicArena arena;
+//     ArenaArray<float, Length<meter>> x(n, ArenaAllocator<Meters>(arena));
+//     ArenaSoA<Seconds, Meters_Second> log(n, arena);
+//     ...
+//     arena.reset();   // everything above is gone; the blocks are kept for the next request
+//
+// Allocations are aligned to 64 bytes (a cache line, and the widest SIMD register). Blocks are
+// mapped from the OS where possible, aligned to 2 MiB and advised as huge pages on Linux.
+class MonotonicArena
+{
+public:
+	static constexpr std::size_t alignment = 64;
+	static constexpr std::size_t huge_page = std::size_t(2) << 20;
+
+	explicit MonotonicArena(std::size_t block_size = huge_page) : block_size_(block_size) {}
+
+	~MonotonicArena() { release(); }
+
+	MonotonicArena(const MonotonicArena&) = delete;
+	MonotonicArena& operator=(const MonotonicArena&) = delete;
+
+	// Memory for bytes, aligned to at least align (a power of two). Throws std::bad_alloc
+	void* allocate(std::size_t bytes, std::size_t align = alignment)
+	{
+		assert(align && !(align & (align - 1)));
+		if (align < alignment) align = alignment;
+		bytes = std::max<std::size_t>(bytes, 1);
+		while (current_ < blocks_.size()) {
+			Block& b = blocks_[current_];
+			// Align the address itself: a block is only sure to be aligned to 64 bytes
+			const std::uintptr_t start = reinterpret_cast<std::uintptr_t>(b.data);
+			const std::size_t offset = static_cast<std::size_t>(((start + used_ + align - 1) & ~std::uintptr_t(align - 1)) - start);
+			if (offset + bytes <= b.size) {
+				used_ = offset + bytes;
+				allocated_ += bytes;
+				return b.data + offset;
+			}
+			++current_;
+			used_ = 0;
+		}
+		// Blocks are aligned to at least 64 bytes, so larger alignments may need up to align bytes of
+		// slack before the allocation
+		const std::size_t size = std::max(block_size_, bytes + align);
+		blocks_.push_back(map(size));
+		current_ = blocks_.size() - 1;
+		used_ = 0;
+		return allocate(bytes, align);
+	}
+
+	// Free every allocation at once, keeping the blocks for reuse
+	void reset()
+	{
+		current_ = 0;
+		used_ = 0;
+		allocated_ = 0;
+	}
+
+	// Free every allocation and return the blocks to the OS
+	void release()
+	{
+		for (const Block& b : blocks_)
+			unmap(b);
+		blocks_.clear();
+		reset();
+	}
+
+	// Bytes handed out since the last reset
+	std::size_t allocated() const { return allocated_; }
+
+	// Bytes held in blocks
+	std::size_t capacity() const
+	{
+		std::size_t n = 0;
+		for (const Block& b : blocks_)
+			n += b.size;
+		return n;
+	}
+
+private:
+	struct Block
+	{
+		char* data;
+		std::size_t size;
+		void* base;         // as mapped or allocated
+		std::size_t mapped; // zero if from malloc
+	};
+
+	static Block map(std::size_t size)
+	{
+#if defined(__unix__) || defined(__APPLE__)
+		// Over-map by a huge page and trim, so the block starts on a huge page boundary
+		size = (size + huge_page - 1) & ~(huge_page - 1);
+		const std::size_t mapped = size + huge_page;
+		void* p = ::mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (p == MAP_FAILED)
+			throw std::bad_alloc();
+		const std::uintptr_t start = reinterpret_cast<std::uintptr_t>(p);
+		const std::uintptr_t aligned = (start + huge_page - 1) & ~std::uintptr_t(huge_page - 1);
+		if (aligned > start)
+			::munmap(p, aligned - start);
+		if (aligned + size < start + mapped)
+			::munmap(reinterpret_cast<void*>(aligned + size), start + mapped - aligned - size);
+#if defined(MADV_HUGEPAGE)
+		::madvise(reinterpret_cast<void*>(aligned), size, MADV_HUGEPAGE);
+#endif
+		return Block{reinterpret_cast<char*>(aligned), size, reinterpret_cast<void*>(aligned), size};
+#else
+		void* p = std::malloc(size + alignment);
+		if (!p)
+			throw std::bad_alloc();
+		const std::uintptr_t aligned = (reinterpret_cast<std::uintptr_t>(p) + alignment - 1) & ~std::uintptr_t(alignment - 1);
+		return Block{reinterpret_cast<char*>(aligned), size, p, 0};
+#endif
+	}
+
+	static void unmap(const Block& b)
+	{
+#if defined(__unix__) || defined(__APPLE__)
+		::munmap(b.base, b.mapped);
+#else
+		std::free(b.base);
+#endif
+	}
+
+	std::vector<Block> blocks_;
+	std::size_t block_size_;
+	std::size_t current_ = 0;
+	std::size_t used_ = 0;
+	std::size_t allocated_ = 0;
+};
+
+// A standard allocator drawing from a MonotonicArena. Deallocation does nothing: memory returns
+// to the arena on reset. Copies and rebinds share the arena, which must outlive them
+template <typename T>
+class ArenaAllocator
+{
+public:
+	using value_type = T;
+
+	ArenaAllocator(MonotonicArena& arena) : arena_(&arena) {}
+
+	template <typename U>
+	ArenaAllocator(const ArenaAllocator<U>& rhs) : arena_(&rhs.arena()) {}
+
+	T* allocate(std::size_t n)
+	{
+		if (n > std::size_t(-1) / sizeof(T))
+			throw std::bad_alloc();
+		return static_cast<T*>(arena_->allocate(n * sizeof(T), alignof(T)));
+	}
+
+	void deallocate(T*, std::size_t) {}
+
+	MonotonicArena& arena() const { return *arena_; }
+
+	template <typename U>
+	friend bool operator==(const ArenaAllocator& a, const ArenaAllocator<U>& b) { return &a.arena() == &b.arena(); }
+	template <typename U>
+	friend bool operator!=(const ArenaAllocator& a, const ArenaAllocator<U>& b) { return !(a == b); }
+
+private:
+	MonotonicArena* arena_;
+};
+
+template <typename T, typename B = BaseUnit<>>
+using ArenaArray = UnitArray<T, B, ArenaAllocator<Unit<T,B>>>;
+
+template <typename... Units>
+using ArenaSoA = BasicUnitSoA<ArenaAllocator<void>, Units...>;
+
+} // sunit
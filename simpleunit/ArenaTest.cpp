@@ -0,0 +1,95 @@
+#include "simpleunit/Arena.h"
+#include "simpleunit/Query.h"
+#include <cstdint>
+#include "gtest/gtest.h"
+
+using namespace std;
+using namespace sunit;
+
+namespace
+{
+	bool aligned(const void* p, size_t a) { return reinterpret_cast<uintptr_t>(p) % a == 0; }
+}
+
+TEST(ArenaTest, Alignment)
+{
+	MonotonicArena arena;
+	for (size_t bytes : {1, 3, 64, 100, 4096}) {
+		void* p = arena.allocate(bytes);
+		EXPECT_TRUE(aligned(p, MonotonicArena::alignment));
+	}
+	EXPECT_TRUE(aligned(arena.allocate(10, 4096), 4096));
+	EXPECT_EQ(1u * 1 + 3 + 64 + 100 + 4096 + 10, arena.allocated());
+	EXPECT_EQ(size_t(MonotonicArena::huge_page), arena.capacity());
+
+	// Alignments beyond the default, after an allocation that leaves the offset unaligned
+	for (size_t a : {128, 256, 1024}) {
+		arena.allocate(1);
+		EXPECT_TRUE(aligned(arena.allocate(10, a), a));
+	}
+}
+
+TEST(ArenaTest, ResetReusesBlocks)
+{
+	MonotonicArena arena(1 << 16);
+	void* first = arena.allocate(1000);
+	for (int i = 0; i < 200; ++i)
+		arena.allocate(1000);
+	const size_t capacity = arena.capacity();
+	EXPECT_GE(capacity, 200u * 1000);
+
+	arena.reset();
+	EXPECT_EQ(0u, arena.allocated());
+	EXPECT_EQ(first, arena.allocate(1000));
+	for (int i = 0; i < 200; ++i)
+		arena.allocate(1000);
+	EXPECT_EQ(capacity, arena.capacity());
+
+	arena.release();
+	EXPECT_EQ(0u, arena.capacity());
+}
+
+TEST(ArenaTest, LargeAllocation)
+{
+	MonotonicArena arena(1 << 12);
+	char* p = static_cast<char*>(arena.allocate(3 << 20));
+	p[0] = 1;
+	p[(3 << 20) - 1] = 2;
+	EXPECT_TRUE(aligned(p, MonotonicArena::alignment));
+	EXPECT_GE(arena.capacity(), size_t(3) << 20);
+}
+
+TEST(ArenaTest, ArenaArray)
+{
+	MonotonicArena arena;
+	ArenaArray<float, Length<si::meter>> x{ArenaAllocator<si::Meters>(arena)};
+	for (int i = 0; i < 10000; ++i)
+		x.push_back(si::Meters(float(i)));
+	EXPECT_TRUE(aligned(x.data(), MonotonicArena::alignment));
+	EXPECT_EQ(9999.f, x.back().value());
+
+	auto span = make_span(x);
+	EXPECT_EQ(10000u, span.size());
+	EXPECT_GE(arena.allocated(), 10000 * sizeof(float));
+}
+
+TEST(ArenaTest, ArenaSoA)
+{
+	MonotonicArena arena;
+	ArenaSoA<si::Seconds, si::Meters_Second> log(1000, arena);
+	EXPECT_TRUE(aligned(log.column<0>().values(), MonotonicArena::alignment));
+	EXPECT_TRUE(aligned(log.column<1>().values(), MonotonicArena::alignment));
+	for (size_t i = 0; i < log.size(); ++i) {
+		log.column<0>()[i] = si::Seconds(float(i));
+		log.column<1>()[i] = si::Meters_Second(float(i % 10));
+	}
+	EXPECT_EQ(2 * 1000 * sizeof(float), arena.allocated());
+	EXPECT_EQ(500u, query(log).where<1>(below(si::Meters_Second(5))).count());
+}
+
+TEST(ArenaTest, AllocatorEquality)
+{
+	MonotonicArena a, b;
+	EXPECT_TRUE(ArenaAllocator<int>(a) == ArenaAllocator<double>(a));
+	EXPECT_TRUE(ArenaAllocator<int>(a) != ArenaAllocator<int>(b));
+}
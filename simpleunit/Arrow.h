@@ -0,0 +1,328 @@
+#pragma once
+
+#include "simpleunit/DynamicUnit.h"
+#include "simpleunit/UnitSpan.h"
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+// The Arrow C Data Interface, as published in the Arrow format specification (Apache 2.0),
+// https://arrow.apache.org/docs/format/CDataInterface.html
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+#define ARROW_FLAG_DICTIONARY_ORDERED 1
+#define ARROW_FLAG_NULLABLE 2
+#define ARROW_FLAG_MAP_KEYS_SORTED 4
+
+extern "C" {
+
+struct ArrowSchema {
+	// Array type description
+	const char* format;
+	const char* name;
+	const char* metadata;
+	int64_t flags;
+	int64_t n_children;
+	struct ArrowSchema** children;
+	struct ArrowSchema* dictionary;
+
+	// Release callback
+	void (*release)(struct ArrowSchema*);
+	// Opaque producer-specific data
+	void* private_data;
+};
+
+struct ArrowArray {
+	// Array data description
+	int64_t length;
+	int64_t null_count;
+	int64_t offset;
+	int64_t n_buffers;
+	int64_t n_children;
+	const void** buffers;
+	struct ArrowArray** children;
+	struct ArrowArray* dictionary;
+
+	// Release callback
+	void (*release)(struct ArrowArray*);
+	// Opaque producer-specific data
+	void* private_data;
+};
+
+}
+
+#endif // ARROW_C_DATA_INTERFACE
+
+namespace sunit {
+
+// Exchange of unit columns with Arrow (pyarrow, Polars, DuckDB...) through the C Data Interface,
+// without copying. A column is a primitive array whose field metadata carries its unit:
+//
+//     sunit.dim    "1,-1,0"        exponents of length, time and mass
+//     sunit.scale  "0.2777..."     magnitude relative to m, s and kg, as DynamicUnit
+//     sunit.unit   "km/h"          the symbol, where there is one
+//
+// Importing views the producer's buffer directly if its type and scale are those asked for,
+// and otherwise converts into a new array. Either way the dimension must match.
+
+namespace detail
+{
+	template <typename T> struct ArrowFormat;
+	template <> struct ArrowFormat<std::int8_t> { static const char* value() { return "c"; } };
+	template <> struct ArrowFormat<std::uint8_t> { static const char* value() { return "C"; } };
+	template <> struct ArrowFormat<std::int16_t> { static const char* value() { return "s"; } };
+	template <> struct ArrowFormat<std::uint16_t> { static const char* value() { return "S"; } };
+	template <> struct ArrowFormat<std::int32_t> { static const char* value() { return "i"; } };
+	template <> struct ArrowFormat<std::uint32_t> { static const char* value() { return "I"; } };
+	template <> struct ArrowFormat<std::int64_t> { static const char* value() { return "l"; } };
+	template <> struct ArrowFormat<std::uint64_t> { static const char* value() { return "L"; } };
+	template <> struct ArrowFormat<float> { static const char* value() { return "f"; } };
+	template <> struct ArrowFormat<double> { static const char* value() { return "g"; } };
+
+	template <typename B>
+	const char* arrow_unit_symbol(std::true_type) { return unit_symbol<B>(); }
+	template <typename B>
+	const char* arrow_unit_symbol(std::false_type) { return nullptr; }
+
+	// Metadata as the C Data Interface encodes it: int32 pair count, then each key and value as an
+	// int32 length and bytes, in native byte order
+	inline void append_int32(std::string& out, std::int32_t n) { out.append(reinterpret_cast<const char*>(&n), sizeof(n)); }
+
+	inline std::string arrow_metadata(const DynamicUnit& unit, const char* symbol)
+	{
+		char dim[48];
+		std::snprintf(dim, sizeof(dim), "%d,%d,%d", unit.dim[0], unit.dim[1], unit.dim[2]);
+		char scale[32];
+		std::snprintf(scale, sizeof(scale), "%.17g", unit.scale);
+		const char* pairs[3][2] = {{"sunit.dim", dim}, {"sunit.scale", scale}, {"sunit.unit", symbol}};
+
+		std::string out;
+		append_int32(out, symbol ? 3 : 2);
+		for (auto& pair : pairs)
+			if (pair[1])
+				for (const char* s : pair) {
+					append_int32(out, static_cast<std::int32_t>(std::strlen(s)));
+					out.append(s);
+				}
+		return out;
+	}
+
+	inline std::int32_t read_int32(const char*& p)
+	{
+		std::int32_t n;
+		std::memcpy(&n, p, sizeof(n));
+		p += sizeof(n);
+		return n;
+	}
+
+	// The unit described by a field's metadata. Throws std::invalid_argument if there is none
+	inline DynamicUnit arrow_unit(const char* metadata)
+	{
+		if (!metadata)
+			throw std::invalid_argument("arrow: field has no unit metadata");
+		const char* p = metadata;
+		const std::int32_t pairs = read_int32(p);
+		bool have_dim = false, have_scale = false;
+		DynamicUnit unit;
+		for (std::int32_t i = 0; i < pairs; ++i) {
+			const std::int32_t key_size = read_int32(p);
+			const std::string key(p, key_size);
+			p += key_size;
+			const std::int32_t value_size = read_int32(p);
+			const std::string value(p, value_size);
+			p += value_size;
+			if (key == "sunit.dim")
+				have_dim = std::sscanf(value.c_str(), "%d,%d,%d", &unit.dim[0], &unit.dim[1], &unit.dim[2]) == 3;
+			else if (key == "sunit.scale") {
+				char* end;
+				unit.scale = std::strtod(value.c_str(), &end);
+				have_scale = end != value.c_str() && unit.scale > 0;
+			}
+		}
+		if (!have_dim || !have_scale)
+			throw std::invalid_argument("arrow: field has no unit metadata");
+		return unit;
+	}
+
+	template <typename Owner>
+	struct ArrowArrayData
+	{
+		Owner owner;
+		const void* buffers[2];
+	};
+
+	struct ArrowSchemaData
+	{
+		std::string name;
+		std::string metadata;
+	};
+
+	inline void release_schema(ArrowSchema* schema)
+	{
+		delete static_cast<ArrowSchemaData*>(schema->private_data);
+		schema->release = nullptr;
+	}
+
+	template <typename Owner>
+	void release_array(ArrowArray* array)
+	{
+		delete static_cast<ArrowArrayData<Owner>*>(array->private_data);
+		array->release = nullptr;
+	}
+
+	template <typename T, typename B>
+	void export_schema(ArrowSchema* schema, const char* name)
+	{
+		auto* data = new ArrowSchemaData{name, arrow_metadata(dynamic_unit<B>(), arrow_unit_symbol<B>(
+			std::integral_constant<bool, has_unit_symbol<B>()>()))};
+		*schema = ArrowSchema{ArrowFormat<std::remove_const_t<T>>::value(), data->name.c_str(), data->metadata.c_str(),
+		                      0, 0, nullptr, nullptr, &release_schema, data};
+	}
+
+	template <typename Owner>
+	void export_array(ArrowArray* array, Owner owner, const void* values, std::size_t size)
+	{
+		auto* data = new ArrowArrayData<Owner>{std::move(owner), {nullptr, values}};
+		*array = ArrowArray{static_cast<int64_t>(size), 0, 0, 2, 0, data->buffers, nullptr, nullptr,
+		                    &release_array<Owner>, data};
+	}
+
+	struct NoOwner {};
+}
+
+// Export a view of a span, which must outlive the consumer's use of it (until it calls release)
+template <typename T, typename B>
+void export_arrow(UnitSpan<T,B> span, ArrowArray* array, ArrowSchema* schema, const char* name = "")
+{
+	detail::export_schema<T,B>(schema, name);
+	detail::export_array(array, detail::NoOwner(), span.values(), span.size());
+}
+
+// Export an array, handing it over to the consumer: it is freed when the consumer calls release
+template <typename T, typename B>
+void export_arrow(UnitArray<T,B>&& values, ArrowArray* array, ArrowSchema* schema, const char* name = "")
+{
+	detail::export_schema<T,B>(schema, name);
+	const void* data = UnitSpan<T,B>(values).values();
+	const std::size_t size = values.size();
+	detail::export_array(array, std::move(values), data, size);
+}
+
+// A column imported from Arrow as Unit<T,B>, taking ownership of the array and schema (which are
+// marked released, as the C Data Interface moves them). Views the array's buffer if it holds T in
+// unit B with no nulls, or else holds a converted copy, with nulls as NaN. Throws
+// std::invalid_argument if the field is not a primitive numeric column, has no unit metadata, or
+// is of another dimension
+template <typename T, typename B>
+class ArrowColumn
+{
+public:
+	ArrowColumn(ArrowArray* array, ArrowSchema* schema)
+		: array_(*array), schema_(*schema)
+	{
+		array->release = nullptr;
+		schema->release = nullptr;
+		try {
+			import();
+		}
+		catch (...) {
+			release();
+			throw;
+		}
+	}
+
+	~ArrowColumn() { release(); }
+
+	ArrowColumn(const ArrowColumn&) = delete;
+	ArrowColumn& operator=(const ArrowColumn&) = delete;
+
+	UnitSpan<const T,B> span() const { return UnitSpan<const T,B>(values_, size_); }
+	std::size_t size() const { return size_; }
+
+	// Whether the values were converted rather than viewed in place
+	bool copied() const { return !copy_.empty(); }
+
+	// The unit the column was exported in
+	const DynamicUnit& source_unit() const { return source_; }
+
+private:
+	void import()
+	{
+		if (!schema_.format || std::strlen(schema_.format) != 1 || array_.n_buffers != 2 || array_.n_children != 0)
+			throw std::invalid_argument("arrow: not a primitive column");
+		source_ = detail::arrow_unit(schema_.metadata);
+		const DynamicUnit target = dynamic_unit<B>();
+		if (!source_.same_dimension(target))
+			throw std::invalid_argument("arrow: column has the wrong dimension");
+		const double factor = conversion_factor(source_, target);
+		size_ = static_cast<std::size_t>(array_.length);
+
+		const bool same = std::strcmp(schema_.format, detail::ArrowFormat<T>::value()) == 0
+		               && std::abs(factor - 1) <= 4 * std::numeric_limits<double>::epsilon()
+		               && array_.null_count == 0;
+		const T* values = static_cast<const T*>(array_.buffers[1]) + array_.offset;
+		if (same && reinterpret_cast<std::uintptr_t>(values) % alignof(T) == 0) {
+			values_ = values;
+			return;
+		}
+
+		switch (schema_.format[0]) {
+		case 'c': convert<std::int8_t>(factor); break;
+		case 'C': convert<std::uint8_t>(factor); break;
+		case 's': convert<std::int16_t>(factor); break;
+		case 'S': convert<std::uint16_t>(factor); break;
+		case 'i': convert<std::int32_t>(factor); break;
+		case 'I': convert<std::uint32_t>(factor); break;
+		case 'l': convert<std::int64_t>(factor); break;
+		case 'L': convert<std::uint64_t>(factor); break;
+		case 'f': convert<float>(factor); break;
+		case 'g': convert<double>(factor); break;
+		default: throw std::invalid_argument(std::string("arrow: unsupported format '") + schema_.format + "'");
+		}
+	}
+
+	template <typename S>
+	void convert(double factor)
+	{
+		copy_.resize(size_);
+		T* out = UnitSpan<T,B>(copy_).values();
+		const S* in = static_cast<const S*>(array_.buffers[1]) + array_.offset;
+		for (std::size_t i = 0; i < size_; ++i)
+			out[i] = static_cast<T>(static_cast<double>(in[i]) * factor);
+
+		const std::uint8_t* valid = static_cast<const std::uint8_t*>(array_.buffers[0]);
+		if (array_.null_count != 0 && valid) {
+			if (!std::is_floating_point<T>::value)
+				throw std::invalid_argument("arrow: nulls in a column of integers");
+			for (std::size_t i = 0; i < size_; ++i) {
+				const std::size_t bit = i + static_cast<std::size_t>(array_.offset);
+				if (!(valid[bit / 8] & (1 << (bit % 8))))
+					out[i] = std::numeric_limits<T>::quiet_NaN();
+			}
+		}
+		values_ = out;
+	}
+
+	void release()
+	{
+		if (array_.release) array_.release(&array_);
+		if (schema_.release) schema_.release(&schema_);
+	}
+
+	ArrowArray array_;
+	ArrowSchema schema_;
+	DynamicUnit source_;
+	const T* values_ = nullptr;
+	std::size_t size_ = 0;
+	UnitArray<T,B> copy_;
+};
+
+} // sunit
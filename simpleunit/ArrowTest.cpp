@@ -0,0 +1,140 @@
+#include "simpleunit/Arrow.h"
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+#include "gtest/gtest.h"
+
+using namespace std;
+using namespace sunit;
+
+namespace
+{
+	// Metadata entries as key/value strings
+	vector<pair<string, string>> metadata(const char* p)
+	{
+		auto read = [&p] { int32_t n; memcpy(&n, p, 4); p += 4; return n; };
+		vector<pair<string, string>> out;
+		for (int32_t i = read(); i > 0; --i) {
+			int32_t n = read();
+			string key(p, n);
+			p += n;
+			n = read();
+			out.emplace_back(key, string(p, n));
+			p += n;
+		}
+		return out;
+	}
+}
+
+TEST(ArrowTest, Export)
+{
+	using namespace si;
+
+	vector<Meters_Second> speeds = {Meters_Second(1), Meters_Second(2), Meters_Second(3)};
+	ArrowArray array;
+	ArrowSchema schema;
+	export_arrow(make_span(speeds), &array, &schema, "speed");
+
+	EXPECT_STREQ("f", schema.format);
+	EXPECT_STREQ("speed", schema.name);
+	const auto meta = metadata(schema.metadata);
+	ASSERT_EQ(3u, meta.size());
+	EXPECT_EQ(make_pair(string("sunit.dim"), string("1,-1,0")), meta[0]);
+	EXPECT_EQ(make_pair(string("sunit.scale"), string("1")), meta[1]);
+	EXPECT_EQ(make_pair(string("sunit.unit"), string("m/s")), meta[2]);
+
+	EXPECT_EQ(3, array.length);
+	EXPECT_EQ(0, array.null_count);
+	EXPECT_EQ(2, array.n_buffers);
+	EXPECT_EQ(nullptr, array.buffers[0]);
+	EXPECT_EQ(static_cast<const void*>(&speeds[0]), array.buffers[1]);
+
+	array.release(&array);
+	schema.release(&schema);
+	EXPECT_EQ(nullptr, array.release);
+	EXPECT_EQ(nullptr, schema.release);
+
+	// Ratios without a symbol give only the dimension and scale
+	UnitArray<double, Length<std::ratio<1, 7>>> sevenths(2);
+	export_arrow(make_span(sevenths), &array, &schema);
+	EXPECT_STREQ("g", schema.format);
+	EXPECT_EQ(2u, metadata(schema.metadata).size());
+	array.release(&array);
+	schema.release(&schema);
+}
+
+TEST(ArrowTest, ZeroCopy)
+{
+	using namespace si;
+
+	UnitArray<float, Length<meter>> lengths = {Meters(1), Meters(2.5f)};
+	const void* data = &lengths[0];
+	ArrowArray array;
+	ArrowSchema schema;
+	export_arrow(std::move(lengths), &array, &schema);
+	EXPECT_EQ(data, array.buffers[1]);
+
+	ArrowColumn<float, Length<meter>> column(&array, &schema);
+	EXPECT_EQ(nullptr, array.release);
+	EXPECT_EQ(nullptr, schema.release);
+	EXPECT_FALSE(column.copied());
+	ASSERT_EQ(2u, column.size());
+	EXPECT_EQ(data, column.span().values());
+	EXPECT_FLOAT_EQ(2.5f, column.span()[1].value());
+}
+
+TEST(ArrowTest, Convert)
+{
+	using namespace si;
+
+	vector<Unit<double, Velocity<std::kilo, hour>>> speeds(4);
+	for (int i = 0; i < 4; ++i)
+		speeds[i] = Unit<double, Velocity<std::kilo, hour>>(36.0 * i);
+
+	ArrowArray array;
+	ArrowSchema schema;
+	export_arrow(make_span(speeds), &array, &schema);
+	// A slice with the second value null
+	array.offset = 1;
+	array.length = 3;
+	array.null_count = 1;
+	const uint8_t valid = 0xff & ~(1 << 2);
+	array.buffers[0] = &valid;
+
+	ArrowColumn<float, Velocity<meter, second>> column(&array, &schema);
+	EXPECT_TRUE(column.copied());
+	ASSERT_EQ(3u, column.size());
+	EXPECT_FLOAT_EQ(10, column.span()[0].value());
+	EXPECT_TRUE(std::isnan(column.span()[1].value()));
+	EXPECT_FLOAT_EQ(30, column.span()[2].value());
+	EXPECT_DOUBLE_EQ(1000.0 / 3600, column.source_unit().scale);
+}
+
+TEST(ArrowTest, Errors)
+{
+	using namespace si;
+
+	int releases = 0;
+	vector<Seconds> times(3);
+	auto import = [&](const char* format) {
+		ArrowArray array;
+		ArrowSchema schema;
+		export_arrow(make_span(times), &array, &schema);
+		if (format) schema.format = format;
+		ArrowColumn<float, Length<meter>> column(&array, &schema);
+	};
+	EXPECT_THROW(import(nullptr), invalid_argument);
+	EXPECT_THROW(import("+s"), invalid_argument);
+
+	// The column is released even if the import fails
+	ArrowArray array;
+	ArrowSchema schema;
+	export_arrow(make_span(times), &array, &schema);
+	schema.release(&schema);
+	schema.private_data = &releases;
+	schema.release = [](ArrowSchema* s) { ++*static_cast<int*>(s->private_data); s->release = nullptr; };
+	schema.metadata = nullptr;
+	EXPECT_THROW((ArrowColumn<float, Time<second>>(&array, &schema)), invalid_argument);
+	EXPECT_EQ(1, releases);
+}
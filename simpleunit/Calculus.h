@@ -0,0 +1,249 @@
+#pragma once
+
+#include "simpleunit/Accumulator.h"
+#include <cassert>
+
+namespace sunit {
+
+// Integrals and derivatives of sampled values. Each takes the samples y and either a uniform step
+// or a span of (increasing) sample points x. Integrals are in the unit of y * x and derivatives in
+// the unit of y / x, with any scale conversion of x folded into a single factor applied in the loop
+//
+//     Meters distance = simpson(make_span(velocity), Seconds(0.01f));
+//     auto acceleration = gradient(make_span(velocity), Seconds(0.01f));  // Meters_Second2
+
+template <typename Y, typename X>
+using IntegralUnit = decltype(std::declval<Y>() * std::declval<X>());
+
+template <typename Y, typename X>
+using DerivativeUnit = decltype(std::declval<Y>() / std::declval<X>());
+
+namespace detail
+{
+	// Sum f(i) over [begin, end) in independent lanes
+	template <typename Z, typename F>
+	Z lane_sum(std::size_t begin, std::size_t end, F f)
+	{
+		Z lanes[accumulator_lanes] = {};
+		std::size_t i = begin;
+		for (; i + accumulator_lanes <= end; i += accumulator_lanes)
+			for (std::size_t l = 0; l < accumulator_lanes; ++l)
+				lanes[l] += f(i + l);
+		Z sum = 0;
+		for (; i < end; ++i)
+			sum += f(i);
+		for (std::size_t l = 0; l < accumulator_lanes; ++l)
+			sum += lanes[l];
+		return sum;
+	}
+
+	// Factors taking y (in B) times or over x (in Bx) to the result base BR
+	template <typename Z, typename B, typename Bx, typename BR>
+	constexpr Z product_factor() { return conversion_factor<Z, B, BR>() * conversion_factor<Z, Bx, BR>(); }
+
+	template <typename Z, typename B, typename Bx, typename BR>
+	constexpr Z quotient_factor() { return conversion_factor<Z, B, BR>() / conversion_factor<Z, Bx, BR>(); }
+}
+
+// Trapezoid rule
+
+template <typename T, typename B, typename X, typename Bx,
+          typename R = IntegralUnit<Unit<std::remove_const_t<T>,B>, Unit<X,Bx>>>
+R trapezoid(UnitSpan<T,B> y, const Unit<X,Bx>& dx)
+{
+	using Z = typename R::rep;
+	const std::size_t n = y.size();
+	if (n < 2) return R(0);
+
+	const T* v = y.values();
+	const Z inner = detail::lane_sum<Z>(1, n - 1, [v](std::size_t i) { return static_cast<Z>(v[i]); });
+	const Z h = static_cast<Z>(dx.value()) * detail::product_factor<Z, B, Bx, typename R::base>();
+	return R(h * (inner + (static_cast<Z>(v[0]) + static_cast<Z>(v[n - 1])) / 2));
+}
+
+template <typename T, typename B, typename X, typename Bx,
+          typename R = IntegralUnit<Unit<std::remove_const_t<T>,B>, Unit<std::remove_const_t<X>,Bx>>>
+R trapezoid(UnitSpan<T,B> y, UnitSpan<X,Bx> x)
+{
+	using Z = typename R::rep;
+	assert(y.size() == x.size());
+	const std::size_t n = y.size();
+	if (n < 2) return R(0);
+
+	const T* v = y.values();
+	const X* t = x.values();
+	const Z sum = detail::lane_sum<Z>(0, n - 1, [v, t](std::size_t i) {
+		return (static_cast<Z>(v[i]) + static_cast<Z>(v[i + 1])) * static_cast<Z>(t[i + 1] - t[i]);
+	});
+	return R(sum * detail::product_factor<Z, B, Bx, typename R::base>() / 2);
+}
+
+// Composite Simpson's rule. With an odd number of intervals the last is integrated from a
+// parabola through the last three points, as in SciPy
+
+template <typename T, typename B, typename X, typename Bx,
+          typename R = IntegralUnit<Unit<std::remove_const_t<T>,B>, Unit<X,Bx>>>
+R simpson(UnitSpan<T,B> y, const Unit<X,Bx>& dx)
+{
+	using Z = typename R::rep;
+	const std::size_t n = y.size();
+	if (n < 3) return trapezoid(y, dx);
+
+	const T* v = y.values();
+	const Z h = static_cast<Z>(dx.value()) * detail::product_factor<Z, B, Bx, typename R::base>();
+	const std::size_t m = (n - 1) / 2;  // pairs of intervals
+	const Z sum = detail::lane_sum<Z>(0, m, [v](std::size_t j) {
+		return static_cast<Z>(v[2 * j]) + 4 * static_cast<Z>(v[2 * j + 1]) + static_cast<Z>(v[2 * j + 2]);
+	});
+	Z result = h * sum / 3;
+	if (n % 2 == 0)
+		result += h * (5 * static_cast<Z>(v[n - 1]) + 8 * static_cast<Z>(v[n - 2]) - static_cast<Z>(v[n - 3])) / 12;
+	return R(result);
+}
+
+template <typename T, typename B, typename X, typename Bx,
+          typename R = IntegralUnit<Unit<std::remove_const_t<T>,B>, Unit<std::remove_const_t<X>,Bx>>>
+R simpson(UnitSpan<T,B> y, UnitSpan<X,Bx> x)
+{
+	using Z = typename R::rep;
+	assert(y.size() == x.size());
+	const std::size_t n = y.size();
+	if (n < 3) return trapezoid(y, x);
+
+	const T* v = y.values();
+	const X* t = x.values();
+	const std::size_t m = (n - 1) / 2;
+	const Z sum = detail::lane_sum<Z>(0, m, [v, t](std::size_t j) {
+		const std::size_t i = 2 * j;
+		const Z h0 = static_cast<Z>(t[i + 1] - t[i]);
+		const Z h1 = static_cast<Z>(t[i + 2] - t[i + 1]);
+		const Z hs = h0 + h1;
+		return hs / 6 * ((2 - h1 / h0) * static_cast<Z>(v[i])
+		               + hs * hs / (h0 * h1) * static_cast<Z>(v[i + 1])
+		               + (2 - h0 / h1) * static_cast<Z>(v[i + 2]));
+	});
+	Z result = sum;
+	if (n % 2 == 0) {
+		const Z h0 = static_cast<Z>(t[n - 2] - t[n - 3]);
+		const Z h1 = static_cast<Z>(t[n - 1] - t[n - 2]);
+		result += (2 * h1 * h1 + 3 * h0 * h1) / (6 * (h0 + h1)) * static_cast<Z>(v[n - 1])
+		        + (h1 * h1 + 3 * h0 * h1) / (6 * h0) * static_cast<Z>(v[n - 2])
+		        - h1 * h1 * h1 / (6 * h0 * (h0 + h1)) * static_cast<Z>(v[n - 3]);
+	}
+	return R(result * detail::product_factor<Z, B, Bx, typename R::base>());
+}
+
+// Romberg integration: Richardson extrapolation of the trapezoid rule at steps dx, 2 dx, 4 dx, ...
+// The number of samples must be 2^k + 1
+
+template <typename T, typename B, typename X, typename Bx,
+          typename R = IntegralUnit<Unit<std::remove_const_t<T>,B>, Unit<X,Bx>>>
+R romberg(UnitSpan<T,B> y, const Unit<X,Bx>& dx)
+{
+	using Z = typename R::rep;
+	const std::size_t n = y.size();
+	if (n < 2) return R(0);
+	const std::size_t intervals = n - 1;
+	assert((intervals & (intervals - 1)) == 0);
+
+	int k = 0;
+	while ((std::size_t(1) << k) < intervals) ++k;
+
+	// Trapezoid estimates from the coarsest step (the whole range) down, each reusing the last
+	const T* v = y.values();
+	const Z h = static_cast<Z>(dx.value()) * detail::product_factor<Z, B, Bx, typename R::base>();
+	Z table[64] = {};
+	Z step = h * static_cast<Z>(intervals);
+	table[0] = step * (static_cast<Z>(v[0]) + static_cast<Z>(v[n - 1])) / 2;
+	for (int level = 1; level <= k; ++level) {
+		const std::size_t stride = intervals >> level;
+		const Z midpoints = detail::lane_sum<Z>(0, std::size_t(1) << (level - 1), [v, stride](std::size_t j) {
+			return static_cast<Z>(v[(2 * j + 1) * stride]);
+		});
+		step /= 2;
+		Z previous = table[0];
+		table[0] = table[0] / 2 + step * midpoints;
+		Z factor = 1;
+		for (int j = 1; j <= level; ++j) {
+			factor *= 4;
+			const Z current = table[j - 1] + (table[j - 1] - previous) / (factor - 1);
+			previous = table[j];
+			table[j] = current;
+		}
+	}
+	return R(table[k]);
+}
+
+// Central differences in the interior, and one-sided differences at the ends, as numpy.gradient
+
+template <typename T, typename B, typename X, typename Bx, typename Z, typename B3>
+void gradient(UnitSpan<T,B> y, const Unit<X,Bx>& dx, UnitSpan<Z,B3> out)
+{
+	using R = DerivativeUnit<Unit<std::remove_const_t<T>,B>, Unit<X,Bx>>;
+	using D = AddType<typename R::base::dim, typename B3::dim>;
+	assert(y.size() == out.size());
+	const std::size_t n = y.size();
+	if (n == 0) return;
+	if (n == 1) {
+		out[0] = Unit<Z,B3>(0);
+		return;
+	}
+
+	const Z k = detail::quotient_factor<Z, B, Bx, typename R::base>() * conversion_factor<Z, typename R::base, B3, D>()
+	          / static_cast<Z>(dx.value());
+	const T* v = y.values();
+	Z* g = out.values();
+	const Z half = k / 2;
+	for (std::size_t i = 1; i + 1 < n; ++i)
+		g[i] = (static_cast<Z>(v[i + 1]) - static_cast<Z>(v[i - 1])) * half;
+	g[0] = (static_cast<Z>(v[1]) - static_cast<Z>(v[0])) * k;
+	g[n - 1] = (static_cast<Z>(v[n - 1]) - static_cast<Z>(v[n - 2])) * k;
+}
+
+// The second-order accurate central difference for uneven spacing
+template <typename T, typename B, typename X, typename Bx, typename Z, typename B3>
+void gradient(UnitSpan<T,B> y, UnitSpan<X,Bx> x, UnitSpan<Z,B3> out)
+{
+	using R = DerivativeUnit<Unit<std::remove_const_t<T>,B>, Unit<std::remove_const_t<X>,Bx>>;
+	using D = AddType<typename R::base::dim, typename B3::dim>;
+	assert(y.size() == x.size() && y.size() == out.size());
+	const std::size_t n = y.size();
+	if (n == 0) return;
+	if (n == 1) {
+		out[0] = Unit<Z,B3>(0);
+		return;
+	}
+
+	const Z k = detail::quotient_factor<Z, B, Bx, typename R::base>() * conversion_factor<Z, typename R::base, B3, D>();
+	const T* v = y.values();
+	const X* t = x.values();
+	Z* g = out.values();
+	for (std::size_t i = 1; i + 1 < n; ++i) {
+		const Z hd = static_cast<Z>(t[i] - t[i - 1]);
+		const Z hs = static_cast<Z>(t[i + 1] - t[i]);
+		g[i] = k * (hd * hd * static_cast<Z>(v[i + 1]) + (hs * hs - hd * hd) * static_cast<Z>(v[i]) - hs * hs * static_cast<Z>(v[i - 1]))
+		     / (hs * hd * (hd + hs));
+	}
+	g[0] = k * (static_cast<Z>(v[1]) - static_cast<Z>(v[0])) / static_cast<Z>(t[1] - t[0]);
+	g[n - 1] = k * (static_cast<Z>(v[n - 1]) - static_cast<Z>(v[n - 2])) / static_cast<Z>(t[n - 1] - t[n - 2]);
+}
+
+template <typename T, typename B, typename X, typename Bx,
+          typename R = DerivativeUnit<Unit<std::remove_const_t<T>,B>, Unit<X,Bx>>>
+UnitArray<typename R::rep, typename R::base> gradient(UnitSpan<T,B> y, const Unit<X,Bx>& dx)
+{
+	UnitArray<typename R::rep, typename R::base> out(y.size());
+	gradient(y, dx, make_span(out));
+	return out;
+}
+
+template <typename T, typename B, typename X, typename Bx,
+          typename R = DerivativeUnit<Unit<std::remove_const_t<T>,B>, Unit<std::remove_const_t<X>,Bx>>>
+UnitArray<typename R::rep, typename R::base> gradient(UnitSpan<T,B> y, UnitSpan<X,Bx> x)
+{
+	UnitArray<typename R::rep, typename R::base> out(y.size());
+	gradient(y, x, make_span(out));
+	return out;
+}
+
+} // sunit
@@ -0,0 +1,114 @@
+#include "simpleunit/Calculus.h"
+#include <cmath>
+#include "gtest/gtest.h"
+
+using namespace std;
+using namespace sunit;
+
+TEST(CalculusTest, Integrals)
+{
+	using namespace si;
+
+	// v = t^2 m/s over [0, 2] s, sampled every 1/8 s: 8/3 m
+	const std::size_t n = 17;
+	UnitArray<double, Velocity<meter, second>> v(n);
+	UnitArray<double, Time<second>> t(n);
+	for (std::size_t i = 0; i < n; ++i) {
+		const double s = i / 8.0;
+		t[i] = Unit<double, Time<second>>(s);
+		v[i] = Unit<double, Velocity<meter, second>>(s * s);
+	}
+	const Unit<double, Time<second>> dt(1 / 8.0);
+
+	auto trap = trapezoid(make_span(v), dt);
+	EXPECT_EQ(1, (std::is_same<Unit<double, Length<meter>>, decltype(trap)>::value));
+	EXPECT_NEAR(8 / 3.0, trap.value(), 0.01);
+	EXPECT_DOUBLE_EQ(trap.value(), trapezoid(make_span(v), make_span(t)).value());
+
+	// Simpson's rule and Romberg are exact for a quadratic
+	EXPECT_DOUBLE_EQ(8 / 3.0, simpson(make_span(v), dt).value());
+	EXPECT_DOUBLE_EQ(8 / 3.0, simpson(make_span(v), make_span(t)).value());
+	EXPECT_DOUBLE_EQ(8 / 3.0, romberg(make_span(v), dt).value());
+
+	// An odd number of intervals: [0, 15/8] s
+	auto odd = make_span(v).subspan(0, n - 1);
+	const double expected = std::pow(15 / 8.0, 3) / 3;
+	EXPECT_DOUBLE_EQ(expected, simpson(odd, dt).value());
+	EXPECT_DOUBLE_EQ(expected, simpson(odd, make_span(t).subspan(0, n - 1)).value());
+
+	// Steps in minutes are converted
+	auto minutes = trapezoid(make_span(v), Unit<double, Time<minute>>(1));
+	EXPECT_EQ(1, (std::is_same<Unit<double, Length<meter>>, decltype(minutes)>::value));
+	EXPECT_DOUBLE_EQ(trap.value() * 8 * 60, minutes.value());
+}
+
+TEST(CalculusTest, Romberg)
+{
+	using namespace si;
+
+	// sin over [0, pi] is 2: Romberg's extrapolation converges far faster than its trapezoid rule
+	const std::size_t n = 33;
+	const double pi = std::acos(-1.0);
+	UnitArray<double, Length<meter>> y(n);
+	for (std::size_t i = 0; i < n; ++i)
+		y[i] = Unit<double, Length<meter>>(std::sin(pi * i / (n - 1)));
+	const Unit<double, Length<meter>> dx(pi / (n - 1));
+
+	EXPECT_GT(std::abs(trapezoid(make_span(y), dx).value() - 2), 1e-3);
+	EXPECT_NEAR(2, romberg(make_span(y), dx).value(), 1e-10);
+}
+
+TEST(CalculusTest, IrregularSimpson)
+{
+	using namespace si;
+
+	// y = x^2 on uneven points, integrated exactly
+	UnitArray<double, Length<meter>> x = {Unit<double, Length<meter>>(0), Unit<double, Length<meter>>(0.5),
+	                                      Unit<double, Length<meter>>(2), Unit<double, Length<meter>>(2.25),
+	                                      Unit<double, Length<meter>>(3)};
+	UnitArray<double, Length<meter>> y(x.size());
+	for (std::size_t i = 0; i < x.size(); ++i)
+		y[i] = Unit<double, Length<meter>>(x[i].value() * x[i].value());
+
+	auto area = simpson(make_span(y), make_span(x));
+	EXPECT_EQ(1, (std::is_same<Unit<double, Length2<meter>>, decltype(area)>::value));
+	EXPECT_DOUBLE_EQ(9, area.value());
+}
+
+TEST(CalculusTest, Gradient)
+{
+	using namespace si;
+
+	// x = t^2 m, so v = 2t m/s; central differences are exact for a quadratic
+	const std::size_t n = 100;
+	UnitArray<float, Length<meter>> x(n);
+	UnitArray<float, Time<second>> t(n);
+	for (std::size_t i = 0; i < n; ++i) {
+		t[i] = Seconds(0.1f * i);
+		x[i] = Meters(t[i].value() * t[i].value());
+	}
+
+	auto v = gradient(make_span(x), Seconds(0.1f));
+	EXPECT_EQ(1, (std::is_same<Meters_Second, decltype(v)::value_type>::value));
+	for (std::size_t i = 1; i + 1 < n; ++i)
+		ASSERT_NEAR(2 * t[i].value(), v[i].value(), 1e-3);
+	EXPECT_NEAR(0.1f, v[0].value(), 1e-5);
+
+	// Twice gives the acceleration
+	auto a = gradient(make_span(v), Seconds(0.1f));
+	EXPECT_EQ(1, (std::is_same<Meters_Second2, decltype(a)::value_type>::value));
+	EXPECT_NEAR(2, a[n / 2].value(), 1e-3);
+
+	// Irregular spacing, into a span of another scale
+	UnitArray<float, Time<second>> ti = {Seconds(0), Seconds(1), Seconds(3), Seconds(3.5f)};
+	UnitArray<float, Length<meter>> xi(ti.size());
+	for (std::size_t i = 0; i < ti.size(); ++i)
+		xi[i] = Meters(ti[i].value() * ti[i].value());
+	UnitArray<float, Velocity<std::centi, second>> vi(ti.size());
+	gradient(make_span(xi), make_span(ti), make_span(vi));
+	EXPECT_FLOAT_EQ(200, vi[1].value());
+	EXPECT_FLOAT_EQ(600, vi[2].value());
+
+	//UnitArray<float, Length<meter>> bad(n);
+	//gradient(make_span(x), Seconds(0.1f), make_span(bad));  // Should not compile
+}
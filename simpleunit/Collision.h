@@ -0,0 +1,378 @@
+#pragma once
+
+#include "simpleunit/Parallel.h"
+#include "simpleunit/UnitSpan.h"
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace sunit {
+namespace spatial {
+
+// Overlap tests between axis-aligned boxes and spheres with typed extents. Sets of boxes or
+// spheres are kept as one array per axis in a single length unit. Columns in other units are
+// converted as a set is built, by the factor unit_cast works out at compile time, and single
+// query shapes are converted once per query:
+//
+//     AabbSet<3, float, Length<meter>> parts(lo_mm, hi_mm);         // columns in Millimeters
+//     auto hits = overlapping(Aabb<3, float, Length<meter>>{lo, hi}, parts);
+//     auto pairs = sweep_and_prune(parts);                          // broad phase, i < j
+//
+// Boxes are closed: boxes that touch overlap.
+
+template <std::size_t N, typename T, typename B>
+struct Aabb
+{
+	std::array<Unit<T,B>, N> lo;
+	std::array<Unit<T,B>, N> hi;
+};
+
+template <std::size_t N, typename T, typename B>
+struct Sphere
+{
+	std::array<Unit<T,B>, N> centre;
+	Unit<T,B> radius;
+};
+
+namespace detail
+{
+	template <typename U, typename X, typename Bx>
+	typename U::rep extent_value(const Unit<X,Bx>& x)
+	{
+		static_assert(std::is_same<typename Bx::dim, typename U::base::dim>::value, "extents are lengths");
+		return unit_cast<U>(x).value();
+	}
+
+	template <typename U, typename X, typename Bx>
+	void convert_extents(UnitSpan<X,Bx> in, std::vector<typename U::rep>& out)
+	{
+		out.resize(in.size());
+		std::transform(in.begin(), in.end(), out.begin(),
+		               [](const Unit<std::remove_const_t<X>,Bx>& x) { return extent_value<U>(x); });
+	}
+
+	// Indices of the flags set, appended to out, a block at a time
+	template <typename F>
+	void collect(std::size_t n, F hit, std::vector<std::uint32_t>& out)
+	{
+		const std::size_t block = 1024;
+		std::uint32_t sel[block];
+		for (std::size_t b = 0; b < n; b += block) {
+			const std::size_t m = std::min(block, n - b);
+			std::size_t k = 0;
+			for (std::size_t i = 0; i < m; ++i) {
+				sel[k] = static_cast<std::uint32_t>(b + i);
+				k += hit(b + i);
+			}
+			out.insert(out.end(), sel, sel + k);
+		}
+	}
+}
+
+// Boxes, as arrays of lower and upper bounds per axis
+template <std::size_t N, typename T, typename B>
+class AabbSet
+{
+public:
+	using length = Unit<T,B>;
+	using box = Aabb<N,T,B>;
+
+	AabbSet() = default;
+
+	// From columns of lower and upper bounds, all in one unit
+	template <typename X, typename Bx>
+	AabbSet(const std::array<UnitSpan<X,Bx>, N>& lo, const std::array<UnitSpan<X,Bx>, N>& hi)
+	{
+		for (std::size_t d = 0; d < N; ++d) {
+			assert(lo[d].size() == lo[0].size() && hi[d].size() == lo[0].size());
+			detail::convert_extents<length>(lo[d], lo_[d]);
+			detail::convert_extents<length>(hi[d], hi_[d]);
+		}
+	}
+
+	std::size_t size() const { return lo_[0].size(); }
+
+	void push_back(const box& b)
+	{
+		for (std::size_t d = 0; d < N; ++d) {
+			lo_[d].push_back(b.lo[d].value());
+			hi_[d].push_back(b.hi[d].value());
+		}
+	}
+
+	box operator[](std::size_t i) const
+	{
+		box b;
+		for (std::size_t d = 0; d < N; ++d) {
+			b.lo[d] = length(lo_[d][i]);
+			b.hi[d] = length(hi_[d][i]);
+		}
+		return b;
+	}
+
+	const T* lo(std::size_t axis) const { return lo_[axis].data(); }
+	const T* hi(std::size_t axis) const { return hi_[axis].data(); }
+
+private:
+	std::array<std::vector<T>, N> lo_;
+	std::array<std::vector<T>, N> hi_;
+};
+
+// Spheres, as arrays of centre coordinates per axis and of radii
+template <std::size_t N, typename T, typename B>
+class SphereSet
+{
+public:
+	using length = Unit<T,B>;
+	using sphere = Sphere<N,T,B>;
+
+	SphereSet() = default;
+
+	template <typename X, typename Bx>
+	SphereSet(const std::array<UnitSpan<X,Bx>, N>& centres, UnitSpan<X,Bx> radii)
+	{
+		for (std::size_t d = 0; d < N; ++d) {
+			assert(centres[d].size() == radii.size());
+			detail::convert_extents<length>(centres[d], centre_[d]);
+		}
+		detail::convert_extents<length>(radii, radius_);
+	}
+
+	std::size_t size() const { return radius_.size(); }
+
+	void push_back(const sphere& s)
+	{
+		for (std::size_t d = 0; d < N; ++d)
+			centre_[d].push_back(s.centre[d].value());
+		radius_.push_back(s.radius.value());
+	}
+
+	sphere operator[](std::size_t i) const
+	{
+		sphere s;
+		for (std::size_t d = 0; d < N; ++d)
+			s.centre[d] = length(centre_[d][i]);
+		s.radius = length(radius_[i]);
+		return s;
+	}
+
+	const T* centre(std::size_t axis) const { return centre_[axis].data(); }
+	const T* radius() const { return radius_.data(); }
+
+	// Bounding boxes, for the broad phase
+	AabbSet<N,T,B> bounds() const
+	{
+		AabbSet<N,T,B> out;
+		for (std::size_t i = 0; i < size(); ++i) {
+			Aabb<N,T,B> b;
+			for (std::size_t d = 0; d < N; ++d) {
+				b.lo[d] = length(centre_[d][i] - radius_[i]);
+				b.hi[d] = length(centre_[d][i] + radius_[i]);
+			}
+			out.push_back(b);
+		}
+		return out;
+	}
+
+private:
+	std::array<std::vector<T>, N> centre_;
+	std::vector<T> radius_;
+};
+
+// Indices of the boxes of a set overlapping a box
+template <std::size_t N, typename X, typename Bx, typename T, typename B>
+std::vector<std::uint32_t> overlapping(const Aabb<N,X,Bx>& q, const AabbSet<N,T,B>& set)
+{
+	using L = Unit<T,B>;
+	std::array<T, N> qlo, qhi;
+	std::array<const T*, N> lo, hi;
+	for (std::size_t d = 0; d < N; ++d) {
+		qlo[d] = detail::extent_value<L>(q.lo[d]);
+		qhi[d] = detail::extent_value<L>(q.hi[d]);
+		lo[d] = set.lo(d);
+		hi[d] = set.hi(d);
+	}
+	std::vector<std::uint32_t> out;
+	detail::collect(set.size(), [&](std::size_t i) {
+		bool hit = true;
+		for (std::size_t d = 0; d < N; ++d)
+			hit &= (lo[d][i] <= qhi[d]) & (qlo[d] <= hi[d][i]);
+		return hit;
+	}, out);
+	return out;
+}
+
+// Indices of the boxes of a set overlapping a sphere: those whose nearest point to the centre is
+// within the radius
+template <std::size_t N, typename X, typename Bx, typename T, typename B>
+std::vector<std::uint32_t> overlapping(const Sphere<N,X,Bx>& q, const AabbSet<N,T,B>& set)
+{
+	using L = Unit<T,B>;
+	std::array<T, N> c;
+	std::array<const T*, N> lo, hi;
+	for (std::size_t d = 0; d < N; ++d) {
+		c[d] = detail::extent_value<L>(q.centre[d]);
+		lo[d] = set.lo(d);
+		hi[d] = set.hi(d);
+	}
+	const T r = detail::extent_value<L>(q.radius);
+	std::vector<std::uint32_t> out;
+	detail::collect(set.size(), [&](std::size_t i) {
+		T d2 = 0;
+		for (std::size_t d = 0; d < N; ++d) {
+			const T t = c[d] - std::min(std::max(c[d], lo[d][i]), hi[d][i]);
+			d2 += t * t;
+		}
+		return d2 <= r * r;
+	}, out);
+	return out;
+}
+
+// Indices of the spheres of a set overlapping a sphere
+template <std::size_t N, typename X, typename Bx, typename T, typename B>
+std::vector<std::uint32_t> overlapping(const Sphere<N,X,Bx>& q, const SphereSet<N,T,B>& set)
+{
+	using L = Unit<T,B>;
+	std::array<T, N> c;
+	std::array<const T*, N> x;
+	for (std::size_t d = 0; d < N; ++d) {
+		c[d] = detail::extent_value<L>(q.centre[d]);
+		x[d] = set.centre(d);
+	}
+	const T r = detail::extent_value<L>(q.radius);
+	const T* radius = set.radius();
+	std::vector<std::uint32_t> out;
+	detail::collect(set.size(), [&](std::size_t i) {
+		T d2 = 0;
+		for (std::size_t d = 0; d < N; ++d) {
+			const T t = x[d][i] - c[d];
+			d2 += t * t;
+		}
+		const T s = r + radius[i];
+		return d2 <= s * s;
+	}, out);
+	return out;
+}
+
+namespace detail
+{
+	// The axis along which box centres spread most, to sweep along
+	template <std::size_t N, typename T, typename B>
+	std::size_t sweep_axis(const AabbSet<N,T,B>& set)
+	{
+		std::size_t best = 0;
+		double best_variance = -1;
+		for (std::size_t d = 0; d < N; ++d) {
+			double sum = 0, sum2 = 0;
+			for (std::size_t i = 0; i < set.size(); ++i) {
+				const double c = 0.5 * (double(set.lo(d)[i]) + double(set.hi(d)[i]));
+				sum += c;
+				sum2 += c * c;
+			}
+			const double n = double(std::max<std::size_t>(set.size(), 1));
+			const double variance = sum2 / n - (sum / n) * (sum / n);
+			if (variance > best_variance) {
+				best = d;
+				best_variance = variance;
+			}
+		}
+		return best;
+	}
+
+	// Indices of a set sorted by lower bound on an axis, with the sorted lower bounds
+	template <std::size_t N, typename T, typename B>
+	std::vector<std::uint32_t> sort_by_lo(const AabbSet<N,T,B>& set, std::size_t axis, std::vector<T>& sorted_lo)
+	{
+		std::vector<std::uint32_t> order(set.size());
+		for (std::size_t i = 0; i < order.size(); ++i)
+			order[i] = static_cast<std::uint32_t>(i);
+		const T* lo = set.lo(axis);
+		std::sort(order.begin(), order.end(), [lo](std::uint32_t a, std::uint32_t b) { return lo[a] < lo[b]; });
+		sorted_lo.resize(order.size());
+		for (std::size_t i = 0; i < order.size(); ++i)
+			sorted_lo[i] = lo[order[i]];
+		return order;
+	}
+
+	template <std::size_t N, typename T, typename B>
+	bool overlap_except(const AabbSet<N,T,B>& a, std::size_t i, const AabbSet<N,T,B>& b, std::size_t j, std::size_t axis)
+	{
+		bool hit = true;
+		for (std::size_t d = 0; d < N; ++d)
+			if (d != axis)
+				hit &= (a.lo(d)[i] <= b.hi(d)[j]) & (b.lo(d)[j] <= a.hi(d)[i]);
+		return hit;
+	}
+
+	// Overlapping pairs (i in a, j in b) where j's lower bound along the axis lies in [lo, hi] of i,
+	// or in (lo, hi] if strict, found by scanning b sorted by lower bound, in parallel over a
+	template <std::size_t N, typename T, typename B>
+	void sweep(const AabbSet<N,T,B>& a, const std::vector<std::uint32_t>& a_order,
+	           const AabbSet<N,T,B>& b, const std::vector<std::uint32_t>& b_order, const std::vector<T>& b_lo,
+	           std::size_t axis, bool strict, bool self, bool swap,
+	           std::vector<std::pair<std::uint32_t, std::uint32_t>>& out, const parallel::Options& options)
+	{
+		const std::size_t grain = 4096;
+		std::vector<std::vector<std::pair<std::uint32_t, std::uint32_t>>> parts((a.size() + grain - 1) / grain);
+		parallel::for_range(parts.size(), 1, [&](std::size_t p0, std::size_t p1) {
+			for (std::size_t p = p0; p < p1; ++p)
+				for (std::size_t s = p * grain; s < std::min(a.size(), (p + 1) * grain); ++s) {
+					const std::uint32_t i = a_order[s];
+					const T lo = a.lo(axis)[i], hi = a.hi(axis)[i];
+					// A set against itself scans only the boxes after this one in the order
+					std::size_t k = self ? s + 1
+					              : strict ? std::upper_bound(b_lo.begin(), b_lo.end(), lo) - b_lo.begin()
+					                       : std::lower_bound(b_lo.begin(), b_lo.end(), lo) - b_lo.begin();
+					for (; k < b_lo.size() && b_lo[k] <= hi; ++k) {
+						const std::uint32_t j = b_order[k];
+						if (overlap_except(a, i, b, j, axis))
+							parts[p].push_back(swap ? std::make_pair(j, i) : std::make_pair(i, j));
+					}
+				}
+		}, options);
+		for (const auto& part : parts)
+			out.insert(out.end(), part.begin(), part.end());
+	}
+}
+
+// Pairs of overlapping boxes (i, j) with i < j, by sweep and prune: boxes are sorted along the axis
+// their centres spread most, and each compared only with those starting before it ends
+template <std::size_t N, typename T, typename B>
+std::vector<std::pair<std::uint32_t, std::uint32_t>> sweep_and_prune(const AabbSet<N,T,B>& set,
+                                                                       const parallel::Options& options = parallel::Options())
+{
+	assert(set.size() <= std::numeric_limits<std::uint32_t>::max());
+	const std::size_t axis = detail::sweep_axis(set);
+	std::vector<T> lo;
+	const std::vector<std::uint32_t> order = detail::sort_by_lo(set, axis, lo);
+	std::vector<std::pair<std::uint32_t, std::uint32_t>> out;
+	detail::sweep(set, order, set, order, lo, axis, false, true, false, out, options);
+	for (auto& p : out)
+		if (p.first > p.second) std::swap(p.first, p.second);
+	return out;
+}
+
+// Pairs of overlapping boxes (i in a, j in b)
+template <std::size_t N, typename T, typename B>
+std::vector<std::pair<std::uint32_t, std::uint32_t>> sweep_and_prune(const AabbSet<N,T,B>& a, const AabbSet<N,T,B>& b,
+                                                                       const parallel::Options& options = parallel::Options())
+{
+	assert(a.size() <= std::numeric_limits<std::uint32_t>::max() && b.size() <= std::numeric_limits<std::uint32_t>::max());
+	const std::size_t axis = detail::sweep_axis(a);
+	std::vector<T> a_lo, b_lo;
+	const std::vector<std::uint32_t> a_order = detail::sort_by_lo(a, axis, a_lo);
+	const std::vector<std::uint32_t> b_order = detail::sort_by_lo(b, axis, b_lo);
+	// Pairs where b starts within a, then where a starts strictly within b
+	std::vector<std::pair<std::uint32_t, std::uint32_t>> out;
+	detail::sweep(a, a_order, b, b_order, b_lo, axis, false, false, false, out, options);
+	detail::sweep(b, b_order, a, a_order, a_lo, axis, true, false, true, out, options);
+	return out;
+}
+
+} // spatial
+} // sunit
@@ -0,0 +1,145 @@
+#include "simpleunit/Collision.h"
+#include <algorithm>
+#include <random>
+#include "gtest/gtest.h"
+
+using namespace std;
+using namespace sunit;
+using namespace sunit::spatial;
+
+namespace
+{
+	using Millimeters = Unit<float, Length<std::milli>>;
+	using Box = Aabb<3, float, Length<si::meter>>;
+	using Boxes = AabbSet<3, float, Length<si::meter>>;
+	using Ball = Sphere<3, float, Length<si::meter>>;
+	using Balls = SphereSet<3, float, Length<si::meter>>;
+
+	Boxes boxes(size_t n, unsigned seed, float extent = 0.05f)
+	{
+		mt19937 rng(seed);
+		uniform_real_distribution<float> u(0, 1), e(0, extent);
+		Boxes out;
+		for (size_t i = 0; i < n; ++i) {
+			Box b;
+			for (size_t d = 0; d < 3; ++d) {
+				b.lo[d] = si::Meters(u(rng));
+				b.hi[d] = si::Meters(b.lo[d].value() + e(rng));
+			}
+			out.push_back(b);
+		}
+		return out;
+	}
+
+	bool overlap(const Box& a, const Box& b)
+	{
+		for (size_t d = 0; d < 3; ++d)
+			if (a.lo[d].value() > b.hi[d].value() || b.lo[d].value() > a.hi[d].value())
+				return false;
+		return true;
+	}
+
+	using Pairs = vector<pair<uint32_t, uint32_t>>;
+}
+
+TEST(CollisionTest, ColumnsInMillimeters)
+{
+	UnitArray<float, Length<std::milli>> lx, ly, lz, hx, hy, hz;
+	for (int i = 0; i < 10; ++i) {
+		lx.push_back(Millimeters(100.f * i)); hx.push_back(Millimeters(100.f * i + 50));
+		ly.push_back(Millimeters(0)); hy.push_back(Millimeters(10));
+		lz.push_back(Millimeters(0)); hz.push_back(Millimeters(10));
+	}
+	using Column = UnitSpan<float, Length<std::milli>>;
+	const array<Column, 3> lo = {{make_span(lx), make_span(ly), make_span(lz)}};
+	const array<Column, 3> hi = {{make_span(hx), make_span(hy), make_span(hz)}};
+	const Boxes set(lo, hi);
+	ASSERT_EQ(10u, set.size());
+	EXPECT_FLOAT_EQ(0.3f, set[3].lo[0].value());
+	EXPECT_FLOAT_EQ(0.35f, set[3].hi[0].value());
+
+	// A query in millimetres touching box 3 and overlapping box 4
+	const Aabb<3, float, Length<std::milli>> q = {{{Millimeters(350), Millimeters(5), Millimeters(5)}},
+	                                              {{Millimeters(420), Millimeters(6), Millimeters(6)}}};
+	EXPECT_EQ((vector<uint32_t>{3, 4}), overlapping(q, set));
+}
+
+TEST(CollisionTest, BoxQuery)
+{
+	const Boxes set = boxes(5000, 1);
+	const Box q = {{{si::Meters(0.2f), si::Meters(0.3f), si::Meters(0.4f)}}, {{si::Meters(0.4f), si::Meters(0.5f), si::Meters(0.6f)}}};
+	vector<uint32_t> expected;
+	for (size_t i = 0; i < set.size(); ++i)
+		if (overlap(q, set[i])) expected.push_back(uint32_t(i));
+	EXPECT_FALSE(expected.empty());
+	EXPECT_EQ(expected, overlapping(q, set));
+}
+
+TEST(CollisionTest, SphereQueries)
+{
+	const Boxes set = boxes(3000, 2);
+	const Ball q = {{{si::Meters(0.5f), si::Meters(0.5f), si::Meters(0.5f)}}, si::Meters(0.2f)};
+	vector<uint32_t> expected;
+	for (size_t i = 0; i < set.size(); ++i) {
+		const Box b = set[i];
+		float d2 = 0;
+		for (size_t d = 0; d < 3; ++d) {
+			const float c = q.centre[d].value();
+			const float t = c < b.lo[d].value() ? b.lo[d].value() - c : c > b.hi[d].value() ? c - b.hi[d].value() : 0;
+			d2 += t * t;
+		}
+		if (d2 <= 0.04f) expected.push_back(uint32_t(i));
+	}
+	EXPECT_FALSE(expected.empty());
+	EXPECT_EQ(expected, overlapping(q, set));
+
+	Balls balls;
+	balls.push_back({{{si::Meters(0), si::Meters(0), si::Meters(0)}}, si::Meters(1)});
+	balls.push_back({{{si::Meters(3), si::Meters(0), si::Meters(0)}}, si::Meters(1)});
+	balls.push_back({{{si::Meters(0), si::Meters(2.9f), si::Meters(0)}}, si::Meters(1)});
+	const Sphere<3, float, Length<std::milli>> probe = {{{Millimeters(0), Millimeters(1500), Millimeters(0)}}, Millimeters(500)};
+	EXPECT_EQ((vector<uint32_t>{0, 2}), overlapping(probe, balls));
+
+	const Boxes bounds = balls.bounds();
+	EXPECT_EQ(2.f, bounds[1].lo[0].value());
+	EXPECT_EQ(4.f, bounds[1].hi[0].value());
+}
+
+TEST(CollisionTest, SweepAndPruneSelf)
+{
+	const Boxes set = boxes(1500, 3, 0.08f);
+	Pairs expected;
+	for (size_t i = 0; i < set.size(); ++i)
+		for (size_t j = i + 1; j < set.size(); ++j)
+			if (overlap(set[i], set[j])) expected.emplace_back(uint32_t(i), uint32_t(j));
+	Pairs found = sweep_and_prune(set);
+	sort(found.begin(), found.end());
+	EXPECT_FALSE(expected.empty());
+	EXPECT_EQ(expected, found);
+}
+
+TEST(CollisionTest, SweepAndPruneTwoSets)
+{
+	const Boxes a = boxes(1000, 4), b = boxes(800, 5, 0.1f);
+	Pairs expected;
+	for (size_t i = 0; i < a.size(); ++i)
+		for (size_t j = 0; j < b.size(); ++j)
+			if (overlap(a[i], b[j])) expected.emplace_back(uint32_t(i), uint32_t(j));
+	Pairs found = sweep_and_prune(a, b);
+	sort(found.begin(), found.end());
+	EXPECT_FALSE(expected.empty());
+	EXPECT_EQ(expected, found);
+}
+
+TEST(CollisionTest, SweepAndPruneTies)
+{
+	// Identical and touching boxes are all reported once
+	Boxes a, b;
+	const Box unit = {{{si::Meters(0), si::Meters(0), si::Meters(0)}}, {{si::Meters(1), si::Meters(1), si::Meters(1)}}};
+	const Box next = {{{si::Meters(1), si::Meters(0), si::Meters(0)}}, {{si::Meters(2), si::Meters(1), si::Meters(1)}}};
+	a.push_back(unit); a.push_back(unit); a.push_back(next);
+	b.push_back(unit); b.push_back(next);
+	EXPECT_EQ(3u, sweep_and_prune(a).size());
+	EXPECT_EQ(6u, sweep_and_prune(a, b).size());
+	EXPECT_TRUE(sweep_and_prune(Boxes()).empty());
+}
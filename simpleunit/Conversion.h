@@ -0,0 +1,341 @@
+#pragma once
+
+#include "simpleunit/DynamicUnit.h"
+#include "simpleunit/UnitSpan.h"
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+
+namespace sunit {
+
+// Conversions between units known only at run time, exact as at compile time. A UnitSignature is
+// the run-time image of a BaseUnit: the exponent and ratio of each dimension. Factors between
+// signatures are computed as reduced rationals, as BaseConversion does with std::ratio, and a
+// ConversionCache memoizes them for signatures seen again and again.
+
+// A rational number in lowest terms, with a positive denominator
+struct RuntimeRatio
+{
+	std::int64_t num = 1;
+	std::int64_t den = 1;
+
+	friend bool operator==(const RuntimeRatio& a, const RuntimeRatio& b) { return a.num == b.num && a.den == b.den; }
+	friend bool operator!=(const RuntimeRatio& a, const RuntimeRatio& b) { return !(a == b); }
+
+	double value() const { return static_cast<double>(num) / static_cast<double>(den); }
+};
+
+namespace detail
+{
+	inline std::int64_t gcd(std::int64_t a, std::int64_t b)
+	{
+		a = a < 0 ? -a : a;
+		b = b < 0 ? -b : b;
+		while (b) {
+			const std::int64_t t = a % b;
+			a = b;
+			b = t;
+		}
+		return a;
+	}
+
+	// a * b, compared in magnitude against the limit for the sign of the result
+	inline std::int64_t checked_mul(std::int64_t a, std::int64_t b)
+	{
+		if (a == 0 || b == 0) return 0;
+		const bool negative = (a < 0) != (b < 0);
+		const std::uint64_t ua = a < 0 ? 0 - static_cast<std::uint64_t>(a) : static_cast<std::uint64_t>(a);
+		const std::uint64_t ub = b < 0 ? 0 - static_cast<std::uint64_t>(b) : static_cast<std::uint64_t>(b);
+		const std::uint64_t limit = static_cast<std::uint64_t>(std::numeric_limits<std::int64_t>::max()) + (negative ? 1 : 0);
+		if (ua > limit / ub)
+			throw std::overflow_error("conversion ratio overflows 64 bits");
+		const std::uint64_t p = ua * ub;
+		if (!negative) return static_cast<std::int64_t>(p);
+		return p == limit ? std::numeric_limits<std::int64_t>::min() : -static_cast<std::int64_t>(p);
+	}
+
+	inline RuntimeRatio make_ratio(std::int64_t num, std::int64_t den)
+	{
+		if (den == 0)
+			throw std::invalid_argument("ratio with zero denominator");
+		if (den < 0) {
+			num = -num;
+			den = -den;
+		}
+		const std::int64_t g = gcd(num, den);
+		return RuntimeRatio{num / g, den / g};
+	}
+
+	// a * b, reducing across before multiplying, as std::ratio_multiply
+	inline RuntimeRatio multiply(const RuntimeRatio& a, const RuntimeRatio& b)
+	{
+		const std::int64_t g1 = gcd(a.num, b.den);
+		const std::int64_t g2 = gcd(b.num, a.den);
+		return RuntimeRatio{checked_mul(a.num / g1, b.num / g2), checked_mul(a.den / g2, b.den / g1)};
+	}
+
+	inline RuntimeRatio power(const RuntimeRatio& r, int exp)
+	{
+		RuntimeRatio base = exp < 0 ? RuntimeRatio{r.den, r.num} : r;
+		RuntimeRatio result;
+		for (int e = exp < 0 ? -exp : exp; e > 0; --e)
+			result = multiply(result, base);
+		return result;
+	}
+}
+
+struct UnitSignature
+{
+	std::int32_t dim[3] = {0, 0, 0};
+	RuntimeRatio ratio[3];
+
+	UnitSignature() = default;
+
+	// Ratios of dimensions with exponent zero make no difference, so are kept as 1
+	UnitSignature(const int (&d)[3], const RuntimeRatio (&r)[3])
+	{
+		for (int i = 0; i < 3; ++i) {
+			dim[i] = d[i];
+			ratio[i] = d[i] == 0 ? RuntimeRatio() : detail::make_ratio(r[i].num, r[i].den);
+		}
+	}
+
+	bool same_dimension(const UnitSignature& rhs) const
+	{
+		return dim[0] == rhs.dim[0] && dim[1] == rhs.dim[1] && dim[2] == rhs.dim[2];
+	}
+
+	friend bool operator==(const UnitSignature& a, const UnitSignature& b)
+	{
+		return a.same_dimension(b) && a.ratio[0] == b.ratio[0] && a.ratio[1] == b.ratio[1] && a.ratio[2] == b.ratio[2];
+	}
+	friend bool operator!=(const UnitSignature& a, const UnitSignature& b) { return !(a == b); }
+};
+
+// The signature of a base unit
+template <typename B>
+UnitSignature signature()
+{
+	using D = typename B::dim;
+	const int dim[3] = {D::d1, D::d2, D::d3};
+	const RuntimeRatio ratio[3] = {{B::r1::num, B::r1::den}, {B::r2::num, B::r2::den}, {B::r3::num, B::r3::den}};
+	return UnitSignature(dim, ratio);
+}
+
+inline DynamicUnit dynamic_unit(const UnitSignature& s)
+{
+	DynamicUnit u;
+	u.scale = 1;
+	for (int i = 0; i < 3; ++i) {
+		u.dim[i] = s.dim[i];
+		u.scale *= std::pow(s.ratio[i].value(), s.dim[i]);
+	}
+	return u;
+}
+
+// The exact factor taking a value in one signature to another, as BaseConversion. Throws
+// std::invalid_argument if the dimensions differ, or std::overflow_error if the factor does not
+// fit in 64-bit integers
+inline RuntimeRatio conversion_ratio(const UnitSignature& from, const UnitSignature& to)
+{
+	if (!from.same_dimension(to))
+		throw std::invalid_argument("incompatible dimensions");
+	RuntimeRatio r;
+	for (int i = 0; i < 3; ++i)
+		r = detail::multiply(r, detail::power(detail::multiply(from.ratio[i], RuntimeRatio{to.ratio[i].den, to.ratio[i].num}),
+		                                      from.dim[i]));
+	return r;
+}
+
+// The finest unit both convert to exactly, per dimension, as CommonRatio: the gcd of the numerators
+// over the lcm of the denominators
+inline UnitSignature common_signature(const UnitSignature& a, const UnitSignature& b)
+{
+	if (!a.same_dimension(b))
+		throw std::invalid_argument("incompatible dimensions");
+	UnitSignature c = a;
+	for (int i = 0; i < 3; ++i) {
+		const RuntimeRatio& x = a.ratio[i];
+		const RuntimeRatio& y = b.ratio[i];
+		const std::int64_t den = detail::checked_mul(x.den / detail::gcd(x.den, y.den), y.den);
+		c.ratio[i] = detail::make_ratio(detail::gcd(x.num, y.num), den);
+	}
+	return c;
+}
+
+// A conversion between two signatures, applied in bulk. Floating-point values are multiplied by
+// the factor; integers by the numerator then divided by the denominator, as dimension_cast
+class Conversion
+{
+public:
+	Conversion() = default;
+	explicit Conversion(const RuntimeRatio& ratio) : ratio_(ratio), factor_(ratio.value()) {}
+
+	const RuntimeRatio& ratio() const { return ratio_; }
+	double factor() const { return factor_; }
+	bool identity() const { return ratio_.num == ratio_.den; }
+
+	template <typename T>
+	T operator()(T x) const
+	{
+		return std::is_floating_point<T>::value ? static_cast<T>(x * static_cast<T>(factor_))
+		                                        : static_cast<T>(x * ratio_.num / ratio_.den);
+	}
+
+	// Convert n values; in and out may be the same
+	template <typename T>
+	void apply(const T* in, T* out, std::size_t n) const
+	{
+		if (identity()) {
+			if (in != out) std::memmove(out, in, n * sizeof(T));
+		}
+		else if (std::is_floating_point<T>::value) {
+			const T f = static_cast<T>(factor_);
+			for (std::size_t i = 0; i < n; ++i)
+				out[i] = in[i] * f;
+		}
+		else if (ratio_.den == 1) {
+			const std::int64_t num = ratio_.num;
+			for (std::size_t i = 0; i < n; ++i)
+				out[i] = static_cast<T>(in[i] * num);
+		}
+		else {
+			const std::int64_t num = ratio_.num;
+			const std::int64_t den = ratio_.den;
+			for (std::size_t i = 0; i < n; ++i)
+				out[i] = static_cast<T>(in[i] * num / den);
+		}
+	}
+
+	// Re-type a span after converting it: the caller vouches that in is in the source signature
+	template <typename Tin, typename T, typename Bin, typename Bout>
+	void apply(UnitSpan<Tin,Bin> in, UnitSpan<T,Bout> out) const
+	{
+		static_assert(std::is_same<std::remove_const_t<Tin>, T>::value, "conversions keep the rep");
+		assert(in.size() == out.size());
+		apply(in.values(), out.values(), in.size());
+	}
+
+private:
+	RuntimeRatio ratio_;
+	double factor_ = 1;
+};
+
+// Memoized conversions between pairs of signatures. Lookups are lock-free: an open-addressed table
+// of pointers to immutable entries, each published once by compare-and-swap and kept until the
+// cache is destroyed. Once the table is full, further pairs are computed but not kept
+class ConversionCache
+{
+public:
+	explicit ConversionCache(std::size_t capacity = 1024)
+	{
+		std::size_t size = 16;
+		while (size < 2 * capacity) size *= 2;
+		slots_.reset(new std::atomic<const Entry*>[size]);
+		for (std::size_t i = 0; i < size; ++i)
+			slots_[i].store(nullptr, std::memory_order_relaxed);
+		mask_ = size - 1;
+		limit_ = capacity;
+	}
+
+	~ConversionCache()
+	{
+		for (std::size_t i = 0; i <= mask_; ++i)
+			delete slots_[i].load(std::memory_order_relaxed);
+	}
+
+	ConversionCache(const ConversionCache&) = delete;
+	ConversionCache& operator=(const ConversionCache&) = delete;
+
+	// The conversion from one signature to another. Throws as conversion_ratio
+	Conversion get(const UnitSignature& from, const UnitSignature& to)
+	{
+		const std::uint64_t h = hash(from, to);
+		std::size_t i = static_cast<std::size_t>(h) & mask_;
+		for (std::size_t probe = 0; probe <= mask_; ++probe, i = (i + 1) & mask_) {
+			const Entry* e = slots_[i].load(std::memory_order_acquire);
+			if (!e) break;
+			if (e->hash == h && e->from == from && e->to == to)
+				return e->conversion;
+		}
+
+		const Conversion conversion(conversion_ratio(from, to));
+		if (size_.load(std::memory_order_relaxed) >= limit_)
+			return conversion;
+
+		// Publish in the first empty slot, unless another thread has meanwhile
+		std::unique_ptr<Entry> entry(new Entry{h, from, to, conversion});
+		for (std::size_t probe = 0; probe <= mask_; ++probe, i = (i + 1) & mask_) {
+			const Entry* expected = nullptr;
+			if (slots_[i].compare_exchange_strong(expected, entry.get(), std::memory_order_acq_rel)) {
+				entry.release();
+				size_.fetch_add(1, std::memory_order_relaxed);
+				break;
+			}
+			if (expected->hash == h && expected->from == from && expected->to == to)
+				break;
+		}
+		return conversion;
+	}
+
+	template <typename B1, typename B2>
+	Conversion get() { return get(signature<B1>(), signature<B2>()); }
+
+	// Pairs cached
+	std::size_t size() const { return size_.load(std::memory_order_relaxed); }
+
+	// A cache shared by the whole program
+	static ConversionCache& global()
+	{
+		static ConversionCache cache;
+		return cache;
+	}
+
+private:
+	struct Entry
+	{
+		std::uint64_t hash;
+		UnitSignature from;
+		UnitSignature to;
+		Conversion conversion;
+	};
+
+	static std::uint64_t mix(std::uint64_t h, std::uint64_t x)
+	{
+		// splitmix64 finalizer over the running hash
+		h ^= x + 0x9e3779b97f4a7c15 + (h << 6) + (h >> 2);
+		h ^= h >> 30;
+		h *= 0xbf58476d1ce4e5b9;
+		h ^= h >> 27;
+		h *= 0x94d049bb133111eb;
+		return h ^ (h >> 31);
+	}
+
+	static std::uint64_t hash(const UnitSignature& from, const UnitSignature& to)
+	{
+		std::uint64_t h = 0;
+		for (const UnitSignature* s : {&from, &to}) {
+			// Exponents packed into one word, then the ratios
+			h = mix(h, (static_cast<std::uint64_t>(static_cast<std::uint16_t>(s->dim[0])) << 32)
+			         | (static_cast<std::uint64_t>(static_cast<std::uint16_t>(s->dim[1])) << 16)
+			         | static_cast<std::uint16_t>(s->dim[2]));
+			for (const RuntimeRatio& r : s->ratio)
+				h = mix(mix(h, static_cast<std::uint64_t>(r.num)), static_cast<std::uint64_t>(r.den));
+		}
+		return h;
+	}
+
+	std::unique_ptr<std::atomic<const Entry*>[]> slots_;
+	std::size_t mask_ = 0;
+	std::size_t limit_ = 0;
+	std::atomic<std::size_t> size_{0};
+};
+
+} // sunit
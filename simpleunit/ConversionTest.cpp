@@ -0,0 +1,146 @@
+#include "simpleunit/Conversion.h"
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "gtest/gtest.h"
+
+using namespace std;
+using namespace sunit;
+
+namespace
+{
+	// The compile-time factor, to compare with the run-time one
+	template <typename B1, typename B2>
+	RuntimeRatio compile_time()
+	{
+		using R = BaseConversion<B1, B2>;
+		return RuntimeRatio{R::num, R::den};
+	}
+
+	template <typename B1, typename B2>
+	RuntimeRatio run_time()
+	{
+		return conversion_ratio(signature<B1>(), signature<B2>());
+	}
+}
+
+TEST(ConversionTest, Ratio)
+{
+	using namespace si;
+
+	EXPECT_EQ((RuntimeRatio{5, 18}), (run_time<Velocity<std::kilo, hour>, Velocity<meter, second>>()));
+	EXPECT_EQ((compile_time<Velocity<std::kilo, hour>, Velocity<meter, second>>()),
+	          (run_time<Velocity<std::kilo, hour>, Velocity<meter, second>>()));
+	EXPECT_EQ((compile_time<Velocity<meter, second>, Velocity<inch, hour>>()),
+	          (run_time<Velocity<meter, second>, Velocity<inch, hour>>()));
+	EXPECT_EQ((compile_time<Length3<std::centi>, Length3<meter>>()), (run_time<Length3<std::centi>, Length3<meter>>()));
+	EXPECT_EQ((compile_time<Force<std::milli, minute, std::milli>, Force<meter, second, kg>>()),
+	          (run_time<Force<std::milli, minute, std::milli>, Force<meter, second, kg>>()));
+	EXPECT_EQ((compile_time<Acceleration<inch, minute>, Acceleration<std::centi, second>>()),
+	          (run_time<Acceleration<inch, minute>, Acceleration<std::centi, second>>()));
+
+	// Unused ratios make no difference
+	EXPECT_EQ((signature<BaseUnit<Dim<1>, std::ratio<1>, std::milli>>()), signature<Length<meter>>());
+
+	EXPECT_THROW((run_time<Length<meter>, Time<second>>()), invalid_argument);
+	EXPECT_THROW((run_time<BaseUnit<Dim<9>, std::mega>, BaseUnit<Dim<9>, std::milli>>()), overflow_error);
+}
+
+TEST(ConversionTest, CheckedMultiply)
+{
+	const int64_t big = numeric_limits<int64_t>::max();
+	EXPECT_EQ(-6, detail::checked_mul(2, -3));
+	EXPECT_EQ(big, detail::checked_mul(big, 1));
+	EXPECT_EQ(numeric_limits<int64_t>::min(), detail::checked_mul(-(int64_t(1) << 62), 2));
+	EXPECT_THROW(detail::checked_mul(int64_t(1) << 62, 2), overflow_error);
+	EXPECT_THROW(detail::checked_mul(numeric_limits<int64_t>::min(), -1), overflow_error);
+}
+
+TEST(ConversionTest, Common)
+{
+	using namespace si;
+
+	const UnitSignature c = common_signature(signature<Velocity<inch, minute>>(), signature<Velocity<std::centi, hour>>());
+	using Expected = Velocity<CommonRatio<inch, std::centi>, CommonRatio<minute, hour>>;
+	EXPECT_EQ(signature<Expected>(), c);
+	EXPECT_EQ(3900, c.ratio[0].den);
+	EXPECT_EQ(60, c.ratio[1].num);
+
+	EXPECT_DOUBLE_EQ((dynamic_unit<Velocity<inch, hour>>().scale), dynamic_unit(signature<Velocity<inch, hour>>()).scale);
+	EXPECT_THROW(common_signature(signature<Length<meter>>(), signature<Mass<kg>>()), invalid_argument);
+}
+
+TEST(ConversionTest, Apply)
+{
+	using namespace si;
+
+	const Conversion kmh(run_time<Velocity<std::kilo, hour>, Velocity<meter, second>>());
+	EXPECT_FALSE(kmh.identity());
+	float speeds[5] = {0, 18, 36, 72, 90};
+	kmh.apply(speeds, speeds, 5);
+	EXPECT_FLOAT_EQ(5, speeds[1]);
+	EXPECT_FLOAT_EQ(25, speeds[4]);
+
+	// Integers truncate as dimension_cast
+	const Conversion ms(run_time<Time<std::milli>, Time<second>>());
+	const vector<Unit<int, Time<std::milli>>> in = {1999, 2000, 61000};
+	vector<Unit<int, Time<second>>> out(3);
+	ms.apply(make_span(in), make_span(out));
+	for (size_t i = 0; i < in.size(); ++i)
+		EXPECT_EQ((dimension_cast<Unit<int, Time<second>>>(in[i]).value()), out[i].value());
+	EXPECT_EQ(3000, Conversion(run_time<Time<second>, Time<std::milli>>())(3));
+
+	const Conversion same(run_time<Length<meter>, Length<meter>>());
+	EXPECT_TRUE(same.identity());
+	double d[2] = {1.5, 2.5}, e[2];
+	same.apply(d, e, 2);
+	EXPECT_EQ(2.5, e[1]);
+}
+
+TEST(ConversionTest, Cache)
+{
+	using namespace si;
+
+	ConversionCache cache(4);
+	const Conversion a = cache.get<Velocity<std::kilo, hour>, Velocity<meter, second>>();
+	const Conversion b = cache.get<Velocity<std::kilo, hour>, Velocity<meter, second>>();
+	EXPECT_EQ(a.ratio(), b.ratio());
+	EXPECT_EQ(1u, cache.size());
+	cache.get<Velocity<meter, second>, Velocity<std::kilo, hour>>();
+	EXPECT_EQ(2u, cache.size());
+	EXPECT_THROW((cache.get<Length<meter>, Time<second>>()), invalid_argument);
+	EXPECT_EQ(2u, cache.size());
+
+	// Beyond capacity, conversions are still given
+	cache.get<Length<std::milli>, Length<meter>>();
+	cache.get<Length<std::centi>, Length<meter>>();
+	EXPECT_EQ((RuntimeRatio{1, 1000}), (cache.get<Length<std::kilo>, Length<std::mega>>().ratio()));
+	EXPECT_EQ(4u, cache.size());
+
+	EXPECT_EQ((RuntimeRatio{60, 1}), (ConversionCache::global().get<Time<minute>, Time<second>>().ratio()));
+}
+
+TEST(ConversionTest, Concurrent)
+{
+	using namespace si;
+
+	ConversionCache cache;
+	const UnitSignature from[] = {signature<Length<meter>>(), signature<Length<std::centi>>(), signature<Length<inch>>(),
+	                              signature<Length<std::milli>>()};
+	vector<thread> threads;
+	vector<int> failures(4, 0);
+	for (int t = 0; t < 4; ++t)
+		threads.emplace_back([&, t] {
+			for (int i = 0; i < 2000; ++i) {
+				const UnitSignature& a = from[(i + t) % 4];
+				const UnitSignature& b = from[(i / 4 + t) % 4];
+				if (cache.get(a, b).ratio() != conversion_ratio(a, b))
+					++failures[t];
+			}
+		});
+	for (auto& t : threads)
+		t.join();
+	for (int f : failures)
+		EXPECT_EQ(0, f);
+	EXPECT_EQ(16u, cache.size());
+}
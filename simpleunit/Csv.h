@@ -0,0 +1,307 @@
+#pragma once
+
+#include "simpleunit/DynamicUnit.h"
+#include "simpleunit/Parallel.h"
+#include <array>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace sunit {
+
+// Reading numeric CSV into columns of units. The first line is a header naming each column, with
+// its unit in brackets, e.g.
+//
+//     time[s],speed[km/h],mass[kg]
+//
+// Requested columns are checked against the header's units and converted as they are parsed:
+//
+//     auto data = read_csv<Seconds, Meters_Second>("drop.csv", {{"time", "speed"}});
+//     auto speed = data.column<1>();  // in m/s
+//
+// The body is split into chunks at line boundaries, which are counted and then parsed in parallel,
+// each straight into its rows of the columns. Fields are plain numbers (no quoting); an empty field
+// reads as NaN. Numbers are parsed with strtod, so under the "C" locale.
+
+struct CsvOptions
+{
+	char delimiter = ',';
+
+	// Approximate bytes of the body per parallel task
+	std::size_t chunk_bytes = 1 << 20;
+
+	parallel::Options parallel;
+};
+
+// A read-only view of a whole file, memory-mapped where available
+class MappedFile
+{
+public:
+	explicit MappedFile(const std::string& path)
+	{
+#if defined(__unix__) || defined(__APPLE__)
+		const int fd = ::open(path.c_str(), O_RDONLY);
+		if (fd < 0)
+			throw std::runtime_error("cannot open " + path);
+		struct stat st;
+		if (::fstat(fd, &st) != 0) {
+			::close(fd);
+			throw std::runtime_error("cannot read " + path);
+		}
+		size_ = static_cast<std::size_t>(st.st_size);
+		data_ = "";
+		if (size_ > 0) {
+			void* p = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (p == MAP_FAILED) {
+				::close(fd);
+				throw std::runtime_error("cannot map " + path);
+			}
+			::madvise(p, size_, MADV_SEQUENTIAL);
+			data_ = static_cast<const char*>(p);
+		}
+		::close(fd);
+#else
+		std::ifstream file(path, std::ios::binary);
+		if (!file)
+			throw std::runtime_error("cannot open " + path);
+		buffer_.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+		data_ = buffer_.data();
+		size_ = buffer_.size();
+#endif
+	}
+
+	~MappedFile()
+	{
+#if defined(__unix__) || defined(__APPLE__)
+		if (size_ > 0)
+			::munmap(const_cast<char*>(data_), size_);
+#endif
+	}
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	const char* data() const { return data_; }
+	std::size_t size() const { return size_; }
+
+private:
+	const char* data_ = nullptr;
+	std::size_t size_ = 0;
+#if !(defined(__unix__) || defined(__APPLE__))
+	std::string buffer_;
+#endif
+};
+
+// A header cell: the column name and its unit, if given
+struct CsvField
+{
+	std::string name;
+	std::string unit;
+};
+
+namespace detail
+{
+	inline void trim(const char*& begin, const char*& end)
+	{
+		while (begin < end && (*begin == ' ' || *begin == '\t')) ++begin;
+		while (end > begin && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r')) --end;
+	}
+
+	inline std::vector<CsvField> parse_header(const char* begin, const char* end, char delimiter)
+	{
+		std::vector<CsvField> fields;
+		for (;;) {
+			const char* stop = static_cast<const char*>(std::memchr(begin, delimiter, end - begin));
+			const char* cell_end = stop ? stop : end;
+			const char* b = begin;
+			const char* e = cell_end;
+			trim(b, e);
+
+			CsvField field;
+			const char* open = static_cast<const char*>(std::memchr(b, '[', e - b));
+			if (open && e > open && e[-1] == ']') {
+				const char* name_end = open;
+				trim(b, name_end);
+				field.name.assign(b, name_end);
+				const char* unit_begin = open + 1;
+				const char* unit_end = e - 1;
+				trim(unit_begin, unit_end);
+				field.unit.assign(unit_begin, unit_end);
+			}
+			else
+				field.name.assign(b, e);
+			fields.push_back(field);
+
+			if (!stop) return fields;
+			begin = stop + 1;
+		}
+	}
+
+	inline const char* line_end(const char* p, const char* end)
+	{
+		const char* nl = static_cast<const char*>(std::memchr(p, '\n', end - p));
+		return nl ? nl : end;
+	}
+
+	// Call f(begin, end) for each line of [begin, end) that is not blank
+	template <typename F>
+	void for_each_line(const char* begin, const char* end, F f)
+	{
+		for (const char* p = begin; p < end;) {
+			const char* e = line_end(p, end);
+			const char* b = p;
+			const char* t = e;
+			trim(b, t);
+			if (b != t)
+				f(p, e);
+			if (e == end) break;
+			p = e + 1;
+		}
+	}
+
+	inline double parse_number(const char* begin, const char* end, std::size_t row)
+	{
+		trim(begin, end);
+		if (begin == end)
+			return std::numeric_limits<double>::quiet_NaN();
+		char buffer[64];
+		const std::size_t n = static_cast<std::size_t>(end - begin);
+		if (n >= sizeof(buffer))
+			throw std::invalid_argument("row " + std::to_string(row + 1) + ": field too long");
+		std::memcpy(buffer, begin, n);
+		buffer[n] = '\0';
+		char* parsed;
+		const double value = std::strtod(buffer, &parsed);
+		if (parsed != buffer + n)
+			throw std::invalid_argument("row " + std::to_string(row + 1) + ": cannot parse '" + std::string(buffer) + "'");
+		return value;
+	}
+
+	// Where each requested column's values go, and the factor converting to its unit
+	struct CsvColumn
+	{
+		double factor;
+		void* data;
+		void (*store)(void*, std::size_t, double);
+	};
+
+	template <typename T>
+	void store_value(void* data, std::size_t row, double value) { static_cast<T*>(data)[row] = static_cast<T>(value); }
+
+	template <typename SoA, std::size_t... I>
+	std::array<void*, sizeof...(I)> column_data(SoA& soa, std::index_sequence<I...>)
+	{
+		return {{soa.template column<I>().values()...}};
+	}
+}
+
+// Parse CSV text into the named columns, each converted to its unit. Throws std::invalid_argument
+// for a missing or repeated column, a unit that cannot be parsed or is of the wrong dimension, or a
+// bad field
+template <typename... Units>
+UnitSoA<Units...> parse_csv(const char* text, std::size_t size, const std::array<std::string, sizeof...(Units)>& names,
+                            const CsvOptions& options = CsvOptions())
+{
+	constexpr std::size_t N = sizeof...(Units);
+	const char* const end = text + size;
+	const char* const header_end = detail::line_end(text, end);
+	const std::vector<CsvField> header = detail::parse_header(text, header_end, options.delimiter);
+
+	// Map header fields to requested columns
+	const DynamicUnit targets[N] = {dynamic_unit<typename Units::base>()...};
+	void (*const stores[N])(void*, std::size_t, double) = {&detail::store_value<typename Units::rep>...};
+	std::vector<int> field_column(header.size(), -1);
+	double factors[N];
+	for (std::size_t c = 0; c < N; ++c) {
+		std::size_t f = 0;
+		while (f < header.size() && header[f].name != names[c]) ++f;
+		if (f == header.size())
+			throw std::invalid_argument("no column '" + names[c] + "'");
+		if (field_column[f] >= 0)
+			throw std::invalid_argument("column '" + names[c] + "' requested more than once");
+		const DynamicUnit source = header[f].unit.empty() ? DynamicUnit() : parse_unit(header[f].unit);
+		if (!source.same_dimension(targets[c]))
+			throw std::invalid_argument("column '" + names[c] + "' in [" + header[f].unit + "] has the wrong dimension");
+		field_column[f] = static_cast<int>(c);
+		factors[c] = conversion_factor(source, targets[c]);
+	}
+
+	// Chunks of the body, each starting at the beginning of a line
+	const char* const body = header_end < end ? header_end + 1 : end;
+	std::vector<const char*> bounds(1, body);
+	const std::size_t chunk = std::max<std::size_t>(1, options.chunk_bytes);
+	while (bounds.back() < end) {
+		const char* p = bounds.back() + std::min<std::size_t>(chunk, end - bounds.back());
+		if (p < end) {
+			p = detail::line_end(p - 1, end);
+			p = p < end ? p + 1 : end;
+		}
+		bounds.push_back(p);
+	}
+	const std::size_t chunks = bounds.size() - 1;
+
+	// Count the rows of each chunk, then parse each into its place
+	std::vector<std::size_t> rows(chunks + 1, 0);
+	parallel::for_range(chunks, 1, [&](std::size_t c0, std::size_t c1) {
+		for (std::size_t c = c0; c < c1; ++c) {
+			std::size_t count = 0;
+			detail::for_each_line(bounds[c], bounds[c + 1], [&count](const char*, const char*) { ++count; });
+			rows[c + 1] = count;
+		}
+	}, options.parallel);
+	for (std::size_t c = 0; c < chunks; ++c)
+		rows[c + 1] += rows[c];
+
+	UnitSoA<Units...> soa(rows[chunks]);
+	const std::array<void*, N> data = detail::column_data(soa, std::index_sequence_for<Units...>());
+	detail::CsvColumn columns[N];
+	for (std::size_t c = 0; c < N; ++c)
+		columns[c] = detail::CsvColumn{factors[c], data[c], stores[c]};
+
+	parallel::for_range(chunks, 1, [&](std::size_t c0, std::size_t c1) {
+		for (std::size_t c = c0; c < c1; ++c) {
+			std::size_t row = rows[c];
+			detail::for_each_line(bounds[c], bounds[c + 1], [&](const char* p, const char* e) {
+				std::size_t found = 0;
+				for (std::size_t f = 0; f < field_column.size(); ++f) {
+					const char* stop = static_cast<const char*>(std::memchr(p, options.delimiter, e - p));
+					const char* field_end = stop ? stop : e;
+					const int column = field_column[f];
+					if (column >= 0) {
+						const detail::CsvColumn& col = columns[column];
+						col.store(col.data, row, detail::parse_number(p, field_end, row) * col.factor);
+						++found;
+					}
+					if (!stop) break;
+					p = stop + 1;
+				}
+				if (found != N)
+					throw std::invalid_argument("row " + std::to_string(row + 1) + ": missing fields");
+				++row;
+			});
+		}
+	}, options.parallel);
+
+	return soa;
+}
+
+template <typename... Units>
+UnitSoA<Units...> read_csv(const std::string& path, const std::array<std::string, sizeof...(Units)>& names,
+                           const CsvOptions& options = CsvOptions())
+{
+	MappedFile file(path);
+	return parse_csv<Units...>(file.data(), file.size(), names, options);
+}
+
+} // sunit
@@ -0,0 +1,103 @@
+#include "simpleunit/Csv.h"
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include "gtest/gtest.h"
+
+using namespace std;
+using namespace sunit;
+
+namespace
+{
+	template <typename... Units>
+	UnitSoA<Units...> parse(const string& text, const array<string, sizeof...(Units)>& names,
+	                        const CsvOptions& options = CsvOptions())
+	{
+		return parse_csv<Units...>(text.data(), text.size(), names, options);
+	}
+}
+
+TEST(CsvTest, Parse)
+{
+	using namespace si;
+
+	const string text = "time[s], mass [kg], speed[km/h]\n0,1,36\n1.5,2,72\n3,3,-18\n";
+	const auto data = parse<Seconds, Meters_Second>(text, {{"time", "speed"}});
+	ASSERT_EQ(3u, data.size());
+	EXPECT_FLOAT_EQ(0, data.column<0>()[0].value());
+	EXPECT_FLOAT_EQ(1.5f, data.column<0>()[1].value());
+	EXPECT_FLOAT_EQ(10, data.column<1>()[0].value());
+	EXPECT_FLOAT_EQ(20, data.column<1>()[1].value());
+	EXPECT_FLOAT_EQ(-5, data.column<1>()[2].value());
+
+	// Columns in any order, in other units
+	const auto minutes = parse<Minutes, Unit<double, Velocity<meter, second>>>(text, {{"time", "speed"}});
+	EXPECT_FLOAT_EQ(0.05f, minutes.column<0>()[2].value());
+	EXPECT_DOUBLE_EQ(20, minutes.column<1>()[1].value());
+}
+
+TEST(CsvTest, Chunks)
+{
+	using namespace si;
+
+	string text = "x[mm];t[ms]\r\n";
+	for (int i = 0; i < 1000; ++i)
+		text += to_string(i) + ";" + to_string(2 * i) + (i % 7 == 0 ? "\r\n\r\n" : "\r\n");
+	text.resize(text.size() - 2);  // no trailing newline
+
+	CsvOptions options;
+	options.delimiter = ';';
+	const auto whole = parse<Meters, Seconds>(text, {{"x", "t"}}, options);
+	options.chunk_bytes = 16;
+	const auto chunked = parse<Meters, Seconds>(text, {{"x", "t"}}, options);
+
+	ASSERT_EQ(1000u, whole.size());
+	ASSERT_EQ(1000u, chunked.size());
+	for (size_t i = 0; i < 1000; ++i) {
+		EXPECT_FLOAT_EQ(i / 1000.0f, chunked.column<0>()[i].value());
+		EXPECT_FLOAT_EQ(2 * i / 1000.0f, chunked.column<1>()[i].value());
+		EXPECT_EQ(whole.column<0>()[i].value(), chunked.column<0>()[i].value());
+	}
+}
+
+TEST(CsvTest, Fields)
+{
+	using namespace si;
+
+	const auto data = parse<Meters, Meters>("a[m],b[m]\n1,\n,2\n", {{"a", "b"}});
+	ASSERT_EQ(2u, data.size());
+	EXPECT_TRUE(std::isnan(data.column<1>()[0].value()));
+	EXPECT_TRUE(std::isnan(data.column<0>()[1].value()));
+
+	// A column without a unit is dimensionless
+	const auto ratio = parse<Unit<float, BaseUnit<Dim<0>>>>("r\n0.5\n", {{"r"}});
+	EXPECT_FLOAT_EQ(0.5f, ratio.column<0>()[0].value());
+
+	EXPECT_THROW((parse<Meters>("a[m]\n1\n", {{"b"}})), invalid_argument);
+	EXPECT_THROW((parse<Meters>("a[s]\n1\n", {{"a"}})), invalid_argument);
+	EXPECT_THROW((parse<Meters>("a[parsec]\n1\n", {{"a"}})), invalid_argument);
+	EXPECT_THROW((parse<Meters>("a[m]\n1\nx\n", {{"a"}})), invalid_argument);
+	EXPECT_THROW((parse<Meters, Meters>("a[m],b[m]\n1,2\n3\n", {{"a", "b"}})), invalid_argument);
+	EXPECT_THROW((parse<Meters, Meters>("a[m],b[m]\n1,2\n", {{"a", "a"}})), invalid_argument);
+	EXPECT_THROW((parse<Meters>("", {{"a"}})), invalid_argument);
+}
+
+TEST(CsvTest, ReadFile)
+{
+	using namespace si;
+
+	const string path = testing::TempDir() + "sunit_csv_test.csv";
+	{
+		ofstream file(path);
+		file << "t[h],d[km]\n1,100\n2,250\n";
+	}
+	const auto data = read_csv<Seconds, Meters>(path, {{"t", "d"}});
+	std::remove(path.c_str());
+
+	ASSERT_EQ(2u, data.size());
+	EXPECT_FLOAT_EQ(7200, data.column<0>()[1].value());
+	EXPECT_FLOAT_EQ(250000, data.column<1>()[1].value());
+
+	EXPECT_THROW((read_csv<Seconds>(path, {{"t"}})), runtime_error);
+}
@@ -0,0 +1,296 @@
+#pragma once
+
+#include "simpleunit/Unit.h"
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+
+namespace sunit {
+
+// A unit known only at run time, e.g. from a file: the exponent of each dimension, and the
+// magnitude relative to the unit ratio in every dimension (meters, seconds and kilograms for the
+// `si` ratios). km/h is dimension [1,-1,0] at scale 1000/3600.
+struct DynamicUnit
+{
+	int dim[3] = {0, 0, 0};
+	double scale = 1;
+
+	bool same_dimension(const DynamicUnit& rhs) const
+	{
+		return dim[0] == rhs.dim[0] && dim[1] == rhs.dim[1] && dim[2] == rhs.dim[2];
+	}
+
+	friend bool operator==(const DynamicUnit& a, const DynamicUnit& b) { return a.same_dimension(b) && a.scale == b.scale; }
+	friend bool operator!=(const DynamicUnit& a, const DynamicUnit& b) { return !(a == b); }
+
+	friend DynamicUnit operator*(const DynamicUnit& a, const DynamicUnit& b)
+	{
+		DynamicUnit u;
+		for (int i = 0; i < 3; ++i)
+			u.dim[i] = a.dim[i] + b.dim[i];
+		u.scale = a.scale * b.scale;
+		return u;
+	}
+
+	friend DynamicUnit operator/(const DynamicUnit& a, const DynamicUnit& b)
+	{
+		DynamicUnit u;
+		for (int i = 0; i < 3; ++i)
+			u.dim[i] = a.dim[i] - b.dim[i];
+		u.scale = a.scale / b.scale;
+		return u;
+	}
+
+	friend DynamicUnit pow(const DynamicUnit& a, int n)
+	{
+		DynamicUnit u;
+		for (int i = 0; i < 3; ++i)
+			u.dim[i] = a.dim[i] * n;
+		u.scale = std::pow(a.scale, n);
+		return u;
+	}
+};
+
+inline std::ostream& operator<<(std::ostream& os, const DynamicUnit& u)
+{
+	return os << u.scale << " [" << u.dim[0] << "," << u.dim[1] << "," << u.dim[2] << "]";
+}
+
+// The run-time description of a base unit
+template <typename B>
+DynamicUnit dynamic_unit()
+{
+	using D = typename B::dim;
+	DynamicUnit u;
+	u.dim[0] = D::d1;
+	u.dim[1] = D::d2;
+	u.dim[2] = D::d3;
+	u.scale = std::pow(static_cast<double>(B::r1::num) / B::r1::den, D::d1)
+	        * std::pow(static_cast<double>(B::r2::num) / B::r2::den, D::d2)
+	        * std::pow(static_cast<double>(B::r3::num) / B::r3::den, D::d3);
+	return u;
+}
+
+// The factor taking values in one unit to another of the same dimension
+inline double conversion_factor(const DynamicUnit& from, const DynamicUnit& to)
+{
+	if (!from.same_dimension(to))
+		throw std::invalid_argument("incompatible dimensions");
+	return from.scale / to.scale;
+}
+
+namespace detail
+{
+	inline const DynamicUnit* find_symbol(const std::string& symbol)
+	{
+		struct Symbol
+		{
+			const char* name;
+			DynamicUnit unit;
+		};
+		static const Symbol symbols[] = {
+			{"m", dynamic_unit<Length<si::meter>>()},
+			{"cm", dynamic_unit<Length<std::centi>>()},
+			{"mm", dynamic_unit<Length<std::milli>>()},
+			{"km", dynamic_unit<Length<std::kilo>>()},
+			{"in", dynamic_unit<Length<si::inch>>()},
+			{"s", dynamic_unit<Time<si::second>>()},
+			{"ms", dynamic_unit<Time<std::milli>>()},
+			{"min", dynamic_unit<Time<si::minute>>()},
+			{"h", dynamic_unit<Time<si::hour>>()},
+			{"kg", dynamic_unit<Mass<si::kg>>()},
+			{"g", dynamic_unit<Mass<std::milli>>()},
+			{"Hz", dynamic_unit<Frequency<si::second>>()},
+			{"kHz", dynamic_unit<Frequency<std::milli>>()},
+			{"N", dynamic_unit<Force<si::meter, si::second, si::kg>>()},
+		};
+		for (const Symbol& s : symbols)
+			if (symbol == s.name)
+				return &s.unit;
+		return nullptr;
+	}
+}
+
+namespace detail
+{
+	// Symbols for the ratios of each dimension, as parse_unit reads them
+	constexpr const char* length_symbol(std::intmax_t num, std::intmax_t den)
+	{
+		return num == 1 && den == 1 ? "m"
+		     : num == 1 && den == 100 ? "cm"
+		     : num == 1 && den == 1000 ? "mm"
+		     : num == 1000 && den == 1 ? "km"
+		     : num == 1 && den == 39 ? "in"
+		     : nullptr;
+	}
+
+	constexpr const char* time_symbol(std::intmax_t num, std::intmax_t den)
+	{
+		return num == 1 && den == 1 ? "s"
+		     : num == 1 && den == 1000 ? "ms"
+		     : num == 60 && den == 1 ? "min"
+		     : num == 3600 && den == 1 ? "h"
+		     : nullptr;
+	}
+
+	constexpr const char* mass_symbol(std::intmax_t num, std::intmax_t den)
+	{
+		return num == 1 && den == 1 ? "kg"
+		     : num == 1 && den == 1000 ? "g"
+		     : nullptr;
+	}
+
+	struct UnitSymbol
+	{
+		char text[32] = {};
+		std::size_t size = 0;
+
+		constexpr void append(const char* s)
+		{
+			while (*s)
+				text[size++] = *s++;
+		}
+
+		constexpr void append_power(int p)
+		{
+			if (p == 1) return;
+			text[size++] = '^';
+			if (p >= 10) text[size++] = static_cast<char>('0' + p / 10);
+			text[size++] = static_cast<char>('0' + p % 10);
+		}
+	};
+
+	template <typename B>
+	constexpr UnitSymbol make_unit_symbol()
+	{
+		using D = typename B::dim;
+		UnitSymbol s;
+		if (D::d1 == 0 && D::d2 == -1 && D::d3 == 0 && B::r2::num == 1 && (B::r2::den == 1 || B::r2::den == 1000)) {
+			s.append(B::r2::den == 1 ? "Hz" : "kHz");
+			return s;
+		}
+		if (D::d1 == 1 && D::d2 == -2 && D::d3 == 1 && B::r1::num == B::r1::den && B::r2::num == B::r2::den && B::r3::num == B::r3::den) {
+			s.append("N");
+			return s;
+		}
+
+		// Mass, length then time: kg*m/s^2
+		const int dims[3] = {D::d3, D::d1, D::d2};
+		const char* names[3] = {mass_symbol(B::r3::num, B::r3::den), length_symbol(B::r1::num, B::r1::den),
+		                        time_symbol(B::r2::num, B::r2::den)};
+		int positive = 0;
+		for (int i = 0; i < 3; ++i)
+			if (dims[i] > 0) {
+				if (positive++) s.append("*");
+				s.append(names[i]);
+				s.append_power(dims[i]);
+			}
+		if (!positive)
+			s.append("1");
+		for (int i = 0; i < 3; ++i)
+			if (dims[i] < 0) {
+				s.append("/");
+				s.append(names[i]);
+				s.append_power(-dims[i]);
+			}
+		return s;
+	}
+
+	// Whether each ratio in use has a symbol
+	template <typename B>
+	constexpr bool has_unit_symbol()
+	{
+		using D = typename B::dim;
+		return (D::d1 == 0 || length_symbol(B::r1::num, B::r1::den) != nullptr)
+		    && (D::d2 == 0 || time_symbol(B::r2::num, B::r2::den) != nullptr)
+		    && (D::d3 == 0 || mass_symbol(B::r3::num, B::r3::den) != nullptr);
+	}
+
+	template <typename B>
+	struct UnitSymbolOf
+	{
+		using D = typename B::dim;
+		static_assert(has_unit_symbol<B>(), "no symbol for this unit's ratios");
+		static_assert(100 > D::d1 && 100 > D::d2 && 100 > D::d3 && D::d1 > -100 && D::d2 > -100 && D::d3 > -100,
+		              "exponent too large for a symbol");
+		static constexpr UnitSymbol value = make_unit_symbol<B>();
+	};
+
+	template <typename B>
+	constexpr UnitSymbol UnitSymbolOf<B>::value;
+}
+
+// The symbol of a base unit, built at compile time in the form parse_unit reads, e.g. "m/s^2"
+// for Acceleration<meter, second>, "kg*m/s^2" or "N" for a force. Fails to compile for ratios
+// without a symbol
+template <typename B>
+constexpr const char* unit_symbol()
+{
+	return detail::UnitSymbolOf<B>::value.text;
+}
+
+template <typename B>
+constexpr std::size_t unit_symbol_size()
+{
+	return detail::UnitSymbolOf<B>::value.size;
+}
+
+// Parse a unit such as "km/h", "m/s^2", "kg*m/s^2", "m.s^-1" or "1/min". Each '/' divides by the
+// single symbol following it. Throws std::invalid_argument for anything unrecognised
+inline DynamicUnit parse_unit(const std::string& text)
+{
+	DynamicUnit unit;
+	std::size_t i = 0;
+	const std::size_t n = text.size();
+	auto fail = [&text]() -> DynamicUnit { throw std::invalid_argument("cannot parse unit '" + text + "'"); };
+	auto skip_space = [&] { while (i < n && text[i] == ' ') ++i; };
+
+	bool divide = false;
+	bool first = true;
+	for (;;) {
+		skip_space();
+		if (i == n) {
+			if (first || divide) fail();
+			return unit;
+		}
+
+		DynamicUnit factor;
+		if (text[i] == '1' && first) {
+			++i;
+		}
+		else {
+			const std::size_t begin = i;
+			while (i < n && std::isalpha(static_cast<unsigned char>(text[i]))) ++i;
+			const DynamicUnit* symbol = detail::find_symbol(text.substr(begin, i - begin));
+			if (!symbol) fail();
+			factor = *symbol;
+			if (i < n && text[i] == '^') {
+				++i;
+				char* end;
+				const long power = std::strtol(text.c_str() + i, &end, 10);
+				if (end == text.c_str() + i) fail();
+				i = end - text.c_str();
+				factor = pow(factor, static_cast<int>(power));
+			}
+		}
+		unit = divide ? unit / factor : unit * factor;
+		first = false;
+
+		skip_space();
+		if (i == n)
+			return unit;
+		if (text[i] == '/')
+			divide = true;
+		else if (text[i] == '*' || text[i] == '.')
+			divide = false;
+		else
+			fail();
+		++i;
+	}
+}
+
+} // sunit
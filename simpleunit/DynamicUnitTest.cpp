@@ -0,0 +1,78 @@
+#include "simpleunit/DynamicUnit.h"
+#include <stdexcept>
+#include "gtest/gtest.h"
+
+using namespace std;
+using namespace sunit;
+
+TEST(DynamicUnitTest, FromType)
+{
+	using namespace si;
+
+	const DynamicUnit v = dynamic_unit<Velocity<meter, second>>();
+	EXPECT_EQ(1, v.dim[0]);
+	EXPECT_EQ(-1, v.dim[1]);
+	EXPECT_EQ(0, v.dim[2]);
+	EXPECT_DOUBLE_EQ(1, v.scale);
+
+	const DynamicUnit i = dynamic_unit<Velocity<inch, hour>>();
+	EXPECT_TRUE(i.same_dimension(v));
+	EXPECT_DOUBLE_EQ(1.0 / 39 / 3600, i.scale);
+}
+
+TEST(DynamicUnitTest, Parse)
+{
+	using namespace si;
+
+	const DynamicUnit kmh = parse_unit("km/h");
+	EXPECT_EQ(1, kmh.dim[0]);
+	EXPECT_EQ(-1, kmh.dim[1]);
+	EXPECT_EQ(0, kmh.dim[2]);
+	EXPECT_DOUBLE_EQ(1000.0 / 3600, kmh.scale);
+
+	EXPECT_EQ((dynamic_unit<Acceleration<meter, second>>()), parse_unit("m/s^2"));
+	EXPECT_EQ(parse_unit("N"), parse_unit("kg*m/s^2"));
+	EXPECT_EQ(parse_unit("m/s"), parse_unit("m.s^-1"));
+	EXPECT_EQ(parse_unit("m/s"), parse_unit(" m / s "));
+	EXPECT_EQ(parse_unit("Hz"), parse_unit("1/s"));
+	EXPECT_DOUBLE_EQ(1.0 / 60, parse_unit("1/min").scale);
+
+	EXPECT_THROW(parse_unit("furlong"), invalid_argument);
+	EXPECT_THROW(parse_unit("m/"), invalid_argument);
+	EXPECT_THROW(parse_unit("m^"), invalid_argument);
+	EXPECT_THROW(parse_unit(""), invalid_argument);
+	EXPECT_THROW(parse_unit("m s"), invalid_argument);
+}
+
+TEST(DynamicUnitTest, Conversion)
+{
+	EXPECT_DOUBLE_EQ(1000.0 / 3600, conversion_factor(parse_unit("km/h"), parse_unit("m/s")));
+	EXPECT_DOUBLE_EQ(60, conversion_factor(parse_unit("min"), parse_unit("s")));
+	EXPECT_DOUBLE_EQ(1000, conversion_factor(parse_unit("kHz"), parse_unit("Hz")));
+	EXPECT_THROW(conversion_factor(parse_unit("m"), parse_unit("s")), invalid_argument);
+}
+
+TEST(DynamicUnitTest, Symbol)
+{
+	using namespace si;
+
+	EXPECT_STREQ("m", unit_symbol<Length<meter>>());
+	EXPECT_STREQ("km/h", (unit_symbol<Velocity<std::kilo, hour>>()));
+	EXPECT_STREQ("m/s^2", (unit_symbol<Acceleration<meter, second>>()));
+	EXPECT_STREQ("N", (unit_symbol<Force<meter, second, kg>>()));
+	EXPECT_STREQ("g*cm/s^2", (unit_symbol<Force<std::centi, second, std::milli>>()));
+	EXPECT_STREQ("Hz", unit_symbol<Frequency<second>>());
+	EXPECT_STREQ("kHz", unit_symbol<Frequency<std::milli>>());
+	EXPECT_STREQ("1/min", unit_symbol<Frequency<minute>>());
+	EXPECT_STREQ("1", unit_symbol<BaseUnit<Dim<0>>>());
+	EXPECT_EQ(5u, (unit_symbol_size<VolumetricFlux<meter, second>>()));
+
+	static_assert(unit_symbol<Length<std::milli>>()[1] == 'm', "symbols are constant expressions");
+
+	// Symbols read back as the same unit
+	EXPECT_EQ((dynamic_unit<Velocity<inch, hour>>()), parse_unit(unit_symbol<Velocity<inch, hour>>()));
+	EXPECT_EQ((dynamic_unit<Force<std::centi, second, std::milli>>()),
+	          parse_unit(unit_symbol<Force<std::centi, second, std::milli>>()));
+	EXPECT_EQ((dynamic_unit<VolumetricFlux<std::milli, minute>>()),
+	          parse_unit(unit_symbol<VolumetricFlux<std::milli, minute>>()));
+}
@@ -0,0 +1,318 @@
+#pragma once
+
+#include "simpleunit/Statistics.h"
+#include <cassert>
+#include <cmath>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace sunit {
+
+// A power-of-two FFT over split (separate real and imaginary) arrays. A plan holds the twiddle
+// factors and bit-reversal permutation for its size, and is immutable once built, so one plan can
+// be shared by any number of threads; `FftPlan<T>::get(n)` returns a cached plan.
+//
+// Stages are fused in pairs (radix 4) to halve the passes over the data, with a final radix-2
+// stage for odd powers of two. Within a stage, butterflies run over contiguous real, imaginary and
+// twiddle arrays so the loops vectorize.
+template <typename T>
+class FftPlan
+{
+public:
+	explicit FftPlan(std::size_t n)
+		: n_(n), twiddle_re_(n > 1 ? n - 1 : 0), twiddle_im_(n > 1 ? n - 1 : 0), reverse_(n)
+	{
+		assert(n > 0 && (n & (n - 1)) == 0);
+
+		// Twiddles W_L^j = exp(-2 pi i j / L) for each stage length L, at offset L/2 - 1
+		const double pi = std::acos(-1.0);
+		for (std::size_t L = 2; L <= n; L *= 2)
+			for (std::size_t j = 0; j < L / 2; ++j) {
+				twiddle_re_[L / 2 - 1 + j] = static_cast<T>(std::cos(2 * pi * j / L));
+				twiddle_im_[L / 2 - 1 + j] = static_cast<T>(-std::sin(2 * pi * j / L));
+			}
+
+		std::size_t bits = 0;
+		while ((std::size_t(1) << bits) < n) ++bits;
+		for (std::size_t i = 0; i < n; ++i) {
+			std::size_t r = 0;
+			for (std::size_t b = 0; b < bits; ++b)
+				r |= ((i >> b) & 1) << (bits - 1 - b);
+			reverse_[i] = r;
+		}
+	}
+
+	static std::shared_ptr<const FftPlan> get(std::size_t n)
+	{
+		static std::mutex mutex;
+		static std::map<std::size_t, std::shared_ptr<const FftPlan>> plans;
+		std::lock_guard<std::mutex> lock(mutex);
+		auto& plan = plans[n];
+		if (!plan)
+			plan = std::make_shared<const FftPlan>(n);
+		return plan;
+	}
+
+	std::size_t size() const { return n_; }
+
+	// In-place forward transform of n complex values
+	void forward(T* re, T* im) const { run(re, im, n_); }
+
+	// In-place inverse transform, scaled by 1/n
+	void inverse(T* re, T* im) const
+	{
+		for (std::size_t i = 0; i < n_; ++i)
+			im[i] = -im[i];
+		run(re, im, n_);
+		const T scale = T(1) / static_cast<T>(n_);
+		for (std::size_t i = 0; i < n_; ++i) {
+			re[i] *= scale;
+			im[i] *= -scale;
+		}
+	}
+
+	// Forward transform of n real values into the n/2 + 1 non-negative frequency bins. re and im
+	// must have room for n/2 + 1 values. The input is packed as n/2 complex values and transformed
+	// at half size, then separated into the spectrum of the real signal.
+	void forward_real(const T* x, T* re, T* im) const
+	{
+		if (n_ == 1) {
+			re[0] = x[0];
+			im[0] = 0;
+			return;
+		}
+		const std::size_t h = n_ / 2;
+		for (std::size_t i = 0; i < h; ++i) {
+			re[i] = x[2 * i];
+			im[i] = x[2 * i + 1];
+		}
+		run(re, im, h);
+
+		const T r0 = re[0], i0 = im[0];
+		re[0] = r0 + i0;
+		im[0] = 0;
+		re[h] = r0 - i0;
+		im[h] = 0;
+		for (std::size_t k = 1; k <= h / 2; ++k) {
+			const std::size_t m = h - k;
+			const T a = re[k], b = im[k], c = re[m], d = im[m];
+			const T er = (a + c) / 2, ei = (b - d) / 2;
+			const T orr = (b + d) / 2, oi = (c - a) / 2;
+			const T wr = twiddle_re_[h - 1 + k], wi = twiddle_im_[h - 1 + k];
+			const T tr = wr * orr - wi * oi, ti = wr * oi + wi * orr;
+			re[k] = er + tr;
+			im[k] = ei + ti;
+			re[m] = er - tr;
+			im[m] = ti - ei;
+		}
+	}
+
+private:
+	// Transform of size n_ or n_ / 2 (whose permutation is that of n_ shifted down a bit)
+	void run(T* re, T* im, std::size_t size) const
+	{
+		const std::size_t shift = size == n_ ? 0 : 1;
+		for (std::size_t i = 0; i < size; ++i) {
+			const std::size_t r = reverse_[i] >> shift;
+			if (i < r) {
+				std::swap(re[i], re[r]);
+				std::swap(im[i], im[r]);
+			}
+		}
+
+		std::size_t h = 1;
+		for (; 4 * h <= size; h *= 4)
+			radix4(re, im, size, h);
+		if (2 * h <= size)
+			radix2(re, im, size, h);
+	}
+
+	// Butterflies of one stage of length 2h
+	void radix2(T* re, T* im, std::size_t size, std::size_t h) const
+	{
+		const T* wr = &twiddle_re_[h - 1];
+		const T* wi = &twiddle_im_[h - 1];
+		for (std::size_t base = 0; base < size; base += 2 * h) {
+			T* ar = re + base;
+			T* ai = im + base;
+			T* br = ar + h;
+			T* bi = ai + h;
+			for (std::size_t j = 0; j < h; ++j) {
+				const T tr = wr[j] * br[j] - wi[j] * bi[j];
+				const T ti = wr[j] * bi[j] + wi[j] * br[j];
+				br[j] = ar[j] - tr;
+				bi[j] = ai[j] - ti;
+				ar[j] += tr;
+				ai[j] += ti;
+			}
+		}
+	}
+
+	// Stages of length 2h and 4h in one pass
+	void radix4(T* re, T* im, std::size_t size, std::size_t h) const
+	{
+		const T* w1r = &twiddle_re_[h - 1];
+		const T* w1i = &twiddle_im_[h - 1];
+		const T* w2r = &twiddle_re_[2 * h - 1];
+		const T* w2i = &twiddle_im_[2 * h - 1];
+		const T* w3r = w2r + h;
+		const T* w3i = w2i + h;
+		for (std::size_t base = 0; base < size; base += 4 * h) {
+			T* ar = re + base;
+			T* ai = im + base;
+			T* br = ar + h;
+			T* bi = ai + h;
+			T* cr = br + h;
+			T* ci = bi + h;
+			T* dr = cr + h;
+			T* di = ci + h;
+			for (std::size_t j = 0; j < h; ++j) {
+				// Length 2h: (a, b) and (c, d)
+				T tr = w1r[j] * br[j] - w1i[j] * bi[j];
+				T ti = w1r[j] * bi[j] + w1i[j] * br[j];
+				const T a1r = ar[j] + tr, a1i = ai[j] + ti;
+				const T b1r = ar[j] - tr, b1i = ai[j] - ti;
+				tr = w1r[j] * dr[j] - w1i[j] * di[j];
+				ti = w1r[j] * di[j] + w1i[j] * dr[j];
+				const T c1r = cr[j] + tr, c1i = ci[j] + ti;
+				const T d1r = cr[j] - tr, d1i = ci[j] - ti;
+
+				// Length 4h: (a, c) and (b, d)
+				tr = w2r[j] * c1r - w2i[j] * c1i;
+				ti = w2r[j] * c1i + w2i[j] * c1r;
+				ar[j] = a1r + tr;
+				ai[j] = a1i + ti;
+				cr[j] = a1r - tr;
+				ci[j] = a1i - ti;
+				tr = w3r[j] * d1r - w3i[j] * d1i;
+				ti = w3r[j] * d1i + w3i[j] * d1r;
+				br[j] = b1r + tr;
+				bi[j] = b1i + ti;
+				dr[j] = b1r - tr;
+				di[j] = b1i - ti;
+			}
+		}
+	}
+
+	std::size_t n_;
+	std::vector<T> twiddle_re_;
+	std::vector<T> twiddle_im_;
+	std::vector<std::size_t> reverse_;
+};
+
+
+// Spectra of real signals sampled at a uniform interval. Each returns the n/2 + 1 one-sided bins of
+// a span whose size is a power of two, at the frequencies given by frequency_axis.
+
+enum class Window { rectangular, hann };
+
+// The unit of 1 / X, at the same scales (e.g. Seconds -> Hertz, Minutes -> per minute)
+template <typename T, typename B>
+using InverseUnit = Unit<T, BaseUnit<DivType<Dim<0>, typename B::dim>, typename B::r1, typename B::r2, typename B::r3>>;
+
+namespace detail
+{
+	template <typename T>
+	std::vector<T> window(Window w, std::size_t n)
+	{
+		std::vector<T> weights(n, T(1));
+		if (w == Window::hann && n > 1) {
+			const double pi = std::acos(-1.0);
+			for (std::size_t i = 0; i < n; ++i)
+				weights[i] = static_cast<T>(0.5 - 0.5 * std::cos(2 * pi * i / n));
+		}
+		return weights;
+	}
+
+	// |X_k|^2 for the one-sided bins of the windowed signal, and the window's sum and sum of squares
+	template <typename T, typename X>
+	std::vector<T> power_bins(const X* x, std::size_t n, Window w, T& sum, T& sum2)
+	{
+		assert(n > 0 && (n & (n - 1)) == 0);
+		const std::vector<T> weights = window<T>(w, n);
+		std::vector<T> windowed(n);
+		sum = sum2 = 0;
+		for (std::size_t i = 0; i < n; ++i) {
+			windowed[i] = weights[i] * static_cast<T>(x[i]);
+			sum += weights[i];
+			sum2 += weights[i] * weights[i];
+		}
+
+		const std::size_t bins = n / 2 + 1;
+		std::vector<T> re(bins), im(bins);
+		FftPlan<T>::get(n)->forward_real(windowed.data(), re.data(), im.data());
+		for (std::size_t k = 0; k < bins; ++k)
+			re[k] = re[k] * re[k] + im[k] * im[k];
+		return re;
+	}
+
+	// One-sided bins count twice, except DC and (for n > 1) Nyquist
+	inline bool doubled(std::size_t k, std::size_t n) { return k != 0 && 2 * k != n; }
+}
+
+// The frequency of each bin, k / (n dt), in the inverse unit of the sample interval
+template <typename X, typename Bt>
+UnitArray<X, typename InverseUnit<X,Bt>::base> frequency_axis(std::size_t n, const Unit<X,Bt>& dt)
+{
+	UnitArray<X, typename InverseUnit<X,Bt>::base> f(n / 2 + 1);
+	const X df = X(1) / (static_cast<X>(n) * dt.value());
+	for (std::size_t k = 0; k < f.size(); ++k)
+		f[k] = InverseUnit<X,Bt>(static_cast<X>(k) * df);
+	return f;
+}
+
+// The peak amplitude of a sinusoid at each bin, in the unit of the signal
+template <typename T, typename B>
+UnitArray<std::remove_const_t<T>,B> amplitude_spectrum(UnitSpan<T,B> values, Window w = Window::hann)
+{
+	using Z = std::remove_const_t<T>;
+	const std::size_t n = values.size();
+	Z sum, sum2;
+	const std::vector<Z> p = detail::power_bins<Z>(values.values(), n, w, sum, sum2);
+	UnitArray<Z,B> a(p.size());
+	for (std::size_t k = 0; k < p.size(); ++k)
+		a[k] = Unit<Z,B>((detail::doubled(k, n) ? 2 : 1) * std::sqrt(p[k]) / sum);
+	return a;
+}
+
+// The mean-square power at each bin, in the squared unit of the signal
+template <typename T, typename B>
+UnitArray<std::remove_const_t<T>, typename SquareUnit<std::remove_const_t<T>,B>::base>
+power_spectrum(UnitSpan<T,B> values, Window w = Window::hann)
+{
+	using Z = std::remove_const_t<T>;
+	using P = SquareUnit<Z,B>;
+	const std::size_t n = values.size();
+	Z sum, sum2;
+	const std::vector<Z> p = detail::power_bins<Z>(values.values(), n, w, sum, sum2);
+	UnitArray<Z, typename P::base> s(p.size());
+	for (std::size_t k = 0; k < p.size(); ++k)
+		s[k] = P((detail::doubled(k, n) ? 2 : 1) * p[k] / (sum * sum));
+	return s;
+}
+
+// The power spectral density, in the squared unit of the signal per unit frequency (times the
+// unit of the interval), e.g. Meters_Second2 sampled in Seconds gives m^2 s^-3. Summed over the
+// bins and multiplied by the bin width, it is the signal's mean square.
+template <typename T, typename B, typename X, typename Bt,
+          typename R = decltype(std::declval<SquareUnit<std::remove_const_t<T>,B>>() * std::declval<Unit<X,Bt>>())>
+UnitArray<typename R::rep, typename R::base> power_spectral_density(UnitSpan<T,B> values, const Unit<X,Bt>& dt, Window w = Window::hann)
+{
+	using Z = typename R::rep;
+	using BR = typename R::base;
+	const std::size_t n = values.size();
+	Z sum, sum2;
+	const std::vector<Z> p = detail::power_bins<Z>(values.values(), n, w, sum, sum2);
+
+	const Z k = static_cast<Z>(dt.value())
+	          * conversion_factor<Z, typename SquareUnit<std::remove_const_t<T>,B>::base, BR>()
+	          * conversion_factor<Z, Bt, BR>() / sum2;
+	UnitArray<Z,BR> psd(p.size());
+	for (std::size_t i = 0; i < p.size(); ++i)
+		psd[i] = R((detail::doubled(i, n) ? 2 : 1) * p[i] * k);
+	return psd;
+}
+
+} // sunit
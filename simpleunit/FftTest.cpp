@@ -0,0 +1,117 @@
+#include "simpleunit/Fft.h"
+#include <cmath>
+#include <complex>
+#include <random>
+#include "gtest/gtest.h"
+
+using namespace std;
+using namespace sunit;
+
+TEST(FftTest, MatchesDft)
+{
+	std::mt19937 rng(1);
+	std::uniform_real_distribution<double> uniform(-1, 1);
+	const double pi = std::acos(-1.0);
+
+	// Even and odd powers of two (the latter end with a radix-2 stage)
+	for (std::size_t n : {1, 2, 4, 8, 32, 64, 128, 1024}) {
+		std::vector<double> re(n), im(n);
+		for (std::size_t i = 0; i < n; ++i) {
+			re[i] = uniform(rng);
+			im[i] = uniform(rng);
+		}
+		const std::vector<double> re0 = re, im0 = im;
+
+		FftPlan<double> plan(n);
+		plan.forward(re.data(), im.data());
+		for (std::size_t k = 0; k < n; ++k) {
+			std::complex<double> sum = 0;
+			for (std::size_t i = 0; i < n; ++i)
+				sum += std::complex<double>(re0[i], im0[i]) * std::polar(1.0, -2 * pi * double(i * k % n) / n);
+			ASSERT_NEAR(sum.real(), re[k], 1e-9);
+			ASSERT_NEAR(sum.imag(), im[k], 1e-9);
+		}
+
+		plan.inverse(re.data(), im.data());
+		for (std::size_t i = 0; i < n; ++i) {
+			ASSERT_NEAR(re0[i], re[i], 1e-12);
+			ASSERT_NEAR(im0[i], im[i], 1e-12);
+		}
+
+		// A real signal matches the complex transform of the same values
+		std::vector<double> x(re0), zero(n, 0), rr(n / 2 + 1), ri(n / 2 + 1);
+		std::vector<double> cr(re0), ci(zero);
+		plan.forward(cr.data(), ci.data());
+		plan.forward_real(x.data(), rr.data(), ri.data());
+		for (std::size_t k = 0; k <= n / 2; ++k) {
+			ASSERT_NEAR(cr[k], rr[k], 1e-9);
+			ASSERT_NEAR(ci[k], ri[k], 1e-9);
+		}
+	}
+}
+
+TEST(FftTest, PlanCache)
+{
+	auto a = FftPlan<float>::get(256);
+	auto b = FftPlan<float>::get(256);
+	EXPECT_EQ(a.get(), b.get());
+	EXPECT_EQ(256u, a->size());
+	EXPECT_NE(a.get(), FftPlan<float>::get(512).get());
+}
+
+TEST(FftTest, FrequencyAxis)
+{
+	using namespace si;
+
+	auto f = frequency_axis(1024, Seconds(0.001f));
+	EXPECT_EQ(1, (std::is_same<Hertz, decltype(f)::value_type>::value));
+	ASSERT_EQ(513u, f.size());
+	EXPECT_FLOAT_EQ(0, f[0].value());
+	EXPECT_FLOAT_EQ(500, f[512].value());
+
+	// Sampled once a minute: cycles per minute
+	auto per_minute = frequency_axis(4, Minutes(1));
+	EXPECT_EQ(1, (std::is_same<Unit<float, Frequency<minute>>, decltype(per_minute)::value_type>::value));
+	EXPECT_FLOAT_EQ(0.5f, per_minute[2].value());
+	EXPECT_FLOAT_EQ(0.5f / 60, per_minute[2].as<Hertz>().value());
+}
+
+TEST(FftTest, Spectra)
+{
+	using namespace si;
+
+	// 3 m/s^2 at the centre of bin 100, plus a 0.5 m/s^2 offset
+	const std::size_t n = 1024;
+	const Seconds dt(0.001f);
+	const double pi = std::acos(-1.0);
+	UnitArray<float, Acceleration<meter, second>> a(n);
+	for (std::size_t i = 0; i < n; ++i)
+		a[i] = Meters_Second2(float(0.5 + 3 * std::sin(2 * pi * 100 * i / n)));
+
+	auto amplitude = amplitude_spectrum(make_span(a));
+	EXPECT_EQ(1, (std::is_same<Meters_Second2, decltype(amplitude)::value_type>::value));
+	EXPECT_NEAR(3, amplitude[100].value(), 1e-4);
+	EXPECT_NEAR(0.5, amplitude[0].value(), 1e-4);
+	EXPECT_NEAR(0, amplitude[300].value(), 1e-4);
+
+	auto power = power_spectrum(make_span(a), Window::rectangular);
+	EXPECT_EQ(-4, int(decltype(power)::value_type::base::dim::d2));
+	EXPECT_NEAR(4.5, power[100].value(), 1e-3);
+
+	// Parseval: the density integrates to the mean square
+	auto psd = power_spectral_density(make_span(a), dt, Window::rectangular);
+	using Psd = decltype(psd)::value_type;
+	EXPECT_EQ(1, (std::is_same<BaseUnit<Dim<2,-3>>, Psd::base>::value));
+	const float df = 1 / (n * dt.value());
+	double integral = 0;
+	for (const auto& p : psd)
+		integral += p.value() * df;
+	EXPECT_NEAR(0.25 + 4.5, integral, 1e-3);
+
+	// With a Hann window too
+	auto hann = power_spectral_density(make_span(a), dt);
+	integral = 0;
+	for (const auto& p : hann)
+		integral += p.value() * df;
+	EXPECT_NEAR(0.25 + 4.5, integral, 0.02);
+}
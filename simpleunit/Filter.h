@@ -0,0 +1,266 @@
+#pragma once
+
+#include "simpleunit/UnitSpan.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+namespace sunit {
+
+// Streaming filters over spans of units. Each filter keeps its state between calls to process, so
+// a signal may be pushed through in chunks of any size and the output is as if filtered in one go.
+//
+// Filters are dimensioned: the output is the input times the unit of the filter's coefficients
+// (FIR) or gain (IIR). Coefficients given as plain numbers leave the unit unchanged; coefficients
+// in Hertz make a differentiator, e.g. from Meters_Second2 to jerk.
+
+namespace detail
+{
+	template <typename T, typename B>
+	T raw_value(const Unit<T,B>& x) { return x.value(); }
+
+	template <typename T>
+	T raw_value(const T& x) { return x; }
+
+	// Samples of history a filter of taps coefficients keeps
+	inline std::size_t history_length(std::size_t taps)
+	{
+		if (taps == 0)
+			throw std::invalid_argument("FIR filter with no taps");
+		return taps - 1;
+	}
+
+	// The factor taking the product of input and coefficient values to the output base
+	template <typename Z, typename In, typename Coef, typename Out>
+	struct CoefficientFactor
+	{
+		static constexpr Z value() { return 1; }
+	};
+
+	template <typename Z, typename In, typename T, typename B, typename Out>
+	struct CoefficientFactor<Z, In, Unit<T,B>, Out>
+	{
+		static constexpr Z value()
+		{
+			return conversion_factor<Z, typename In::base, typename Out::base>() * conversion_factor<Z, B, typename Out::base>();
+		}
+	};
+}
+
+// The frequency as a fraction of the sample rate, for frequencies in any scale
+template <typename T, typename F1, typename B1, typename F2, typename B2>
+T normalized_frequency(const Unit<F1,B1>& frequency, const Unit<F2,B2>& rate)
+{
+	return unit_cast<Unit<T,B2>>(frequency).value() / static_cast<T>(rate.value());
+}
+
+// y[n] = sum_k h[k] x[n - k]
+template <typename In, typename Coef = typename In::rep>
+class FirFilter
+{
+public:
+	using input = In;
+	using coefficient = Coef;
+	using output = decltype(std::declval<In>() * std::declval<Coef>());
+	using rep = typename output::rep;
+
+	// Outputs computed together, tap by tap, so the inner loop is a multiply-add across the block
+	static constexpr std::size_t block_size = 256;
+
+	// Throws std::invalid_argument for no taps
+	explicit FirFilter(const std::vector<Coef>& taps)
+		: history_(detail::history_length(taps.size()), 0)
+	{
+		const rep k = detail::CoefficientFactor<rep, In, Coef, output>::value();
+		for (const Coef& h : taps)
+			taps_.push_back(static_cast<rep>(detail::raw_value(h)) * k);
+		scratch_.reserve(2 * taps_.size());
+	}
+
+	std::size_t size() const { return taps_.size(); }
+
+	// Filter the next chunk of the signal. `in` and `out` must not overlap
+	void process(UnitSpan<const typename In::rep, typename In::base> in, UnitSpan<rep, typename output::base> out)
+	{
+		using X = typename In::rep;
+		assert(in.size() == out.size());
+		const std::size_t n = in.size();
+		const std::size_t m = taps_.size();
+		const X* x = in.values();
+		rep* y = out.values();
+		const rep* h = taps_.data();
+
+		// Outputs whose window reaches back before this chunk, from the history and the first inputs
+		const std::size_t head = std::min(n, m - 1);
+		scratch_.assign(history_.begin(), history_.end());
+		scratch_.insert(scratch_.end(), x, x + head);
+		for (std::size_t i = 0; i < head; ++i) {
+			rep sum = 0;
+			for (std::size_t k = 0; k < m; ++k)
+				sum += h[k] * scratch_[m - 1 + i - k];
+			y[i] = sum;
+		}
+
+		for (std::size_t begin = head; begin < n; begin += block_size) {
+			const std::size_t count = std::min(block_size, n - begin);
+			rep acc[block_size] = {};
+			for (std::size_t k = 0; k < m; ++k) {
+				const rep hk = h[k];
+				const X* xk = x + begin - k;
+				for (std::size_t i = 0; i < count; ++i)
+					acc[i] += hk * static_cast<rep>(xk[i]);
+			}
+			std::copy(acc, acc + count, y + begin);
+		}
+
+		// Keep the last m - 1 inputs
+		if (n >= m - 1)
+			history_.assign(x + n - (m - 1), x + n);
+		else {
+			history_.erase(history_.begin(), history_.begin() + n);
+			history_.insert(history_.end(), x, x + n);
+		}
+	}
+
+	output operator()(const In& x)
+	{
+		output y;
+		process(UnitSpan<const typename In::rep, typename In::base>(&x, 1), UnitSpan<rep, typename output::base>(&y, 1));
+		return y;
+	}
+
+	void reset() { std::fill(history_.begin(), history_.end(), rep(0)); }
+
+private:
+	std::vector<rep> taps_;
+	std::vector<rep> history_;
+	std::vector<rep> scratch_;
+};
+
+template <typename In, typename Coef>
+constexpr std::size_t FirFilter<In, Coef>::block_size;
+
+// A windowed-sinc (Hamming) low-pass filter with unit gain at DC
+template <typename In, typename F1, typename B1, typename F2, typename B2>
+FirFilter<In> fir_lowpass(const Unit<F1,B1>& cutoff, const Unit<F2,B2>& rate, std::size_t taps)
+{
+	using T = typename In::rep;
+	assert(taps > 0);
+	const T pi = static_cast<T>(std::acos(-1.0));
+	const T fc = normalized_frequency<T>(cutoff, rate);
+	const T centre = static_cast<T>(taps - 1) / 2;
+
+	std::vector<T> h(taps);
+	T sum = 0;
+	for (std::size_t i = 0; i < taps; ++i) {
+		const T t = static_cast<T>(i) - centre;
+		const T sinc = t == 0 ? 2 * fc : std::sin(2 * pi * fc * t) / (pi * t);
+		const T window = taps > 1 ? T(0.54) - T(0.46) * std::cos(2 * pi * static_cast<T>(i) / static_cast<T>(taps - 1)) : T(1);
+		h[i] = sinc * window;
+		sum += h[i];
+	}
+	for (T& x : h)
+		x /= sum;
+	return FirFilter<In>(h);
+}
+
+
+// A second-order section, normalised so that a0 = 1:
+// H(z) = (b0 + b1 z^-1 + b2 z^-2) / (1 + a1 z^-1 + a2 z^-2)
+template <typename T>
+struct Biquad
+{
+	T b0, b1, b2, a1, a2;
+};
+
+// Low- and high-pass sections from the Audio EQ Cookbook (R. Bristow-Johnson)
+
+template <typename T, typename F1, typename B1, typename F2, typename B2>
+Biquad<T> biquad_lowpass(const Unit<F1,B1>& cutoff, const Unit<F2,B2>& rate, T q = T(0.7071067811865476))
+{
+	const T w = 2 * static_cast<T>(std::acos(-1.0)) * normalized_frequency<T>(cutoff, rate);
+	const T alpha = std::sin(w) / (2 * q);
+	const T c = std::cos(w);
+	const T a0 = 1 + alpha;
+	return Biquad<T>{(1 - c) / 2 / a0, (1 - c) / a0, (1 - c) / 2 / a0, -2 * c / a0, (1 - alpha) / a0};
+}
+
+template <typename T, typename F1, typename B1, typename F2, typename B2>
+Biquad<T> biquad_highpass(const Unit<F1,B1>& cutoff, const Unit<F2,B2>& rate, T q = T(0.7071067811865476))
+{
+	const T w = 2 * static_cast<T>(std::acos(-1.0)) * normalized_frequency<T>(cutoff, rate);
+	const T alpha = std::sin(w) / (2 * q);
+	const T c = std::cos(w);
+	const T a0 = 1 + alpha;
+	return Biquad<T>{(1 + c) / 2 / a0, -(1 + c) / a0, (1 + c) / 2 / a0, -2 * c / a0, (1 - alpha) / a0};
+}
+
+// A cascade of biquads (in transposed direct form II) and an overall gain of unit Gain. Each chunk
+// is run through one section at a time, so a section's coefficients and state stay in registers
+template <typename In, typename Gain = typename In::rep>
+class BiquadCascade
+{
+public:
+	using input = In;
+	using gain_type = Gain;
+	using output = decltype(std::declval<In>() * std::declval<Gain>());
+	using rep = typename output::rep;
+
+	explicit BiquadCascade(std::vector<Biquad<rep>> sections, const Gain& gain = Gain(1))
+		: sections_(std::move(sections)), state_(sections_.size()),
+		  gain_(static_cast<rep>(detail::raw_value(gain)) * detail::CoefficientFactor<rep, In, Gain, output>::value())
+	{
+	}
+
+	std::size_t size() const { return sections_.size(); }
+
+	// Filter the next chunk of the signal. `in` and `out` may be the same span
+	void process(UnitSpan<const typename In::rep, typename In::base> in, UnitSpan<rep, typename output::base> out)
+	{
+		assert(in.size() == out.size());
+		const std::size_t n = in.size();
+		const auto* x = in.values();
+		rep* y = out.values();
+
+		for (std::size_t i = 0; i < n; ++i)
+			y[i] = gain_ * static_cast<rep>(x[i]);
+
+		for (std::size_t s = 0; s < sections_.size(); ++s) {
+			const Biquad<rep> c = sections_[s];
+			rep z1 = state_[s].z1, z2 = state_[s].z2;
+			for (std::size_t i = 0; i < n; ++i) {
+				const rep v = y[i];
+				const rep w = c.b0 * v + z1;
+				z1 = c.b1 * v - c.a1 * w + z2;
+				z2 = c.b2 * v - c.a2 * w;
+				y[i] = w;
+			}
+			state_[s].z1 = z1;
+			state_[s].z2 = z2;
+		}
+	}
+
+	output operator()(const In& x)
+	{
+		output y;
+		process(UnitSpan<const typename In::rep, typename In::base>(&x, 1), UnitSpan<rep, typename output::base>(&y, 1));
+		return y;
+	}
+
+	void reset() { std::fill(state_.begin(), state_.end(), State()); }
+
+private:
+	struct State
+	{
+		rep z1 = 0;
+		rep z2 = 0;
+	};
+
+	std::vector<Biquad<rep>> sections_;
+	std::vector<State> state_;
+	rep gain_;
+};
+
+} // sunit
@@ -0,0 +1,147 @@
+#include "simpleunit/Filter.h"
+#include <cmath>
+#include "gtest/gtest.h"
+
+using namespace std;
+using namespace sunit;
+
+namespace
+{
+	// A sine of the given frequency sampled at the given rate
+	sunit::UnitArray<float, Acceleration<si::meter, si::second>> sine(float frequency, float rate, std::size_t n)
+	{
+		const double pi = std::acos(-1.0);
+		sunit::UnitArray<float, Acceleration<si::meter, si::second>> x(n);
+		for (std::size_t i = 0; i < n; ++i)
+			x[i] = si::Meters_Second2(float(std::sin(2 * pi * frequency * i / rate)));
+		return x;
+	}
+
+	template <typename U>
+	float peak(const std::vector<U>& x, std::size_t from)
+	{
+		float p = 0;
+		for (std::size_t i = from; i < x.size(); ++i)
+			p = std::max(p, std::abs(x[i].value()));
+		return p;
+	}
+}
+
+TEST(FilterTest, MovingAverage)
+{
+	using namespace si;
+
+	FirFilter<Meters_Second2> average({0.25f, 0.25f, 0.25f, 0.25f});
+	EXPECT_EQ(1, (std::is_same<Meters_Second2, decltype(average)::output>::value));
+	EXPECT_THROW(FirFilter<Meters_Second2>(std::vector<float>()), std::invalid_argument);
+
+	UnitArray<float, Acceleration<meter, second>> x = {Meters_Second2(4), Meters_Second2(8), Meters_Second2(4), Meters_Second2(8),
+	                                                   Meters_Second2(4), Meters_Second2(8)};
+	UnitArray<float, Acceleration<meter, second>> y(x.size());
+	average.process(make_span(x), make_span(y));
+	EXPECT_FLOAT_EQ(1, y[0].value());
+	EXPECT_FLOAT_EQ(3, y[1].value());
+	EXPECT_FLOAT_EQ(4, y[2].value());
+	EXPECT_FLOAT_EQ(6, y[3].value());
+	EXPECT_FLOAT_EQ(6, y[5].value());
+}
+
+TEST(FilterTest, Differentiator)
+{
+	using namespace si;
+
+	// Taps in Hertz: the output is the rate of change of the input
+	const Hertz rate(100000);
+	FirFilter<Meters_Second, Hertz> diff({rate, rate * -1.0f});
+	using Out = decltype(diff)::output;
+	EXPECT_EQ(1, (std::is_same<Meters_Second2, Out>::value));
+
+	UnitArray<float, Velocity<meter, second>> v = {Meters_Second(0), Meters_Second(1), Meters_Second(3)};
+	UnitArray<float, Acceleration<meter, second>> a(v.size());
+	diff.process(make_span(v), make_span(a));
+	EXPECT_FLOAT_EQ(0, a[0].value());
+	EXPECT_FLOAT_EQ(100000, a[1].value());
+	EXPECT_FLOAT_EQ(200000, a[2].value());
+
+	// Taps in kilohertz are converted
+	FirFilter<Meters_Second, Kilohertz> diff_khz({Kilohertz(100), Kilohertz(-100)});
+	EXPECT_EQ(1, (std::is_same<Unit<float, BaseUnit<Dim<1,-2>, meter, std::milli>>, decltype(diff_khz)::output>::value));
+}
+
+TEST(FilterTest, StreamingFir)
+{
+	using namespace si;
+
+	const std::size_t n = 5000;
+	auto x = sine(3000, 100000, n);
+	auto lowpass = fir_lowpass<Meters_Second2>(Kilohertz(1), Hertz(100000), 101);
+	EXPECT_EQ(101u, lowpass.size());
+
+	UnitArray<float, Acceleration<meter, second>> whole(n);
+	lowpass.process(make_span(x), make_span(whole));
+
+	// The same signal in uneven chunks, and one sample at a time
+	lowpass.reset();
+	UnitArray<float, Acceleration<meter, second>> chunked(n);
+	std::size_t at = 0;
+	for (std::size_t chunk : {1, 7, 50, 100, 300, 1000}) {
+		lowpass.process(make_span(x).subspan(at, chunk), make_span(chunked).subspan(at, chunk));
+		at += chunk;
+	}
+	for (; at < n; ++at)
+		chunked[at] = lowpass(x[at]);
+	for (std::size_t i = 0; i < n; ++i)
+		ASSERT_NEAR(whole[i].value(), chunked[i].value(), 1e-6);
+
+	// Above the cutoff, the sine is attenuated
+	EXPECT_LT(peak(whole, 200), 0.05f);
+}
+
+TEST(FilterTest, BiquadCascade)
+{
+	using namespace si;
+
+	const Hertz rate(100000);
+	auto section = biquad_lowpass<float>(Kilohertz(1), rate);
+	BiquadCascade<Meters_Second2> lowpass({section, section});
+
+	// Passes a low frequency, attenuates a high one
+	const std::size_t n = 20000;
+	auto low = sine(100, 100000, n);
+	auto high = sine(20000, 100000, n);
+	UnitArray<float, Acceleration<meter, second>> y(n);
+	lowpass.process(make_span(low), make_span(y));
+	EXPECT_NEAR(1, peak(y, n / 2), 0.02);
+	lowpass.reset();
+	lowpass.process(make_span(high), make_span(y));
+	EXPECT_LT(peak(y, n / 2), 0.01f);
+
+	// Chunked, in place, matches one go
+	lowpass.reset();
+	UnitArray<float, Acceleration<meter, second>> whole(n);
+	lowpass.process(make_span(low), make_span(whole));
+	lowpass.reset();
+	for (std::size_t at = 0; at < n; at += 333) {
+		auto chunk = make_span(low).subspan(at, std::min<std::size_t>(333, n - at));
+		lowpass.process(chunk, chunk);
+	}
+	for (std::size_t i = 0; i < n; ++i)
+		ASSERT_FLOAT_EQ(whole[i].value(), low[i].value());
+
+	// A high-pass section rejects DC
+	BiquadCascade<Meters_Second2> highpass({biquad_highpass<float>(Hertz(10), rate)});
+	Meters_Second2 out;
+	for (int i = 0; i < 100000; ++i)
+		out = highpass(Meters_Second2(1));
+	EXPECT_NEAR(0, out.value(), 1e-3);
+}
+
+TEST(FilterTest, DimensionedGain)
+{
+	using namespace si;
+
+	// A gain in kilograms turns acceleration into force
+	BiquadCascade<Meters_Second2, Kilograms> force({Biquad<float>{1, 0, 0, 0, 0}}, Kilograms(2));
+	EXPECT_EQ(1, (std::is_same<KilogramMeters_Second2, decltype(force)::output>::value));
+	EXPECT_FLOAT_EQ(6, force(Meters_Second2(3)).value());
+}
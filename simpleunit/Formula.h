@@ -0,0 +1,454 @@
+#pragma once
+
+#include "simpleunit/DynamicUnit.h"
+#include "simpleunit/Parallel.h"
+#include "simpleunit/UnitSpan.h"
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace sunit {
+
+// Formulas over columns of units, parsed at run time, e.g.
+//
+//     using Joules = Unit<double, BaseUnit<Dim<2,-2,1>>>;
+//     Formula<Joules, Kilograms, Meters_Second> energy("0.5 * mass * speed^2", {{"mass", "speed"}});
+//     auto e = energy(data);   // data is a UnitSoA<Kilograms, Meters_Second>
+//
+// Formulas have + - * /, integer powers (^), parentheses, numbers (dimensionless), and the
+// functions sqrt, abs, min and max. Dimensions are checked once, when the formula is compiled,
+// by the rules of Dim: + - min and max need operands of one dimension, * and / add and subtract
+// exponents, ^n multiplies them, and sqrt halves them, which must be even. So must the result
+// match the unit asked for.
+//
+// Compiling folds every constant and every scale conversion into coefficients: a value is tracked
+// as a coefficient times a register, so `0.5 * mass` costs nothing at run time, and sums of unlike
+// scales cost one multiply. What remains is a short program of element-wise operations, run over
+// blocks of rows in double precision, with the final conversion fused into the store.
+
+namespace detail
+{
+	enum class FormulaOp { load, constant, add, add_scaled, add_constant, mul, div, reciprocal, scale, sqrt, abs, min, max };
+
+	struct FormulaInstruction
+	{
+		FormulaOp op;
+		int dst;
+		int a;
+		int b;
+		double k;
+	};
+
+	// Load a block of a column into doubles
+	using FormulaLoad = void (*)(const void* column, std::size_t offset, std::size_t n, double* out);
+
+	template <typename T>
+	void formula_load(const void* column, std::size_t offset, std::size_t n, double* out)
+	{
+		const T* x = static_cast<const T*>(column) + offset;
+		for (std::size_t i = 0; i < n; ++i)
+			out[i] = static_cast<double>(x[i]);
+	}
+
+	// A compiled formula over variables of known units
+	class FormulaProgram
+	{
+	public:
+		static constexpr std::size_t block = 1024;
+
+		FormulaProgram(const std::string& text, const std::vector<std::string>& names, const std::vector<DynamicUnit>& units,
+		               const DynamicUnit& result)
+			: text_(text), names_(names), units_(units), variable_reg_(names.size(), -1)
+		{
+			assert(names.size() == units.size());
+			Value v = expression();
+			skip_space();
+			if (pos_ != text_.size())
+				fail("unexpected '" + std::string(1, text_[pos_]) + "'");
+			if (!same_dimension(v, result))
+				fail("result is not of the unit asked for", 0);
+			// Output = coefficient * register, in the result's scale
+			factor_ = v.coef / result.scale;
+			output_ = v.reg;
+		}
+
+		// Evaluate rows [begin, end) of the columns into out, as T
+		template <typename T>
+		void evaluate(const void* const* columns, const FormulaLoad* loads, std::size_t begin, std::size_t end,
+		              T* out, std::vector<double>& regs) const
+		{
+			regs.resize(std::max<std::size_t>(1, registers_) * block);
+			for (std::size_t b = begin; b < end; b += block) {
+				const std::size_t n = std::min(block, end - b);
+				run(columns, loads, b, n, regs.data());
+				if (output_ < 0) {
+					std::fill(out + b, out + b + n, static_cast<T>(factor_));
+					continue;
+				}
+				const double* r = regs.data() + output_ * block;
+				const double f = factor_;
+				T* y = out + b;
+				if (f == 1)
+					for (std::size_t i = 0; i < n; ++i) y[i] = static_cast<T>(r[i]);
+				else
+					for (std::size_t i = 0; i < n; ++i) y[i] = static_cast<T>(r[i] * f);
+			}
+		}
+
+		std::size_t instructions() const { return program_.size(); }
+
+	private:
+		// The value of a subexpression: coef * register, or just coef if reg < 0
+		struct Value
+		{
+			int reg;
+			double coef;
+			int dim[3];
+		};
+
+		void run(const void* const* columns, const FormulaLoad* loads, std::size_t offset, std::size_t n, double* regs) const
+		{
+			for (const FormulaInstruction& in : program_) {
+				double* d = regs + in.dst * block;
+				const double* a = regs + in.a * block;
+				const double* b = regs + in.b * block;
+				const double k = in.k;
+				switch (in.op) {
+				case FormulaOp::load: loads[in.a](columns[in.a], offset, n, d); break;
+				case FormulaOp::constant: std::fill(d, d + n, k); break;
+				case FormulaOp::add: for (std::size_t i = 0; i < n; ++i) d[i] = a[i] + b[i]; break;
+				case FormulaOp::add_scaled: for (std::size_t i = 0; i < n; ++i) d[i] = a[i] + k * b[i]; break;
+				case FormulaOp::add_constant: for (std::size_t i = 0; i < n; ++i) d[i] = a[i] + k; break;
+				case FormulaOp::mul: for (std::size_t i = 0; i < n; ++i) d[i] = a[i] * b[i]; break;
+				case FormulaOp::div: for (std::size_t i = 0; i < n; ++i) d[i] = a[i] / b[i]; break;
+				case FormulaOp::reciprocal: for (std::size_t i = 0; i < n; ++i) d[i] = 1 / a[i]; break;
+				case FormulaOp::scale: for (std::size_t i = 0; i < n; ++i) d[i] = k * a[i]; break;
+				case FormulaOp::sqrt: for (std::size_t i = 0; i < n; ++i) d[i] = std::sqrt(a[i]); break;
+				case FormulaOp::abs: for (std::size_t i = 0; i < n; ++i) d[i] = std::abs(a[i]); break;
+				case FormulaOp::min: for (std::size_t i = 0; i < n; ++i) d[i] = std::min(a[i], b[i]); break;
+				case FormulaOp::max: for (std::size_t i = 0; i < n; ++i) d[i] = std::max(a[i], b[i]); break;
+				}
+			}
+		}
+
+		[[noreturn]] void fail(const std::string& what) const { fail(what, pos_); }
+		[[noreturn]] void fail(const std::string& what, std::size_t pos) const
+		{
+			throw std::invalid_argument("formula '" + text_ + "' at " + std::to_string(pos) + ": " + what);
+		}
+
+		static bool same_dimension(const Value& v, const DynamicUnit& u)
+		{
+			return v.dim[0] == u.dim[0] && v.dim[1] == u.dim[1] && v.dim[2] == u.dim[2];
+		}
+
+		static bool same_dimension(const Value& a, const Value& b)
+		{
+			return a.dim[0] == b.dim[0] && a.dim[1] == b.dim[1] && a.dim[2] == b.dim[2];
+		}
+
+		static Value constant(double x) { return Value{-1, x, {0, 0, 0}}; }
+
+		int emit(FormulaOp op, int a, int b = 0, double k = 0)
+		{
+			program_.push_back(FormulaInstruction{op, static_cast<int>(registers_), a, b, k});
+			return static_cast<int>(registers_++);
+		}
+
+		// The value held in a register with coefficient 1
+		int materialize(const Value& v)
+		{
+			if (v.reg < 0) return emit(FormulaOp::constant, 0, 0, v.coef);
+			if (v.coef == 1) return v.reg;
+			return emit(FormulaOp::scale, v.reg, 0, v.coef);
+		}
+
+		Value add(Value a, Value b, std::size_t pos)
+		{
+			if (!same_dimension(a, b))
+				fail("cannot add or subtract different dimensions", pos);
+			if (a.reg < 0 && b.reg < 0)
+				return Value{-1, a.coef + b.coef, {a.dim[0], a.dim[1], a.dim[2]}};
+			if (a.reg < 0)
+				std::swap(a, b);
+			if (a.coef == 0)
+				return b;
+			// a.coef * (a + (b.coef / a.coef) * b)
+			const double k = b.coef / a.coef;
+			const int reg = b.reg < 0 ? emit(FormulaOp::add_constant, a.reg, 0, k)
+			              : k == 1 ? emit(FormulaOp::add, a.reg, b.reg)
+			              : emit(FormulaOp::add_scaled, a.reg, b.reg, k);
+			return Value{reg, a.coef, {a.dim[0], a.dim[1], a.dim[2]}};
+		}
+
+		Value multiply(const Value& a, const Value& b, bool divide)
+		{
+			Value v;
+			for (int i = 0; i < 3; ++i)
+				v.dim[i] = divide ? a.dim[i] - b.dim[i] : a.dim[i] + b.dim[i];
+			v.coef = divide ? a.coef / b.coef : a.coef * b.coef;
+			if (a.reg < 0 && b.reg < 0) v.reg = -1;
+			else if (b.reg < 0) v.reg = a.reg;
+			else if (a.reg < 0) v.reg = divide ? emit(FormulaOp::reciprocal, b.reg) : b.reg;
+			else v.reg = emit(divide ? FormulaOp::div : FormulaOp::mul, a.reg, b.reg);
+			return v;
+		}
+
+		Value power(const Value& a, int n)
+		{
+			Value v;
+			for (int i = 0; i < 3; ++i)
+				v.dim[i] = a.dim[i] * n;
+			v.coef = std::pow(a.coef, n);
+			if (a.reg < 0 || n == 0) {
+				v.reg = -1;
+				if (n == 0) v.coef = 1;
+				return v;
+			}
+			// Square and multiply
+			int result = -1;
+			int base = a.reg;
+			for (int e = n < 0 ? -n : n; e > 0; e >>= 1) {
+				if (e & 1)
+					result = result < 0 ? base : emit(FormulaOp::mul, result, base);
+				if (e > 1)
+					base = emit(FormulaOp::mul, base, base);
+			}
+			v.reg = n < 0 ? emit(FormulaOp::reciprocal, result) : result;
+			return v;
+		}
+
+		void skip_space()
+		{
+			while (pos_ < text_.size() && std::isspace(static_cast<unsigned char>(text_[pos_]))) ++pos_;
+		}
+
+		bool accept(char c)
+		{
+			skip_space();
+			if (pos_ < text_.size() && text_[pos_] == c) {
+				++pos_;
+				return true;
+			}
+			return false;
+		}
+
+		void expect(char c)
+		{
+			if (!accept(c))
+				fail(std::string("expected '") + c + "'");
+		}
+
+		Value expression()
+		{
+			Value v = term();
+			for (;;) {
+				const std::size_t pos = pos_;
+				if (accept('+'))
+					v = add(v, term(), pos);
+				else if (accept('-')) {
+					Value t = term();
+					t.coef = -t.coef;
+					v = add(v, t, pos);
+				}
+				else
+					return v;
+			}
+		}
+
+		Value term()
+		{
+			Value v = unary();
+			for (;;) {
+				if (accept('*'))
+					v = multiply(v, unary(), false);
+				else if (accept('/'))
+					v = multiply(v, unary(), true);
+				else
+					return v;
+			}
+		}
+
+		Value unary()
+		{
+			if (accept('-')) {
+				Value v = unary();
+				v.coef = -v.coef;
+				return v;
+			}
+			if (accept('+'))
+				return unary();
+			return factor();
+		}
+
+		Value factor()
+		{
+			Value v = primary();
+			if (!accept('^'))
+				return v;
+			skip_space();
+			const char* begin = text_.c_str() + pos_;
+			char* end;
+			const long n = std::strtol(begin, &end, 10);
+			if (end == begin || (*end == '.'))
+				fail("exponents must be integers");
+			pos_ += end - begin;
+			return power(v, static_cast<int>(n));
+		}
+
+		Value primary()
+		{
+			skip_space();
+			if (pos_ == text_.size())
+				fail("unexpected end");
+			const char c = text_[pos_];
+			if (accept('(')) {
+				Value v = expression();
+				expect(')');
+				return v;
+			}
+			if (std::isdigit(static_cast<unsigned char>(c)) || c == '.') {
+				const char* begin = text_.c_str() + pos_;
+				char* end;
+				const double x = std::strtod(begin, &end);
+				if (end == begin)
+					fail("bad number");
+				pos_ += end - begin;
+				return constant(x);
+			}
+			if (!std::isalpha(static_cast<unsigned char>(c)) && c != '_')
+				fail("unexpected '" + std::string(1, c) + "'");
+
+			const std::size_t start = pos_;
+			while (pos_ < text_.size() && (std::isalnum(static_cast<unsigned char>(text_[pos_])) || text_[pos_] == '_')) ++pos_;
+			const std::string name = text_.substr(start, pos_ - start);
+			if (accept('('))
+				return call(name, start);
+
+			const auto it = std::find(names_.begin(), names_.end(), name);
+			if (it == names_.end())
+				fail("unknown name '" + name + "'", start);
+			const std::size_t i = static_cast<std::size_t>(it - names_.begin());
+			if (variable_reg_[i] < 0)
+				variable_reg_[i] = emit(FormulaOp::load, static_cast<int>(i));
+			return Value{variable_reg_[i], units_[i].scale, {units_[i].dim[0], units_[i].dim[1], units_[i].dim[2]}};
+		}
+
+		Value call(const std::string& name, std::size_t start)
+		{
+			Value a = expression();
+			if (name == "sqrt" || name == "abs") {
+				expect(')');
+				Value v = a;
+				if (name == "abs") {
+					v.coef = std::abs(a.coef);
+					if (a.reg >= 0) v.reg = emit(FormulaOp::abs, a.reg);
+					return v;
+				}
+				for (int i = 0; i < 3; ++i) {
+					if (a.dim[i] % 2 != 0)
+						fail("square root of a dimension with an odd exponent", start);
+					v.dim[i] = a.dim[i] / 2;
+				}
+				if (a.reg < 0) {
+					v.coef = std::sqrt(a.coef);
+					return v;
+				}
+				// sqrt(k x) = sqrt(|k|) sqrt(sign(k) x)
+				const int reg = a.coef < 0 ? emit(FormulaOp::scale, a.reg, 0, -1) : a.reg;
+				v.reg = emit(FormulaOp::sqrt, reg);
+				v.coef = std::sqrt(std::abs(a.coef));
+				return v;
+			}
+			if (name == "min" || name == "max") {
+				expect(',');
+				Value b = expression();
+				expect(')');
+				if (!same_dimension(a, b))
+					fail("cannot compare different dimensions", start);
+				const bool is_min = name == "min";
+				if (a.reg < 0 && b.reg < 0)
+					return Value{-1, is_min ? std::min(a.coef, b.coef) : std::max(a.coef, b.coef), {a.dim[0], a.dim[1], a.dim[2]}};
+				const int reg = emit(is_min ? FormulaOp::min : FormulaOp::max, materialize(a), materialize(b));
+				return Value{reg, 1, {a.dim[0], a.dim[1], a.dim[2]}};
+			}
+			fail("unknown function '" + name + "'", start);
+		}
+
+		std::string text_;
+		std::size_t pos_ = 0;
+		std::vector<std::string> names_;
+		std::vector<DynamicUnit> units_;
+		std::vector<int> variable_reg_;
+		std::vector<FormulaInstruction> program_;
+		std::size_t registers_ = 0;
+		int output_ = -1;
+		double factor_ = 1;
+	};
+
+	constexpr std::size_t FormulaProgram::block;
+}
+
+// A formula over the columns of a UnitSoA<Units...>, named in order, giving values of unit Result.
+// Throws std::invalid_argument on construction if the formula cannot be parsed, names an unknown
+// column, or mixes dimensions
+template <typename Result, typename... Units>
+class Formula
+{
+public:
+	using result_type = Result;
+
+	Formula(const std::string& text, const std::array<std::string, sizeof...(Units)>& names)
+		: program_(text, std::vector<std::string>(names.begin(), names.end()),
+		           std::vector<DynamicUnit>{dynamic_unit<typename Units::base>()...},
+		           dynamic_unit<typename Result::base>()),
+		  loads_{{&detail::formula_load<typename Units::rep>...}}
+	{
+	}
+
+	// Evaluate every row into out, in parallel over groups of blocks (a grain, if given, is in rows)
+	template <typename Alloc, typename T, typename B>
+	void evaluate(const BasicUnitSoA<Alloc, Units...>& columns, UnitSpan<T,B> out, const parallel::Options& options = parallel::Options()) const
+	{
+		static_assert(std::is_same<Unit<T,B>, Result>::value, "output must be of the formula's result unit");
+		assert(out.size() == columns.size());
+		const std::array<const void*, sizeof...(Units)> data = column_data(columns, std::index_sequence_for<Units...>());
+		const std::size_t block = detail::FormulaProgram::block;
+		T* y = out.values();
+		const std::size_t n = columns.size();
+		const std::size_t grain = options.grain ? (options.grain + block - 1) / block : 4;
+		parallel::for_range((n + block - 1) / block, grain, [&](std::size_t b0, std::size_t b1) {
+			std::vector<double> regs;
+			program_.evaluate(data.data(), loads_.data(), b0 * block, std::min(n, b1 * block), y, regs);
+		}, options);
+	}
+
+	template <typename Alloc>
+	UnitArray<typename Result::rep, typename Result::base> operator()(const BasicUnitSoA<Alloc, Units...>& columns) const
+	{
+		UnitArray<typename Result::rep, typename Result::base> out(columns.size());
+		evaluate(columns, make_span(out));
+		return out;
+	}
+
+	// Operations run per block, after folding
+	std::size_t instructions() const { return program_.instructions(); }
+
+private:
+	template <typename Alloc, std::size_t... I>
+	static std::array<const void*, sizeof...(Units)> column_data(const BasicUnitSoA<Alloc, Units...>& columns, std::index_sequence<I...>)
+	{
+		return {{static_cast<const void*>(columns.template column<I>().values())...}};
+	}
+
+	detail::FormulaProgram program_;
+	std::array<detail::FormulaLoad, sizeof...(Units)> loads_;
+};
+
+} // sunit
@@ -0,0 +1,87 @@
+#include "simpleunit/Formula.h"
+#include <cmath>
+#include <stdexcept>
+#include "gtest/gtest.h"
+
+using namespace std;
+using namespace sunit;
+
+namespace
+{
+	using Joules = Unit<double, BaseUnit<Dim<2,-2,1>>>;
+	using Kilometers_Hour = Unit<float, Velocity<std::kilo, si::hour>>;
+	using Grams = Unit<double, Mass<std::milli>>;
+	using Data = UnitSoA<si::Kilograms, Kilometers_Hour, si::Seconds, Grams>;
+
+	Data data(size_t n)
+	{
+		Data d;
+		for (size_t i = 0; i < n; ++i)
+			d.push_back(si::Kilograms(1 + i % 7), Kilometers_Hour(float(i % 100)), si::Seconds(0.5f + i % 3), Grams(250.0 * (i % 5)));
+		return d;
+	}
+
+	const array<string, 4> names = {{"mass", "speed", "time", "payload"}};
+}
+
+TEST(FormulaTest, Energy)
+{
+	// Scales and the constant fold into one factor, so this is just two multiplies
+	Formula<Joules, si::Kilograms, Kilometers_Hour, si::Seconds, Grams> energy("0.5 * mass * speed^2", names);
+	EXPECT_EQ(4u, energy.instructions());  // two loads, speed^2 and the product
+
+	const Data d = data(5000);
+	const auto e = energy(d);
+	ASSERT_EQ(d.size(), e.size());
+	for (size_t i = 0; i < d.size(); i += 37) {
+		const double m = d.column<0>()[i].value();
+		const double v = d.column<1>()[i].value() / 3.6;
+		EXPECT_NEAR(0.5 * m * v * v, e[i].value(), 1e-9 * (1 + 0.5 * m * v * v));
+	}
+}
+
+TEST(FormulaTest, Arithmetic)
+{
+	using namespace si;
+	using F = Unit<double, Mass<kg>>;
+	const Data d = data(3000);
+
+	// Sums of unlike scales of one dimension, subtraction, negation and constants
+	Formula<F, Kilograms, Kilometers_Hour, Seconds, Grams> total("mass + payload - -(2 * 3) * mass / 2 - 0.5 * (2 * mass) + payload * 0", names);
+	// Powers, quotients and functions, in another output scale
+	Formula<Unit<float, Velocity<meter, minute>>, Kilograms, Kilometers_Hour, Seconds, Grams> speed(
+		"sqrt(speed^2 * time^-2 * time^2) + abs(-speed) * 0 + max(speed, 10 * (speed / time) * time / 10) - min(speed, speed)",
+		names);
+
+	const auto t = total(d);
+	const auto s = speed(d);
+	for (size_t i = 0; i < d.size(); i += 11) {
+		const double m = d.column<0>()[i].value();
+		const double p = d.column<3>()[i].value() / 1000;
+		EXPECT_NEAR(m + p + 3 * m - m, t[i].value(), 1e-9);
+		const double v = d.column<1>()[i].value() * 1000.0 / 60;  // m/min
+		EXPECT_NEAR(v, s[i].value(), 1e-3);
+	}
+
+	// Constant formulas
+	Formula<Unit<double, BaseUnit<Dim<0>>>, Kilograms, Kilometers_Hour, Seconds, Grams> half("(1 + 2) ^ 2 / 18", names);
+	EXPECT_DOUBLE_EQ(0.5, half(d)[2999].value());
+}
+
+TEST(FormulaTest, Errors)
+{
+	using namespace si;
+	using Any = Formula<Unit<double, Mass<kg>>, Kilograms, Kilometers_Hour, Seconds, Grams>;
+
+	EXPECT_NO_THROW(Any("mass", names));
+	EXPECT_THROW(Any("speed", names), invalid_argument);         // wrong result
+	EXPECT_THROW(Any("mass + time", names), invalid_argument);   // mixed dimensions
+	EXPECT_THROW(Any("max(mass, time)", names), invalid_argument);
+	EXPECT_THROW(Any("sqrt(mass)", names), invalid_argument);    // odd exponent
+	EXPECT_THROW(Any("mass ^ 1.5", names), invalid_argument);
+	EXPECT_THROW(Any("volume", names), invalid_argument);
+	EXPECT_THROW(Any("exp(mass)", names), invalid_argument);
+	EXPECT_THROW(Any("(mass", names), invalid_argument);
+	EXPECT_THROW(Any("mass mass", names), invalid_argument);
+	EXPECT_THROW(Any("mass * ", names), invalid_argument);
+}
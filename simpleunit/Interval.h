@@ -0,0 +1,372 @@
+#pragma once
+
+#include "simpleunit/UnitSpan.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+namespace sunit {
+
+template <typename T>
+T next_down(const T& x) { return std::nextafter(x, -std::numeric_limits<T>::infinity()); }
+
+template <typename T>
+T next_up(const T& x) { return std::nextafter(x, std::numeric_limits<T>::infinity()); }
+
+// Directed rounding of single operations without touching the floating-point environment.
+// The rounding error of each operation is recovered exactly (TwoSum, or an FMA for * and /)
+// and the nearest result is stepped one ulp only when it lies on the wrong side.
+namespace rounding
+{
+	template <typename T>
+	T add_error(const T& a, const T& b, const T& s)
+	{
+		const T bb = s - a;
+		return (a - (s - bb)) + (b - bb);
+	}
+
+	template <typename T> T add_down(const T& a, const T& b) { const T s = a + b; return add_error(a, b, s) < 0 ? next_down(s) : s; }
+	template <typename T> T add_up(const T& a, const T& b)   { const T s = a + b; return add_error(a, b, s) > 0 ? next_up(s) : s; }
+	template <typename T> T sub_down(const T& a, const T& b) { return add_down(a, -b); }
+	template <typename T> T sub_up(const T& a, const T& b)   { return add_up(a, -b); }
+
+	template <typename T> T mul_down(const T& a, const T& b) { const T p = a * b; return std::fma(a, b, -p) < 0 ? next_down(p) : p; }
+	template <typename T> T mul_up(const T& a, const T& b)   { const T p = a * b; return std::fma(a, b, -p) > 0 ? next_up(p) : p; }
+
+	// The true quotient is q + r/b
+	template <typename T> T div_down(const T& a, const T& b) { const T q = a / b; const T r = std::fma(-q, b, a); return (r != 0 && (r < 0) != (b < 0)) ? next_down(q) : q; }
+	template <typename T> T div_up(const T& a, const T& b)   { const T q = a / b; const T r = std::fma(-q, b, a); return (r != 0 && (r < 0) == (b < 0)) ? next_up(q) : q; }
+}
+
+// An interval [lower, upper] guaranteed to contain the true value, for use as the rep of a Unit.
+//
+// Arithmetic rounds each bound in its own direction with the helpers above, so no rounding mode
+// is ever changed.
+template <typename T>
+class Interval
+{
+	static_assert(std::is_floating_point<T>::value, "Interval requires a floating-point value type");
+
+public:
+	using value_type = T;
+
+	Interval() = default;
+	Interval(const T& x) : lo_(x), hi_(x) {}
+	Interval(const T& lo, const T& hi) : lo_(lo), hi_(hi) {}
+
+	// Narrowing conversions round outward
+	template <typename X>
+	explicit Interval(const Interval<X>& rhs) : lo_(rhs.lower()), hi_(rhs.upper())
+	{
+		if (static_cast<long double>(lo_) > static_cast<long double>(rhs.lower())) lo_ = next_down(lo_);
+		if (static_cast<long double>(hi_) < static_cast<long double>(rhs.upper())) hi_ = next_up(hi_);
+	}
+
+	T lower() const { return lo_; }
+	T upper() const { return hi_; }
+	T mid() const { return lo_ + (hi_ - lo_) / 2; }
+	T width() const { return hi_ - lo_; }
+
+	bool contains(const T& x) const { return lo_ <= x && x <= hi_; }
+	bool contains(const Interval& x) const { return lo_ <= x.lo_ && x.hi_ <= hi_; }
+
+	Interval& operator+=(const Interval& rhs)
+	{
+		lo_ = rounding::add_down(lo_, rhs.lo_);
+		hi_ = rounding::add_up(hi_, rhs.hi_);
+		return *this;
+	}
+
+	Interval& operator-=(const Interval& rhs)
+	{
+		const T lo = rounding::sub_down(lo_, rhs.hi_);
+		hi_ = rounding::sub_up(hi_, rhs.lo_);
+		lo_ = lo;
+		return *this;
+	}
+
+	Interval& operator*=(const Interval& rhs)
+	{
+		using namespace rounding;
+		const T lo = std::min(std::min(mul_down(lo_, rhs.lo_), mul_down(lo_, rhs.hi_)),
+		                      std::min(mul_down(hi_, rhs.lo_), mul_down(hi_, rhs.hi_)));
+		hi_ = std::max(std::max(mul_up(lo_, rhs.lo_), mul_up(lo_, rhs.hi_)),
+		               std::max(mul_up(hi_, rhs.lo_), mul_up(hi_, rhs.hi_)));
+		lo_ = lo;
+		return *this;
+	}
+
+	// Division by an interval containing zero is unbounded
+	Interval& operator/=(const Interval& rhs)
+	{
+		if (rhs.contains(T(0))) {
+			lo_ = -std::numeric_limits<T>::infinity();
+			hi_ = std::numeric_limits<T>::infinity();
+			return *this;
+		}
+		using namespace rounding;
+		const T lo = std::min(std::min(div_down(lo_, rhs.lo_), div_down(lo_, rhs.hi_)),
+		                      std::min(div_down(hi_, rhs.lo_), div_down(hi_, rhs.hi_)));
+		hi_ = std::max(std::max(div_up(lo_, rhs.lo_), div_up(lo_, rhs.hi_)),
+		               std::max(div_up(hi_, rhs.lo_), div_up(hi_, rhs.hi_)));
+		lo_ = lo;
+		return *this;
+	}
+
+	friend Interval operator+(Interval lhs, const Interval& rhs) { return lhs += rhs; }
+	friend Interval operator-(Interval lhs, const Interval& rhs) { return lhs -= rhs; }
+	friend Interval operator*(Interval lhs, const Interval& rhs) { return lhs *= rhs; }
+	friend Interval operator/(Interval lhs, const Interval& rhs) { return lhs /= rhs; }
+
+	// Plain numbers (such as the ratios of a unit conversion) are first enclosed exactly
+	template <typename X, typename = std::enable_if_t<std::is_arithmetic<X>::value>>
+	friend Interval operator*(Interval lhs, const X& x) { return lhs *= enclose(x); }
+	template <typename X, typename = std::enable_if_t<std::is_arithmetic<X>::value>>
+	friend Interval operator*(const X& x, Interval rhs) { return rhs *= enclose(x); }
+	template <typename X, typename = std::enable_if_t<std::is_arithmetic<X>::value>>
+	friend Interval operator/(Interval lhs, const X& x) { return lhs /= enclose(x); }
+
+	friend std::ostream& operator<<(std::ostream& os, const Interval& x)
+	{
+		return os << "[" << x.lower() << ", " << x.upper() << "]";
+	}
+
+	// The tightest interval of T containing x
+	template <typename X>
+	static Interval enclose(const X& x)
+	{
+		T lo = static_cast<T>(x);
+		T hi = lo;
+		if (static_cast<long double>(lo) > static_cast<long double>(x)) lo = next_down(lo);
+		if (static_cast<long double>(hi) < static_cast<long double>(x)) hi = next_up(hi);
+		return Interval(lo, hi);
+	}
+
+private:
+	T lo_;
+	T hi_;
+};
+
+template <typename T>
+struct treat_as_floating_point<Interval<T>> : std::true_type {};
+
+// Certainly: holds for every pair of values in the intervals. Possibly: holds for some pair.
+template <typename T>
+bool certainly_less(const Interval<T>& lhs, const Interval<T>& rhs) { return lhs.upper() < rhs.lower(); }
+
+template <typename T>
+bool possibly_less(const Interval<T>& lhs, const Interval<T>& rhs) { return lhs.lower() < rhs.upper(); }
+
+
+// Bulk storage for Unit<Interval<T>,B>, with lower and upper bounds in separate columns.
+//
+// Operations over whole arrays compute every lower bound and then every upper bound, each in a
+// plain loop over T with the same error-free rounding as the scalar operations, so the bounds hold
+// whatever the compiler assumes about the floating-point environment.
+template <typename T, typename B = BaseUnit<>>
+class IntervalArray
+{
+public:
+	using rep = T;
+	using base = B;
+	using unit = Unit<Interval<T>,B>;
+
+	IntervalArray() = default;
+	explicit IntervalArray(std::size_t n) : lower_(n), upper_(n) {}
+
+	std::size_t size() const { return lower_.size(); }
+	bool empty() const { return lower_.empty(); }
+
+	void resize(std::size_t n) { lower_.resize(n); upper_.resize(n); }
+	void reserve(std::size_t n) { lower_.reserve(n); upper_.reserve(n); }
+
+	void push_back(const unit& u)
+	{
+		lower_.push_back(Unit<T,B>(u.value().lower()));
+		upper_.push_back(Unit<T,B>(u.value().upper()));
+	}
+
+	unit operator[](std::size_t i) const
+	{
+		return unit(Interval<T>(lower_[i].value(), upper_[i].value()));
+	}
+
+	void set(std::size_t i, const unit& u)
+	{
+		lower_[i] = u.value().lower();
+		upper_[i] = u.value().upper();
+	}
+
+	UnitSpan<T,B> lower() { return lower_; }
+	UnitSpan<const T,B> lower() const { return lower_; }
+	UnitSpan<T,B> upper() { return upper_; }
+	UnitSpan<const T,B> upper() const { return upper_; }
+
+	T* lower_data() { return lower().values(); }
+	const T* lower_data() const { return lower().values(); }
+	T* upper_data() { return upper().values(); }
+	const T* upper_data() const { return upper().values(); }
+
+private:
+	UnitArray<T,B> lower_;
+	UnitArray<T,B> upper_;
+};
+
+template <typename ToArray, typename X, typename B1, typename D = typename B1::dim>
+ToArray dimension_cast(const IntervalArray<X,B1>& array)
+{
+	using Y = typename ToArray::rep;
+	using conversion = BaseConversion<B1, typename ToArray::base, D>;
+
+	// The ratio's terms need not be representable in Y, so bracket them too
+	const Interval<Y> num = Interval<Y>::enclose(conversion::num);
+	const Interval<Y> den = Interval<Y>::enclose(conversion::den);
+
+	const std::size_t n = array.size();
+	ToArray result(n);
+	const X* lo = array.lower_data();
+	const X* hi = array.upper_data();
+	Y* rlo = result.lower_data();
+	Y* rhi = result.upper_data();
+
+	// Scaling by a positive factor: the bound is smallest for the smallest factor when the value
+	// is positive and for the largest factor when negative
+	for (std::size_t i = 0; i < n; ++i) {
+		const Y x = static_cast<Y>(lo[i]);
+		const Y k = x < 0 ? num.upper() : num.lower();
+		const Y d = x < 0 ? den.lower() : den.upper();
+		rlo[i] = rounding::div_down(rounding::mul_down(x, k), d);
+	}
+	for (std::size_t i = 0; i < n; ++i) {
+		const Y x = static_cast<Y>(hi[i]);
+		const Y k = x < 0 ? num.lower() : num.upper();
+		const Y d = x < 0 ? den.upper() : den.lower();
+		rhi[i] = rounding::div_up(rounding::mul_up(x, k), d);
+	}
+	return result;
+}
+
+template <typename ToArray, typename X, typename B1>
+ToArray unit_cast(const IntervalArray<X,B1>& array)
+{
+	using B = typename ToArray::base;
+	return dimension_cast<ToArray,X,B1,AddType<typename B1::dim,typename B::dim>>(array);
+}
+
+// IntervalArray + - * / IntervalArray, with the same result types as for Unit. Operands are first
+// rescaled to the common base.
+
+template <typename X, typename Y, typename B1, typename B2,
+          typename ToArray = IntervalArray< AddType<X,Y>, CommonBase<AddType<typename B1::dim,typename B2::dim>,B1,B2>> >
+ToArray operator+(const IntervalArray<X,B1>& lhs, const IntervalArray<Y,B2>& rhs)
+{
+	using T = typename ToArray::rep;
+	using B = typename ToArray::base;
+	assert(lhs.size() == rhs.size());
+
+	const auto a = unit_cast<IntervalArray<T,B>>(lhs);
+	const auto b = unit_cast<IntervalArray<T,B>>(rhs);
+	const std::size_t n = a.size();
+	ToArray result(n);
+	{
+		const T* x = a.lower_data(); const T* y = b.lower_data(); T* r = result.lower_data();
+		for (std::size_t i = 0; i < n; ++i) r[i] = rounding::add_down(x[i], y[i]);
+	}
+	{
+		const T* x = a.upper_data(); const T* y = b.upper_data(); T* r = result.upper_data();
+		for (std::size_t i = 0; i < n; ++i) r[i] = rounding::add_up(x[i], y[i]);
+	}
+	return result;
+}
+
+template <typename X, typename Y, typename B1, typename B2,
+          typename ToArray = IntervalArray< AddType<X,Y>, CommonBase<AddType<typename B1::dim,typename B2::dim>,B1,B2>> >
+ToArray operator-(const IntervalArray<X,B1>& lhs, const IntervalArray<Y,B2>& rhs)
+{
+	using T = typename ToArray::rep;
+	using B = typename ToArray::base;
+	assert(lhs.size() == rhs.size());
+
+	const auto a = unit_cast<IntervalArray<T,B>>(lhs);
+	const auto b = unit_cast<IntervalArray<T,B>>(rhs);
+	const std::size_t n = a.size();
+	ToArray result(n);
+	{
+		const T* x = a.lower_data(); const T* y = b.upper_data(); T* r = result.lower_data();
+		for (std::size_t i = 0; i < n; ++i) r[i] = rounding::sub_down(x[i], y[i]);
+	}
+	{
+		const T* x = a.upper_data(); const T* y = b.lower_data(); T* r = result.upper_data();
+		for (std::size_t i = 0; i < n; ++i) r[i] = rounding::sub_up(x[i], y[i]);
+	}
+	return result;
+}
+
+template <typename X, typename Y, typename B1, typename B2,
+          typename ToArray = IntervalArray< AddType<X,Y>, CommonBase<MulType<typename B1::dim,typename B2::dim>,B1,B2>> >
+ToArray operator*(const IntervalArray<X,B1>& lhs, const IntervalArray<Y,B2>& rhs)
+{
+	using T = typename ToArray::rep;
+	using B = typename ToArray::base;
+	assert(lhs.size() == rhs.size());
+
+	// As for Unit * Unit, each operand is rescaled within its own dimension
+	const auto a = dimension_cast<IntervalArray<T,B>>(lhs);
+	const auto b = dimension_cast<IntervalArray<T,B>>(rhs);
+	const std::size_t n = a.size();
+	ToArray result(n);
+	const T* alo = a.lower_data(); const T* ahi = a.upper_data();
+	const T* blo = b.lower_data(); const T* bhi = b.upper_data();
+	{
+		T* r = result.lower_data();
+		for (std::size_t i = 0; i < n; ++i)
+			r[i] = std::min(std::min(rounding::mul_down(alo[i], blo[i]), rounding::mul_down(alo[i], bhi[i])),
+			                std::min(rounding::mul_down(ahi[i], blo[i]), rounding::mul_down(ahi[i], bhi[i])));
+	}
+	{
+		T* r = result.upper_data();
+		for (std::size_t i = 0; i < n; ++i)
+			r[i] = std::max(std::max(rounding::mul_up(alo[i], blo[i]), rounding::mul_up(alo[i], bhi[i])),
+			                std::max(rounding::mul_up(ahi[i], blo[i]), rounding::mul_up(ahi[i], bhi[i])));
+	}
+	return result;
+}
+
+template <typename X, typename Y, typename B1, typename B2,
+          typename ToArray = IntervalArray< AddType<X,Y>, CommonBase<DivType<typename B1::dim,typename B2::dim>,B1,B2>> >
+ToArray operator/(const IntervalArray<X,B1>& lhs, const IntervalArray<Y,B2>& rhs)
+{
+	using T = typename ToArray::rep;
+	using B = typename ToArray::base;
+	assert(lhs.size() == rhs.size());
+
+	const auto a = dimension_cast<IntervalArray<T,B>>(lhs);
+	const auto b = dimension_cast<IntervalArray<T,B>>(rhs);
+	const std::size_t n = a.size();
+	ToArray result(n);
+	const T* alo = a.lower_data(); const T* ahi = a.upper_data();
+	const T* blo = b.lower_data(); const T* bhi = b.upper_data();
+	const T inf = std::numeric_limits<T>::infinity();
+
+	// A divisor straddling zero gives an unbounded result
+	{
+		T* r = result.lower_data();
+		for (std::size_t i = 0; i < n; ++i) {
+			const T q = std::min(std::min(rounding::div_down(alo[i], blo[i]), rounding::div_down(alo[i], bhi[i])),
+			                     std::min(rounding::div_down(ahi[i], blo[i]), rounding::div_down(ahi[i], bhi[i])));
+			r[i] = blo[i] <= 0 && bhi[i] >= 0 ? -inf : q;
+		}
+	}
+	{
+		T* r = result.upper_data();
+		for (std::size_t i = 0; i < n; ++i) {
+			const T q = std::max(std::max(rounding::div_up(alo[i], blo[i]), rounding::div_up(alo[i], bhi[i])),
+			                     std::max(rounding::div_up(ahi[i], blo[i]), rounding::div_up(ahi[i], bhi[i])));
+			r[i] = blo[i] <= 0 && bhi[i] >= 0 ? inf : q;
+		}
+	}
+	return result;
+}
+
+} // sunit
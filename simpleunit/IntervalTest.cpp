@@ -0,0 +1,124 @@
+#include "simpleunit/Interval.h"
+#include <cfenv>
+#include "gtest/gtest.h"
+
+using namespace std;
+using namespace sunit;
+
+TEST(IntervalTest, Arithmetic)
+{
+	Interval<double> a(1, 2);
+	Interval<double> b(-3, 4);
+
+	EXPECT_TRUE((a+b).contains(Interval<double>(-2, 6)));
+	EXPECT_TRUE((a-b).contains(Interval<double>(-3, 5)));
+	EXPECT_TRUE((a*b).contains(Interval<double>(-6, 8)));
+	EXPECT_TRUE((b/a).contains(Interval<double>(-3, 4)));
+
+	// Exact results are not widened
+	EXPECT_EQ(-2, (a+b).lower());
+	EXPECT_EQ(6, (a+b).upper());
+	EXPECT_EQ(-6, (a*b).lower());
+
+	// Unbounded division
+	EXPECT_TRUE(std::isinf((a/b).lower()));
+	EXPECT_TRUE(std::isinf((a/b).upper()));
+}
+
+TEST(IntervalTest, Rounding)
+{
+	// 0.1 is not representable, so any result must strictly bracket it
+	Interval<float> a = Interval<float>(1) / 10;
+	EXPECT_LT(a.lower(), 0.1L);
+	EXPECT_GT(a.upper(), 0.1L);
+
+	Interval<float> b(Interval<double>(0.1));
+	EXPECT_LT(b.lower(), 0.1L);
+	EXPECT_GT(b.upper(), 0.1L);
+
+	EXPECT_TRUE(certainly_less(Interval<float>(1, 2), Interval<float>(3, 4)));
+	EXPECT_FALSE(certainly_less(Interval<float>(1, 3), Interval<float>(2, 4)));
+	EXPECT_TRUE(possibly_less(Interval<float>(1, 3), Interval<float>(2, 4)));
+}
+
+TEST(IntervalTest, UnitCast)
+{
+	using Centimeters = Unit<Interval<float>, Length<std::centi>>;
+	using Meters = Unit<Interval<float>, Length<si::meter>>;
+
+	Centimeters a(Interval<float>(1, 3));
+	Meters b(a);
+	EXPECT_LT(b.value().lower(), 0.01L);
+	EXPECT_GT(b.value().upper(), 0.03L);
+	EXPECT_FLOAT_EQ(0.01f, b.value().lower());
+	EXPECT_FLOAT_EQ(0.03f, b.value().upper());
+}
+
+TEST(IntervalTest, StoppingDistance)
+{
+	using namespace si;
+	using Speed = Unit<Interval<float>, Velocity<meter, second>>;
+	using Deceleration = Unit<Interval<float>, Acceleration<meter, second>>;
+	using Distance = Unit<Interval<float>, Length<meter>>;
+
+	Speed v(Interval<float>(20, 21));
+	Deceleration a(Interval<float>(7, 8));
+
+	Distance d = v * v / (2 * a);
+	EXPECT_TRUE(d.value().contains(Interval<float>(25, 31.5f)));
+	EXPECT_EQ(25, d.value().lower());
+	EXPECT_EQ(31.5f, d.value().upper());
+}
+
+TEST(IntervalTest, ArrayBounds)
+{
+	using Centimeters = Unit<Interval<float>, Length<std::centi>>;
+
+	IntervalArray<float, Length<std::centi>> a;
+	for (int i = -4; i <= 4; ++i)
+		a.push_back(Centimeters(Interval<float>(float(i), float(i) + 1)));
+
+	auto m = unit_cast<IntervalArray<float, Length<si::meter>>>(a);
+	for (std::size_t i = 0; i < a.size(); ++i) {
+		const long double lo = a.lower()[i].value() / 100.L;
+		const long double hi = a.upper()[i].value() / 100.L;
+		EXPECT_LE(m.lower()[i].value(), lo);
+		EXPECT_GE(m.upper()[i].value(), hi);
+		// Directed rounding is no looser than an ulp
+		EXPECT_LE(m.upper()[i].value(), next_up(float(hi)));
+		EXPECT_GE(m.lower()[i].value(), next_down(float(lo)));
+	}
+
+	// The rounding mode is never changed
+	EXPECT_EQ(FE_TONEAREST, std::fegetround());
+}
+
+TEST(IntervalTest, ArrayMatchesScalar)
+{
+	using Meters = Unit<Interval<float>, Length<si::meter>>;
+	using Centimeters = Unit<Interval<float>, Length<std::centi>>;
+
+	IntervalArray<float, Length<si::meter>> a;
+	IntervalArray<float, Length<std::centi>> b;
+	for (int i = 1; i <= 6; ++i) {
+		a.push_back(Meters(Interval<float>(i * 0.3f, i * 0.5f)));
+		b.push_back(Centimeters(Interval<float>(-7.f * i, 3.f * i)));
+	}
+
+	auto sum = a + b;
+	auto diff = a - b;
+	auto product = a * b;
+	auto ratio = b / a;
+	EXPECT_EQ(2, int(decltype(product)::base::dim::d1));
+	for (std::size_t i = 0; i < a.size(); ++i) {
+		// Both paths round each bound in its own direction, so agree exactly
+		EXPECT_EQ((a[i] + b[i]).value().lower(), sum[i].value().lower());
+		EXPECT_EQ((a[i] + b[i]).value().upper(), sum[i].value().upper());
+		EXPECT_EQ((a[i] - b[i]).value().lower(), diff[i].value().lower());
+		EXPECT_EQ((a[i] - b[i]).value().upper(), diff[i].value().upper());
+		EXPECT_EQ((a[i] * b[i]).value().lower(), product[i].value().lower());
+		EXPECT_EQ((a[i] * b[i]).value().upper(), product[i].value().upper());
+		EXPECT_EQ((b[i] / a[i]).value().lower(), ratio[i].value().lower());
+		EXPECT_EQ((b[i] / a[i]).value().upper(), ratio[i].value().upper());
+	}
+}
@@ -0,0 +1,546 @@
+#pragma once
+
+#include "simpleunit/DynamicUnit.h"
+#include "simpleunit/UnitSpan.h"
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+namespace sunit {
+
+// Streaming JSON for quantities. A single value is written as an object with its unit symbol,
+// and a span as the symbol once and an array of values:
+//
+//     {"value":9.81,"unit":"m/s^2"}
+//     {"unit":"m/s","values":[1.5,2,2.5]}
+//
+// Neither the writer nor the reader allocates (but for a sink that does, or a unit symbol read in
+// an unexpected form). Numbers are formatted and parsed under the "C" locale; non-finite values
+// are written as null, and null reads back as NaN.
+
+// Sinks for JsonWriter: overload json_write for others
+inline void json_write(std::string& out, const char* s, std::size_t n) { out.append(s, n); }
+inline void json_write(std::ostream& out, const char* s, std::size_t n) { out.write(s, static_cast<std::streamsize>(n)); }
+
+template <typename Sink>
+class JsonWriter
+{
+public:
+	static constexpr std::size_t max_depth = 64;
+
+	explicit JsonWriter(Sink& sink) : sink_(sink) {}
+
+	void begin_object() { open('{'); }
+	void end_object() { close('{', '}'); }
+	void begin_array() { open('['); }
+	void end_array() { close('[', ']'); }
+
+	void key(const char* name)
+	{
+		assert(depth_ > 0 && stack_[depth_ - 1] == '{' && !after_key_);
+		if (need_comma_) put(",", 1);
+		quoted(name);
+		put(":", 1);
+		after_key_ = true;
+	}
+
+	void string(const char* s)
+	{
+		separate();
+		quoted(s);
+		need_comma_ = true;
+	}
+
+	template <typename T>
+	void number(T x)
+	{
+		separate();
+		formatted(x);
+		need_comma_ = true;
+	}
+
+	void boolean(bool b)
+	{
+		separate();
+		b ? put("true", 4) : put("false", 5);
+		need_comma_ = true;
+	}
+
+	void null()
+	{
+		separate();
+		put("null", 4);
+		need_comma_ = true;
+	}
+
+	// {"value":x,"unit":"..."}
+	template <typename T, typename B>
+	void quantity(const Unit<T,B>& q)
+	{
+		begin_object();
+		key("value");
+		number(q.value());
+		key("unit");
+		symbol<B>();
+		end_object();
+	}
+
+	// {"unit":"...","values":[...]}
+	template <typename T, typename B>
+	void quantities(UnitSpan<T,B> span)
+	{
+		begin_object();
+		key("unit");
+		symbol<B>();
+		key("values");
+		begin_array();
+		const T* x = span.values();
+		for (std::size_t i = 0; i < span.size(); ++i) {
+			if (i) put(",", 1);
+			formatted(x[i]);
+		}
+		need_comma_ = true;
+		end_array();
+		end_object();
+	}
+
+private:
+	void put(const char* s, std::size_t n) { json_write(sink_, s, n); }
+
+	void separate()
+	{
+		if (need_comma_ && !after_key_) put(",", 1);
+		after_key_ = false;
+	}
+
+	void open(char c)
+	{
+		assert(depth_ < max_depth);
+		separate();
+		put(&c, 1);
+		stack_[depth_++] = c;
+		need_comma_ = false;
+	}
+
+	void close(char open, char c)
+	{
+		assert(depth_ > 0 && stack_[depth_ - 1] == open && !after_key_);
+		(void)open;
+		--depth_;
+		put(&c, 1);
+		need_comma_ = true;
+	}
+
+	template <typename B>
+	void symbol()
+	{
+		separate();
+		put("\"", 1);
+		put(unit_symbol<B>(), unit_symbol_size<B>());
+		put("\"", 1);
+		need_comma_ = true;
+	}
+
+	void quoted(const char* s)
+	{
+		static const char hex[] = "0123456789abcdef";
+		put("\"", 1);
+		const char* run = s;
+		for (; *s; ++s) {
+			const unsigned char c = static_cast<unsigned char>(*s);
+			if (c >= 0x20 && c != '"' && c != '\\') continue;
+			put(run, s - run);
+			char escape[6] = {'\\', static_cast<char>(c), 0, 0, 0, 0};
+			std::size_t n = 2;
+			if (c == '\n') escape[1] = 'n';
+			else if (c == '\t') escape[1] = 't';
+			else if (c == '\r') escape[1] = 'r';
+			else if (c < 0x20) {
+				escape[1] = 'u'; escape[2] = '0'; escape[3] = '0';
+				escape[4] = hex[c >> 4]; escape[5] = hex[c & 15];
+				n = 6;
+			}
+			put(escape, n);
+			run = s + 1;
+		}
+		put(run, s - run);
+		put("\"", 1);
+	}
+
+	template <typename T>
+	void formatted(T x)
+	{
+		static_assert(std::is_arithmetic<T>::value, "JSON numbers must be arithmetic");
+		char buffer[32];
+		int n;
+		if (std::is_floating_point<T>::value) {
+			if (!std::isfinite(static_cast<double>(x))) {
+				put("null", 4);
+				return;
+			}
+			// Enough digits to read back the same value
+			n = std::snprintf(buffer, sizeof(buffer), "%.*g", std::numeric_limits<T>::max_digits10, static_cast<double>(x));
+		}
+		else if (std::is_signed<T>::value)
+			n = std::snprintf(buffer, sizeof(buffer), "%lld", static_cast<long long>(x));
+		else
+			n = std::snprintf(buffer, sizeof(buffer), "%llu", static_cast<unsigned long long>(x));
+		put(buffer, static_cast<std::size_t>(n));
+	}
+
+	Sink& sink_;
+	char stack_[max_depth];
+	std::size_t depth_ = 0;
+	bool need_comma_ = false;
+	bool after_key_ = false;
+};
+
+template <typename Sink>
+constexpr std::size_t JsonWriter<Sink>::max_depth;
+
+enum class JsonToken { begin_object, end_object, begin_array, end_array, key, string, number, boolean, null, end };
+
+// A pull parser over JSON text: each call to next() reads one token, checking the structure as it
+// goes. Keys and strings are views into the text, with escapes left as they are. Throws
+// std::invalid_argument for malformed text
+class JsonReader
+{
+public:
+	static constexpr std::size_t max_depth = 64;
+
+	JsonReader(const char* text, std::size_t size) : p_(text), begin_(text), end_(text + size) {}
+	explicit JsonReader(const std::string& text) : JsonReader(text.data(), text.size()) {}
+	explicit JsonReader(std::string&&) = delete;  // would outlive the text
+
+	JsonToken next()
+	{
+		skip_space();
+		if (depth_ == 0 && done_) {
+			if (p_ != end_) fail("trailing characters");
+			return token_ = JsonToken::end;
+		}
+		if (depth_ > 0 && !after_key_) {
+			if (p_ == end_) fail("unexpected end");
+			const char closer = stack_[depth_ - 1] == '{' ? '}' : ']';
+			if (*p_ == closer) {
+				if (!first_ && !need_comma_) fail("trailing comma");
+				++p_;
+				--depth_;
+				element_done();
+				return token_ = closer == '}' ? JsonToken::end_object : JsonToken::end_array;
+			}
+			if (need_comma_) {
+				if (*p_ != ',') fail("expected ','");
+				++p_;
+				skip_space();
+				need_comma_ = false;
+			}
+			first_ = false;
+			if (stack_[depth_ - 1] == '{') {
+				if (p_ == end_ || *p_ != '"') fail("expected a key");
+				read_string();
+				skip_space();
+				if (p_ == end_ || *p_ != ':') fail("expected ':'");
+				++p_;
+				after_key_ = true;
+				return token_ = JsonToken::key;
+			}
+		}
+		after_key_ = false;
+
+		if (p_ == end_) fail("unexpected end");
+		switch (*p_) {
+		case '{':
+		case '[':
+			if (depth_ == max_depth) fail("nested too deeply");
+			stack_[depth_++] = *p_;
+			token_ = *p_ == '{' ? JsonToken::begin_object : JsonToken::begin_array;
+			++p_;
+			first_ = true;
+			need_comma_ = false;
+			return token_;
+		case '"':
+			read_string();
+			element_done();
+			return token_ = JsonToken::string;
+		case 't':
+			literal("true");
+			boolean_ = true;
+			element_done();
+			return token_ = JsonToken::boolean;
+		case 'f':
+			literal("false");
+			boolean_ = false;
+			element_done();
+			return token_ = JsonToken::boolean;
+		case 'n':
+			literal("null");
+			element_done();
+			return token_ = JsonToken::null;
+		default:
+			read_number();
+			element_done();
+			return token_ = JsonToken::number;
+		}
+	}
+
+	// Read the next token, which must be of the given type
+	void expect(JsonToken token)
+	{
+		if (next() != token) fail("unexpected token");
+	}
+
+	// Skip the rest of the value whose first token was just read
+	void skip()
+	{
+		if (token_ == JsonToken::key)
+			next();
+		if (token_ != JsonToken::begin_object && token_ != JsonToken::begin_array)
+			return;
+		const std::size_t depth = depth_;
+		while (depth_ >= depth)
+			next();
+	}
+
+	JsonToken token() const { return token_; }
+
+	// The last key or string, without its quotes and with any escapes as written
+	const char* text() const { return text_; }
+	std::size_t text_size() const { return text_size_; }
+	bool text_escaped() const { return escaped_; }
+	bool text_equals(const char* s) const
+	{
+		return std::strlen(s) == text_size_ && std::memcmp(s, text_, text_size_) == 0;
+	}
+
+	double number() const { return number_; }
+	bool boolean() const { return boolean_; }
+
+	// Offset of the next character to read
+	std::size_t offset() const { return static_cast<std::size_t>(p_ - begin_); }
+
+	[[noreturn]] void fail(const char* what) const
+	{
+		throw std::invalid_argument(std::string("json: ") + what + " at offset " + std::to_string(offset()));
+	}
+
+private:
+	void skip_space()
+	{
+		while (p_ != end_ && (*p_ == ' ' || *p_ == '\n' || *p_ == '\r' || *p_ == '\t')) ++p_;
+	}
+
+	void element_done()
+	{
+		need_comma_ = true;
+		first_ = false;
+		if (depth_ == 0) done_ = true;
+	}
+
+	void literal(const char* word)
+	{
+		const std::size_t n = std::strlen(word);
+		if (static_cast<std::size_t>(end_ - p_) < n || std::memcmp(p_, word, n) != 0) fail("unknown literal");
+		p_ += n;
+	}
+
+	void read_string()
+	{
+		const char* s = ++p_;
+		escaped_ = false;
+		for (; p_ != end_ && *p_ != '"'; ++p_) {
+			if (static_cast<unsigned char>(*p_) < 0x20) fail("control character in string");
+			if (*p_ == '\\') {
+				escaped_ = true;
+				if (++p_ == end_) break;
+			}
+		}
+		if (p_ == end_) fail("unterminated string");
+		text_ = s;
+		text_size_ = static_cast<std::size_t>(p_ - s);
+		++p_;
+	}
+
+	void read_number()
+	{
+		// -?(0|[1-9][0-9]*)(.[0-9]+)?([eE][+-]?[0-9]+)?
+		const char* s = p_;
+		auto digits = [this] {
+			const char* d = p_;
+			while (p_ != end_ && *p_ >= '0' && *p_ <= '9') ++p_;
+			return p_ != d;
+		};
+		if (p_ != end_ && *p_ == '-') ++p_;
+		if (p_ != end_ && *p_ == '0') ++p_;
+		else if (!digits()) fail("unexpected character");
+		if (p_ != end_ && *p_ == '.') {
+			++p_;
+			if (!digits()) fail("bad number");
+		}
+		if (p_ != end_ && (*p_ == 'e' || *p_ == 'E')) {
+			++p_;
+			if (p_ != end_ && (*p_ == '+' || *p_ == '-')) ++p_;
+			if (!digits()) fail("bad number");
+		}
+
+		char buffer[64];
+		const std::size_t n = static_cast<std::size_t>(p_ - s);
+		if (n >= sizeof(buffer)) fail("number too long");
+		std::memcpy(buffer, s, n);
+		buffer[n] = '\0';
+		number_ = std::strtod(buffer, nullptr);
+	}
+
+	const char* p_;
+	const char* begin_;
+	const char* end_;
+	char stack_[max_depth];
+	std::size_t depth_ = 0;
+	bool first_ = false;
+	bool need_comma_ = false;
+	bool after_key_ = false;
+	bool done_ = false;
+
+	JsonToken token_ = JsonToken::end;
+	const char* text_ = nullptr;
+	std::size_t text_size_ = 0;
+	bool escaped_ = false;
+	double number_ = 0;
+	bool boolean_ = false;
+};
+
+constexpr std::size_t JsonReader::max_depth;
+
+namespace detail
+{
+	// The factor taking values in the unit just read to B: 1 if written as B's own symbol, else by
+	// parsing it
+	template <typename B>
+	double json_unit_factor(const JsonReader& reader)
+	{
+		if (reader.text_size() == unit_symbol_size<B>() && std::memcmp(reader.text(), unit_symbol<B>(), reader.text_size()) == 0)
+			return 1;
+		const std::string text(reader.text(), reader.text_size());
+		if (reader.text_escaped())
+			reader.fail("escaped unit");
+		DynamicUnit unit;
+		try {
+			unit = parse_unit(text);
+		}
+		catch (const std::invalid_argument&) {
+			reader.fail(("unknown unit '" + text + "'").c_str());
+		}
+		const DynamicUnit target = dynamic_unit<B>();
+		if (!unit.same_dimension(target))
+			reader.fail(("unit '" + text + "' has the wrong dimension").c_str());
+		return conversion_factor(unit, target);
+	}
+
+	inline double json_number(JsonReader& reader)
+	{
+		const JsonToken token = reader.next();
+		if (token == JsonToken::null)
+			return std::numeric_limits<double>::quiet_NaN();
+		if (token != JsonToken::number)
+			reader.fail("expected a number");
+		return reader.number();
+	}
+
+	// Read {"unit":"...","values":[...]}, passing each value, converted, to store(i, x). The unit
+	// must come before the values. Other keys are skipped
+	template <typename B, typename F>
+	std::size_t json_values(JsonReader& reader, F store)
+	{
+		reader.expect(JsonToken::begin_object);
+		double factor = 0;
+		bool unit = false;
+		std::size_t n = 0;
+		bool values = false;
+		while (reader.next() == JsonToken::key) {
+			if (reader.text_equals("unit")) {
+				reader.expect(JsonToken::string);
+				factor = json_unit_factor<B>(reader);
+				unit = true;
+			}
+			else if (reader.text_equals("values")) {
+				if (!unit) reader.fail("values before unit");
+				reader.expect(JsonToken::begin_array);
+				for (;;) {
+					const JsonToken token = reader.next();
+					if (token == JsonToken::end_array) break;
+					if (token == JsonToken::null)
+						store(n++, std::numeric_limits<double>::quiet_NaN());
+					else if (token == JsonToken::number)
+						store(n++, reader.number() * factor);
+					else
+						reader.fail("expected a number");
+				}
+				values = true;
+			}
+			else
+				reader.skip();
+		}
+		if (!values) reader.fail("no values");
+		return n;
+	}
+}
+
+// Read a quantity written as {"value":x,"unit":"..."}, in either order, converting to U. Throws
+// std::invalid_argument if the unit is unknown or of another dimension
+template <typename U>
+U read_quantity(JsonReader& reader)
+{
+	using T = typename U::rep;
+	using B = typename U::base;
+	reader.expect(JsonToken::begin_object);
+	double value = 0;
+	double factor = 0;
+	bool have_value = false;
+	bool have_unit = false;
+	while (reader.next() == JsonToken::key) {
+		if (reader.text_equals("value")) {
+			value = detail::json_number(reader);
+			have_value = true;
+		}
+		else if (reader.text_equals("unit")) {
+			reader.expect(JsonToken::string);
+			factor = detail::json_unit_factor<B>(reader);
+			have_unit = true;
+		}
+		else
+			reader.skip();
+	}
+	if (!have_value || !have_unit)
+		reader.fail("quantity needs a value and a unit");
+	return U(static_cast<T>(value * factor));
+}
+
+// Read a span written as {"unit":"...","values":[...]} into out, returning the number of values.
+// Throws std::invalid_argument if there are more than fit
+template <typename T, typename B>
+std::size_t read_quantities(JsonReader& reader, UnitSpan<T,B> out)
+{
+	T* x = out.values();
+	return detail::json_values<B>(reader, [&](std::size_t i, double v) {
+		if (i >= out.size()) reader.fail("too many values");
+		x[i] = static_cast<T>(v);
+	});
+}
+
+template <typename U>
+UnitArray<typename U::rep, typename U::base> read_quantities(JsonReader& reader)
+{
+	using T = typename U::rep;
+	UnitArray<T, typename U::base> out;
+	detail::json_values<typename U::base>(reader, [&](std::size_t, double v) { out.push_back(U(static_cast<T>(v))); });
+	return out;
+}
+
+} // sunit
@@ -0,0 +1,150 @@
+#include "simpleunit/Json.h"
+#include <cmath>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include "gtest/gtest.h"
+
+using namespace std;
+using namespace sunit;
+
+TEST(JsonTest, Write)
+{
+	using namespace si;
+
+	string out;
+	JsonWriter<string> w(out);
+	w.begin_object();
+	w.key("name");
+	w.string("drop \"A\"\n");
+	w.key("g");
+	w.quantity(Meters_Second2(9.5f));
+	w.key("speeds");
+	vector<Meters_Second> speeds = {Meters_Second(1.5f), Meters_Second(2), Meters_Second(numeric_limits<float>::infinity())};
+	w.quantities(make_span(speeds));
+	w.key("flags");
+	w.begin_array();
+	w.boolean(true);
+	w.null();
+	w.number(-3);
+	w.end_array();
+	w.end_object();
+
+	EXPECT_EQ("{\"name\":\"drop \\\"A\\\"\\n\","
+	          "\"g\":{\"value\":9.5,\"unit\":\"m/s^2\"},"
+	          "\"speeds\":{\"unit\":\"m/s\",\"values\":[1.5,2,null]},"
+	          "\"flags\":[true,null,-3]}", out);
+
+	ostringstream os;
+	JsonWriter<ostream> ws(os);
+	ws.quantity(Unit<double, Velocity<std::kilo, hour>>(0.1));
+	EXPECT_EQ("{\"value\":0.10000000000000001,\"unit\":\"km/h\"}", os.str());
+}
+
+TEST(JsonTest, RoundTrip)
+{
+	using namespace si;
+
+	vector<Meters> lengths;
+	for (int i = 0; i < 100; ++i)
+		lengths.push_back(Meters(std::sin(i * 0.1f) * 1e3f));
+
+	string out;
+	JsonWriter<string> w(out);
+	w.quantities(make_span(lengths));
+
+	JsonReader r(out);
+	const auto back = read_quantities<Meters>(r);
+	EXPECT_EQ(JsonToken::end, r.next());
+	ASSERT_EQ(lengths.size(), back.size());
+	for (size_t i = 0; i < lengths.size(); ++i)
+		EXPECT_EQ(lengths[i].value(), back[i].value());
+}
+
+TEST(JsonTest, Convert)
+{
+	using namespace si;
+
+	const string a_text = "{\"unit\":\"km/h\",\"value\":36}";
+	JsonReader a(a_text);
+	EXPECT_FLOAT_EQ(10, read_quantity<Meters_Second>(a).value());
+
+	const string b_text = " { \"value\" : 2 , \"note\" : [1, {\"x\": null}], \"unit\" : \"min\" } ";
+	JsonReader b(b_text);
+	EXPECT_FLOAT_EQ(120, read_quantity<Seconds>(b).value());
+
+	const string c_text = "{\"unit\":\"cm\",\"values\":[100, 250, null, -5e1]}";
+	JsonReader c(c_text);
+	Meters buffer[4];
+	EXPECT_EQ(4u, read_quantities(c, UnitSpan<float, Length<meter>>(buffer, 4)));
+	EXPECT_FLOAT_EQ(1, buffer[0].value());
+	EXPECT_FLOAT_EQ(2.5f, buffer[1].value());
+	EXPECT_TRUE(std::isnan(buffer[2].value()));
+	EXPECT_FLOAT_EQ(-0.5f, buffer[3].value());
+
+	const string d_text = "{\"unit\":\"kg*m/s^2\",\"values\":[]}";
+	JsonReader d(d_text);
+	EXPECT_EQ(0u, read_quantities<KilogramMeters_Second2>(d).size());
+
+	auto throws = [](const char* text, bool span) {
+		const string s = text;
+		JsonReader r(s);
+		Meters buffer[2];
+		if (span)
+			read_quantities(r, UnitSpan<float, Length<meter>>(buffer, 2));
+		else
+			read_quantity<Meters>(r);
+	};
+	EXPECT_THROW(throws("{\"value\":1,\"unit\":\"s\"}", false), invalid_argument);
+	EXPECT_THROW(throws("{\"value\":1,\"unit\":\"furlong\"}", false), invalid_argument);
+	EXPECT_THROW(throws("{\"value\":1}", false), invalid_argument);
+	EXPECT_THROW(throws("{\"value\":\"1\",\"unit\":\"m\"}", false), invalid_argument);
+	EXPECT_THROW(throws("{\"values\":[1],\"unit\":\"m\"}", true), invalid_argument);
+	EXPECT_THROW(throws("{\"unit\":\"m\",\"values\":[1,2,3]}", true), invalid_argument);
+}
+
+TEST(JsonTest, Reader)
+{
+	const string r_text = "{\"a\":[1,-0.5e2,true,false,null,\"s\\\"t\"],\"b\":{}}";
+	JsonReader r(r_text);
+	EXPECT_EQ(JsonToken::begin_object, r.next());
+	EXPECT_EQ(JsonToken::key, r.next());
+	EXPECT_TRUE(r.text_equals("a"));
+	EXPECT_EQ(JsonToken::begin_array, r.next());
+	EXPECT_EQ(JsonToken::number, r.next());
+	EXPECT_EQ(1, r.number());
+	EXPECT_EQ(JsonToken::number, r.next());
+	EXPECT_EQ(-50, r.number());
+	EXPECT_EQ(JsonToken::boolean, r.next());
+	EXPECT_TRUE(r.boolean());
+	EXPECT_EQ(JsonToken::boolean, r.next());
+	EXPECT_FALSE(r.boolean());
+	EXPECT_EQ(JsonToken::null, r.next());
+	EXPECT_EQ(JsonToken::string, r.next());
+	EXPECT_EQ("s\\\"t", string(r.text(), r.text_size()));
+	EXPECT_TRUE(r.text_escaped());
+	EXPECT_EQ(JsonToken::end_array, r.next());
+	EXPECT_EQ(JsonToken::key, r.next());
+	EXPECT_EQ(JsonToken::begin_object, r.next());
+	EXPECT_EQ(JsonToken::end_object, r.next());
+	EXPECT_EQ(JsonToken::end_object, r.next());
+	EXPECT_EQ(JsonToken::end, r.next());
+
+	auto scan = [](const char* text) {
+		const string s = text;
+		JsonReader r(s);
+		while (r.next() != JsonToken::end) {}
+	};
+	EXPECT_NO_THROW(scan("[]"));
+	EXPECT_NO_THROW(scan(" 0 "));
+	EXPECT_THROW(scan("[1,]"), invalid_argument);
+	EXPECT_THROW(scan("[1 2]"), invalid_argument);
+	EXPECT_THROW(scan("{\"a\" 1}"), invalid_argument);
+	EXPECT_THROW(scan("{1:2}"), invalid_argument);
+	EXPECT_THROW(scan("[01]"), invalid_argument);
+	EXPECT_THROW(scan("[1."), invalid_argument);
+	EXPECT_THROW(scan("[tru]"), invalid_argument);
+	EXPECT_THROW(scan("\"abc"), invalid_argument);
+	EXPECT_THROW(scan("[1] 2"), invalid_argument);
+	EXPECT_THROW(scan("[1"), invalid_argument);
+}
@@ -0,0 +1,280 @@
+#pragma once
+
+#include "simpleunit/UnitSpan.h"
+#include <cassert>
+#include <cmath>
+
+namespace sunit {
+
+// A value with its standard uncertainty, for use as the rep of a Unit, e.g.
+//
+//     Unit<Measured<float>, Length<meter>> length({2.f, 0.01f});
+//
+// Arithmetic propagates the uncertainty to first order and assumes the operands are
+// uncorrelated. Scaling by a plain number (as in a unit conversion) is exact.
+template <typename T>
+class Measured
+{
+	static_assert(std::is_floating_point<T>::value, "Measured requires a floating-point value type");
+
+public:
+	using value_type = T;
+
+	Measured() = default;
+	Measured(const T& value, const T& sigma = T(0)) : value_(value), sigma_(sigma) {}
+
+	template <typename X>
+	explicit Measured(const Measured<X>& rhs)
+		: value_(static_cast<T>(rhs.value())), sigma_(static_cast<T>(rhs.sigma())) {}
+
+	T value() const { return value_; }
+	T sigma() const { return sigma_; }
+	T variance() const { return sigma_ * sigma_; }
+	T relative() const { return sigma_ / std::abs(value_); }
+
+	Measured& operator+=(const Measured& rhs)
+	{
+		value_ += rhs.value_;
+		sigma_ = std::sqrt(sigma_*sigma_ + rhs.sigma_*rhs.sigma_);
+		return *this;
+	}
+
+	Measured& operator-=(const Measured& rhs)
+	{
+		value_ -= rhs.value_;
+		sigma_ = std::sqrt(sigma_*sigma_ + rhs.sigma_*rhs.sigma_);
+		return *this;
+	}
+
+	Measured& operator*=(const Measured& rhs)
+	{
+		const T s1 = sigma_ * rhs.value_;
+		const T s2 = value_ * rhs.sigma_;
+		value_ *= rhs.value_;
+		sigma_ = std::sqrt(s1*s1 + s2*s2);
+		return *this;
+	}
+
+	// q = a/b, with σq = sqrt(σa² + (q.σb)²) / |b|
+	Measured& operator/=(const Measured& rhs)
+	{
+		const T q = value_ / rhs.value_;
+		const T s2 = q * rhs.sigma_;
+		sigma_ = std::sqrt(sigma_*sigma_ + s2*s2) / std::abs(rhs.value_);
+		value_ = q;
+		return *this;
+	}
+
+	template <typename X, typename = std::enable_if_t<std::is_arithmetic<X>::value>>
+	Measured& operator*=(const X& x) { value_ *= x; sigma_ *= std::abs(static_cast<T>(x)); return *this; }
+	template <typename X, typename = std::enable_if_t<std::is_arithmetic<X>::value>>
+	Measured& operator/=(const X& x) { value_ /= x; sigma_ /= std::abs(static_cast<T>(x)); return *this; }
+
+	// Hidden friends, so that a plain T converts implicitly to an exact Measured<T>
+	friend Measured operator+(Measured lhs, const Measured& rhs) { return lhs += rhs; }
+	friend Measured operator-(Measured lhs, const Measured& rhs) { return lhs -= rhs; }
+	friend Measured operator*(Measured lhs, const Measured& rhs) { return lhs *= rhs; }
+	friend Measured operator/(Measured lhs, const Measured& rhs) { return lhs /= rhs; }
+
+	template <typename X, typename = std::enable_if_t<std::is_arithmetic<X>::value>>
+	friend Measured operator*(Measured lhs, const X& x) { return lhs *= x; }
+	template <typename X, typename = std::enable_if_t<std::is_arithmetic<X>::value>>
+	friend Measured operator*(const X& x, Measured rhs) { return rhs *= x; }
+	template <typename X, typename = std::enable_if_t<std::is_arithmetic<X>::value>>
+	friend Measured operator/(Measured lhs, const X& x) { return lhs /= x; }
+
+	friend std::ostream& operator<<(std::ostream& os, const Measured& m)
+	{
+		return os << m.value() << " +/- " << m.sigma();
+	}
+
+private:
+	T value_;
+	T sigma_;
+};
+
+template <typename T>
+struct treat_as_floating_point<Measured<T>> : std::true_type {};
+
+
+// Bulk storage for Unit<Measured<T>,B>. Values and uncertainties are held in separate
+// columns so that propagation over the array reduces to plain loops over T.
+template <typename T, typename B = BaseUnit<>>
+class MeasuredArray
+{
+public:
+	using rep = T;
+	using base = B;
+	using unit = Unit<Measured<T>,B>;
+
+	MeasuredArray() = default;
+	explicit MeasuredArray(std::size_t n) : values_(n), sigmas_(n) {}
+
+	std::size_t size() const { return values_.size(); }
+	bool empty() const { return values_.empty(); }
+
+	void resize(std::size_t n) { values_.resize(n); sigmas_.resize(n); }
+	void reserve(std::size_t n) { values_.reserve(n); sigmas_.reserve(n); }
+
+	void push_back(const unit& u)
+	{
+		values_.push_back(Unit<T,B>(u.value().value()));
+		sigmas_.push_back(Unit<T,B>(u.value().sigma()));
+	}
+
+	unit operator[](std::size_t i) const
+	{
+		return unit(Measured<T>(values_[i].value(), sigmas_[i].value()));
+	}
+
+	void set(std::size_t i, const unit& u)
+	{
+		values_[i] = u.value().value();
+		sigmas_[i] = u.value().sigma();
+	}
+
+	UnitSpan<T,B> values() { return values_; }
+	UnitSpan<const T,B> values() const { return values_; }
+	UnitSpan<T,B> sigmas() { return sigmas_; }
+	UnitSpan<const T,B> sigmas() const { return sigmas_; }
+
+	T* value_data() { return values().values(); }
+	const T* value_data() const { return values().values(); }
+	T* sigma_data() { return sigmas().values(); }
+	const T* sigma_data() const { return sigmas().values(); }
+
+private:
+	UnitArray<T,B> values_;
+	UnitArray<T,B> sigmas_;
+};
+
+template <typename ToArray, typename X, typename B1, typename D = typename B1::dim>
+ToArray dimension_cast(const MeasuredArray<X,B1>& array)
+{
+	using Y = typename ToArray::rep;
+
+	// The factor is exact, so the uncertainty scales with it
+	const Y k = conversion_factor<Y, B1, typename ToArray::base, D>();
+	const std::size_t n = array.size();
+	ToArray result(n);
+
+	const X* v = array.value_data();
+	const X* s = array.sigma_data();
+	Y* rv = result.value_data();
+	Y* rs = result.sigma_data();
+	for (std::size_t i = 0; i < n; ++i) {
+		rv[i] = static_cast<Y>(v[i]) * k;
+		rs[i] = static_cast<Y>(s[i]) * k;
+	}
+	return result;
+}
+
+template <typename ToArray, typename X, typename B1>
+ToArray unit_cast(const MeasuredArray<X,B1>& array)
+{
+	using B = typename ToArray::base;
+	return dimension_cast<ToArray,X,B1,AddType<typename B1::dim,typename B::dim>>(array);
+}
+
+// MeasuredArray + - * / MeasuredArray, element-wise and with the same result types as for Unit
+
+template <typename X, typename Y, typename B1, typename B2,
+          typename ToArray = MeasuredArray< AddType<X,Y>, CommonBase<AddType<typename B1::dim,typename B2::dim>,B1,B2>> >
+ToArray operator+(const MeasuredArray<X,B1>& lhs, const MeasuredArray<Y,B2>& rhs)
+{
+	using T = typename ToArray::rep;
+	using B = typename ToArray::base;
+	assert(lhs.size() == rhs.size());
+
+	const T k1 = conversion_factor<T,B1,B>();
+	const T k2 = conversion_factor<T,B2,B>();
+	const std::size_t n = lhs.size();
+	ToArray result(n);
+
+	const X* a = lhs.value_data(); const X* sa = lhs.sigma_data();
+	const Y* b = rhs.value_data(); const Y* sb = rhs.sigma_data();
+	T* r = result.value_data(); T* sr = result.sigma_data();
+	for (std::size_t i = 0; i < n; ++i) {
+		const T s1 = k1 * sa[i];
+		const T s2 = k2 * sb[i];
+		r[i] = k1 * a[i] + k2 * b[i];
+		sr[i] = std::sqrt(s1*s1 + s2*s2);
+	}
+	return result;
+}
+
+template <typename X, typename Y, typename B1, typename B2,
+          typename ToArray = MeasuredArray< AddType<X,Y>, CommonBase<AddType<typename B1::dim,typename B2::dim>,B1,B2>> >
+ToArray operator-(const MeasuredArray<X,B1>& lhs, const MeasuredArray<Y,B2>& rhs)
+{
+	using T = typename ToArray::rep;
+	using B = typename ToArray::base;
+	assert(lhs.size() == rhs.size());
+
+	const T k1 = conversion_factor<T,B1,B>();
+	const T k2 = conversion_factor<T,B2,B>();
+	const std::size_t n = lhs.size();
+	ToArray result(n);
+
+	const X* a = lhs.value_data(); const X* sa = lhs.sigma_data();
+	const Y* b = rhs.value_data(); const Y* sb = rhs.sigma_data();
+	T* r = result.value_data(); T* sr = result.sigma_data();
+	for (std::size_t i = 0; i < n; ++i) {
+		const T s1 = k1 * sa[i];
+		const T s2 = k2 * sb[i];
+		r[i] = k1 * a[i] - k2 * b[i];
+		sr[i] = std::sqrt(s1*s1 + s2*s2);
+	}
+	return result;
+}
+
+template <typename X, typename Y, typename B1, typename B2,
+          typename ToArray = MeasuredArray< AddType<X,Y>, CommonBase<MulType<typename B1::dim,typename B2::dim>,B1,B2>> >
+ToArray operator*(const MeasuredArray<X,B1>& lhs, const MeasuredArray<Y,B2>& rhs)
+{
+	using T = typename ToArray::rep;
+	using B = typename ToArray::base;
+	assert(lhs.size() == rhs.size());
+
+	// Both operands are rescaled to the common base, so the product picks up both factors
+	const T k = conversion_factor<T,B1,B>() * conversion_factor<T,B2,B>();
+	const std::size_t n = lhs.size();
+	ToArray result(n);
+
+	const X* a = lhs.value_data(); const X* sa = lhs.sigma_data();
+	const Y* b = rhs.value_data(); const Y* sb = rhs.sigma_data();
+	T* r = result.value_data(); T* sr = result.sigma_data();
+	for (std::size_t i = 0; i < n; ++i) {
+		const T s1 = sa[i] * b[i];
+		const T s2 = a[i] * sb[i];
+		r[i] = k * a[i] * b[i];
+		sr[i] = k * std::sqrt(s1*s1 + s2*s2);
+	}
+	return result;
+}
+
+template <typename X, typename Y, typename B1, typename B2,
+          typename ToArray = MeasuredArray< AddType<X,Y>, CommonBase<DivType<typename B1::dim,typename B2::dim>,B1,B2>> >
+ToArray operator/(const MeasuredArray<X,B1>& lhs, const MeasuredArray<Y,B2>& rhs)
+{
+	using T = typename ToArray::rep;
+	using B = typename ToArray::base;
+	assert(lhs.size() == rhs.size());
+
+	const T k = conversion_factor<T,B1,B>() / conversion_factor<T,B2,B>();
+	const std::size_t n = lhs.size();
+	ToArray result(n);
+
+	const X* a = lhs.value_data(); const X* sa = lhs.sigma_data();
+	const Y* b = rhs.value_data(); const Y* sb = rhs.sigma_data();
+	T* r = result.value_data(); T* sr = result.sigma_data();
+	for (std::size_t i = 0; i < n; ++i) {
+		const T q = a[i] / b[i];
+		const T s2 = q * sb[i];
+		r[i] = k * q;
+		sr[i] = k * std::sqrt(sa[i]*sa[i] + s2*s2) / std::abs(b[i]);
+	}
+	return result;
+}
+
+} // sunit
@@ -0,0 +1,124 @@
+#include "simpleunit/Measured.h"
+#include <cmath>
+#include "gtest/gtest.h"
+
+using namespace std;
+using namespace sunit;
+
+TEST(MeasuredTest, Propagation)
+{
+	Measured<double> a(10, 0.3);
+	Measured<double> b(5, 0.4);
+
+	EXPECT_DOUBLE_EQ(15, (a+b).value());
+	EXPECT_DOUBLE_EQ(0.5, (a+b).sigma());
+	EXPECT_DOUBLE_EQ(5, (a-b).value());
+	EXPECT_DOUBLE_EQ(0.5, (a-b).sigma());
+
+	// Relative uncertainties add in quadrature under * and /
+	EXPECT_DOUBLE_EQ(50, (a*b).value());
+	EXPECT_DOUBLE_EQ(50 * std::sqrt(0.03*0.03 + 0.08*0.08), (a*b).sigma());
+	EXPECT_DOUBLE_EQ(2, (a/b).value());
+	EXPECT_DOUBLE_EQ(2 * std::sqrt(0.03*0.03 + 0.08*0.08), (a/b).sigma());
+
+	// Scaling by an exact number
+	EXPECT_DOUBLE_EQ(-20, (a*-2).value());
+	EXPECT_DOUBLE_EQ(0.6, (a*-2).sigma());
+	EXPECT_DOUBLE_EQ(0.6, (-2*a).sigma());
+	EXPECT_DOUBLE_EQ(0.15, (a/2).sigma());
+}
+
+TEST(MeasuredTest, UnitCast)
+{
+	using namespace si;
+	using MeasuredMeters = Unit<Measured<float>, Length<meter>>;
+	using MeasuredCentimeters = Unit<Measured<float>, Length<std::centi>>;
+
+	MeasuredMeters a(Measured<float>(2, 0.01f));
+	auto b = unit_cast<MeasuredCentimeters>(a);
+	EXPECT_FLOAT_EQ(200, b.value().value());
+	EXPECT_FLOAT_EQ(1, b.value().sigma());
+
+	// Implicit conversion is available as for a floating-point rep
+	MeasuredCentimeters c(a);
+	EXPECT_FLOAT_EQ(200, c.value().value());
+	EXPECT_FLOAT_EQ(1, c.value().sigma());
+
+	// From an exact quantity
+	MeasuredCentimeters d(Meters(3));
+	EXPECT_FLOAT_EQ(300, d.value().value());
+	EXPECT_FLOAT_EQ(0, d.value().sigma());
+}
+
+TEST(MeasuredTest, UnitArithmetic)
+{
+	using namespace si;
+	using MeasuredMeters = Unit<Measured<float>, Length<meter>>;
+	using MeasuredCentimeters = Unit<Measured<float>, Length<std::centi>>;
+	using MeasuredSeconds = Unit<Measured<float>, Time<second>>;
+
+	MeasuredMeters a(Measured<float>(2, 0.02f));
+	MeasuredCentimeters b(Measured<float>(50, 3));
+
+	// Common base of centimeters
+	auto sum = a + b;
+	EXPECT_FLOAT_EQ(250, sum.value().value());
+	EXPECT_FLOAT_EQ(std::sqrt(2.f*2 + 3*3), sum.value().sigma());
+
+	auto area = a * b;
+	EXPECT_EQ(2, int(decltype(area)::base::dim::d1));
+	EXPECT_FLOAT_EQ(10000, area.value().value());
+	EXPECT_FLOAT_EQ(10000 * std::sqrt(0.01f*0.01f + 0.06f*0.06f), area.value().sigma());
+
+	auto speed = a / MeasuredSeconds(Measured<float>(4, 0.2f));
+	EXPECT_EQ( 1, int(decltype(speed)::base::dim::d1));
+	EXPECT_EQ(-1, int(decltype(speed)::base::dim::d2));
+	EXPECT_FLOAT_EQ(0.5f, speed.value().value());
+	EXPECT_FLOAT_EQ(0.5f * std::sqrt(0.01f*0.01f + 0.05f*0.05f), speed.value().sigma());
+
+	// Mixed with an exact quantity
+	auto c = Meters(2) * MeasuredMeters(Measured<float>(3, 0.1f));
+	EXPECT_FLOAT_EQ(6, c.value().value());
+	EXPECT_FLOAT_EQ(0.2f, c.value().sigma());
+}
+
+TEST(MeasuredTest, ArrayMatchesScalar)
+{
+	using namespace si;
+	using MeasuredMeters = Unit<Measured<float>, Length<meter>>;
+	using MeasuredCentimeters = Unit<Measured<float>, Length<std::centi>>;
+
+	MeasuredArray<float, Length<meter>> a;
+	MeasuredArray<float, Length<std::centi>> b;
+	for (int i = 1; i <= 5; ++i) {
+		a.push_back(MeasuredMeters(Measured<float>(i, 0.01f * i)));
+		b.push_back(MeasuredCentimeters(Measured<float>(10.f * i, 0.5f)));
+	}
+
+	auto sum = a + b;
+	auto diff = a - b;
+	auto product = a * b;
+	auto ratio = a / b;
+	ASSERT_EQ(5u, sum.size());
+	EXPECT_EQ(2, int(decltype(product)::base::dim::d1));
+	EXPECT_EQ(0, int(decltype(ratio)::base::dim::d1));
+
+	for (std::size_t i = 0; i < 5; ++i) {
+		EXPECT_FLOAT_EQ((a[i] + b[i]).value().value(), sum[i].value().value());
+		EXPECT_FLOAT_EQ((a[i] + b[i]).value().sigma(), sum[i].value().sigma());
+		EXPECT_FLOAT_EQ((a[i] - b[i]).value().value(), diff[i].value().value());
+		EXPECT_FLOAT_EQ((a[i] - b[i]).value().sigma(), diff[i].value().sigma());
+		EXPECT_FLOAT_EQ((a[i] * b[i]).value().value(), product[i].value().value());
+		EXPECT_FLOAT_EQ((a[i] * b[i]).value().sigma(), product[i].value().sigma());
+		EXPECT_FLOAT_EQ((a[i] / b[i]).value().value(), ratio[i].value().value());
+		EXPECT_FLOAT_EQ((a[i] / b[i]).value().sigma(), ratio[i].value().sigma());
+	}
+
+	auto mm = unit_cast<MeasuredArray<float, Length<std::milli>>>(a);
+	EXPECT_FLOAT_EQ(3000, mm[2].value().value());
+	EXPECT_FLOAT_EQ(30, mm[2].value().sigma());
+
+	// Columns are plain unit spans
+	EXPECT_FLOAT_EQ(3, a.values()[2].value());
+	EXPECT_FLOAT_EQ(0.03f, a.sigmas()[2].value());
+}
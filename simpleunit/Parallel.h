@@ -0,0 +1,329 @@
+#pragma once
+
+#include "simpleunit/UnitSpan.h"
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace sunit {
+namespace parallel {
+
+// A work-stealing thread pool. Each worker owns a deque of tasks: it pushes and pops its own work
+// at the back (newest first, which stays warm in cache) and, when empty, steals from the front of
+// another worker's deque (oldest first, which for recursively split ranges are the largest pieces).
+class ThreadPool
+{
+public:
+	using Task = std::function<void()>;
+
+	explicit ThreadPool(unsigned threads = std::max(1u, std::thread::hardware_concurrency()))
+		: stop_(false), pending_(0), next_(0)
+	{
+		assert(threads > 0);
+		for (unsigned i = 0; i < threads; ++i)
+			queues_.emplace_back(new Queue);
+		for (unsigned i = 0; i < threads; ++i)
+			threads_.emplace_back([this, i] { work(i); });
+	}
+
+	~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(sleep_mutex_);
+			stop_ = true;
+		}
+		wake_.notify_all();
+		for (auto& thread : threads_)
+			thread.join();
+	}
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	std::size_t size() const { return queues_.size(); }
+
+	// Schedule a task. From one of this pool's workers the task goes on that worker's own deque,
+	// otherwise the deques are filled in turn
+	void execute(Task task)
+	{
+		const std::size_t index = this_pool() == this ? this_index() : next_++ % queues_.size();
+		// Counted before it is pushed, so that a worker taking it cannot decrement the count first
+		{
+			std::lock_guard<std::mutex> lock(sleep_mutex_);
+			++pending_;
+		}
+		{
+			std::lock_guard<std::mutex> lock(queues_[index]->mutex);
+			queues_[index]->tasks.push_back(std::move(task));
+		}
+		wake_.notify_one();
+	}
+
+	// Run one pending task, if there is one. Lets a thread waiting on the pool help rather than block
+	bool try_run_one()
+	{
+		const std::size_t index = this_pool() == this ? this_index() : 0;
+		Task task;
+		if (!pop(index, task) && !steal(index, task))
+			return false;
+		task();
+		return true;
+	}
+
+private:
+	struct Queue
+	{
+		std::mutex mutex;
+		std::deque<Task> tasks;
+	};
+
+	static ThreadPool*& this_pool() { static thread_local ThreadPool* pool = nullptr; return pool; }
+	static std::size_t& this_index() { static thread_local std::size_t index = 0; return index; }
+
+	bool pop(std::size_t index, Task& task)
+	{
+		std::lock_guard<std::mutex> lock(queues_[index]->mutex);
+		if (queues_[index]->tasks.empty())
+			return false;
+		task = std::move(queues_[index]->tasks.back());
+		queues_[index]->tasks.pop_back();
+		--pending_;
+		return true;
+	}
+
+	bool steal(std::size_t index, Task& task)
+	{
+		for (std::size_t i = 1; i < queues_.size(); ++i) {
+			Queue& victim = *queues_[(index + i) % queues_.size()];
+			std::lock_guard<std::mutex> lock(victim.mutex);
+			if (!victim.tasks.empty()) {
+				task = std::move(victim.tasks.front());
+				victim.tasks.pop_front();
+				--pending_;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void work(std::size_t index)
+	{
+		this_pool() = this;
+		this_index() = index;
+		for (;;) {
+			Task task;
+			if (pop(index, task) || steal(index, task)) {
+				task();
+				continue;
+			}
+			std::unique_lock<std::mutex> lock(sleep_mutex_);
+			wake_.wait(lock, [this] { return stop_ || pending_ > 0; });
+			if (stop_ && pending_ == 0)
+				return;
+		}
+	}
+
+	std::vector<std::unique_ptr<Queue>> queues_;
+	std::vector<std::thread> threads_;
+	std::mutex sleep_mutex_;
+	std::condition_variable wake_;
+	bool stop_;
+	std::atomic<std::size_t> pending_;
+	std::atomic<std::size_t> next_;
+};
+
+// The pool used when no executor is given
+inline ThreadPool& default_pool()
+{
+	static ThreadPool pool;
+	return pool;
+}
+
+// Schedules a task to run at some point, on some thread. Any callable of this shape may stand in
+// for the built-in pool, e.g. to run on an application's own executor.
+using Executor = std::function<void(std::function<void()>)>;
+
+struct Options
+{
+	// Elements per task. Zero chooses a size from the working set of the operation (see grain_size)
+	std::size_t grain = 0;
+
+	// Where tasks run. If empty, the default pool
+	Executor executor;
+};
+
+// Bytes of input and output touched by one task when the grain is chosen automatically: small
+// enough to stay in a core's own cache, large enough that scheduling costs are negligible
+constexpr std::size_t target_chunk_bytes = 64 * 1024;
+constexpr std::size_t cache_line = 64;
+
+// Elements per task for an operation touching `bytes_per_element` per element, rounded to whole
+// cache lines of output so that neighbouring tasks never write the same line
+inline std::size_t grain_size(std::size_t bytes_per_element, std::size_t output_size)
+{
+	const std::size_t line = std::max<std::size_t>(1, cache_line / output_size);
+	const std::size_t grain = std::max<std::size_t>(1, target_chunk_bytes / bytes_per_element);
+	return (grain + line - 1) / line * line;
+}
+
+namespace detail
+{
+	// Counts outstanding elements, and keeps the first exception thrown by any task
+	class Latch
+	{
+	public:
+		explicit Latch(std::size_t count) : count_(count) {}
+
+		void count_down(std::size_t n)
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			count_ -= n;
+			if (count_ == 0)
+				done_.notify_all();
+		}
+
+		void fail(std::exception_ptr e)
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			if (!error_) error_ = e;
+		}
+
+		bool ready()
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			return count_ == 0;
+		}
+
+		void wait()
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			done_.wait(lock, [this] { return count_ == 0; });
+			if (error_)
+				std::rethrow_exception(error_);
+		}
+
+	private:
+		std::mutex mutex_;
+		std::condition_variable done_;
+		std::size_t count_;
+		std::exception_ptr error_;
+	};
+
+	// Split [begin, end) in halves down to the grain, scheduling the upper half each time and
+	// carrying on with the lower, so idle workers steal large pieces first
+	template <typename F>
+	void split(std::size_t begin, std::size_t end, std::size_t grain, F& f, const Executor& executor, Latch& latch)
+	{
+		while (end - begin > grain) {
+			const std::size_t mid = begin + ((end - begin) / 2 + grain - 1) / grain * grain;
+			if (mid >= end) break;
+			executor([=, &f, &executor, &latch] { split(mid, end, grain, f, executor, latch); });
+			end = mid;
+		}
+		try {
+			f(begin, end);
+		}
+		catch (...) {
+			latch.fail(std::current_exception());
+		}
+		latch.count_down(end - begin);
+	}
+}
+
+// Call f(begin, end) over subranges of [0, n) in parallel, returning once all have completed
+template <typename F>
+void for_range(std::size_t n, std::size_t grain, F f, const Options& options = Options())
+{
+	assert(grain > 0);
+	if (n == 0)
+		return;
+	if (n <= grain) {
+		f(std::size_t(0), n);
+		return;
+	}
+
+	ThreadPool& pool = default_pool();
+	const Executor executor = options.executor ? options.executor
+	                                           : Executor([&pool](std::function<void()> task) { pool.execute(std::move(task)); });
+	detail::Latch latch(n);
+	detail::split(0, n, grain, f, executor, latch);
+
+	// On the built-in pool, help with outstanding work rather than block
+	if (!options.executor)
+		while (!latch.ready() && pool.try_run_one()) {}
+	latch.wait();
+}
+
+// Apply f to every element of a span, in parallel
+template <typename T, typename B, typename F>
+void for_each(UnitSpan<T,B> values, F f, const Options& options = Options())
+{
+	const std::size_t grain = options.grain ? options.grain
+	                                        : grain_size(sizeof(T), sizeof(T));
+	for_range(values.size(), grain, [&](std::size_t begin, std::size_t end) {
+		for (std::size_t i = begin; i < end; ++i)
+			f(values[i]);
+	}, options);
+}
+
+// out[i] = op(in[i]). Results convert implicitly to the output unit, so a result of the wrong
+// dimension does not compile
+template <typename X, typename B1, typename Z, typename B3, typename Op,
+          typename = decltype(std::declval<Op&>()(std::declval<const Unit<std::remove_const_t<X>,B1>&>()))>
+void transform(UnitSpan<X,B1> in, UnitSpan<Z,B3> out, Op op, const Options& options = Options())
+{
+	assert(in.size() == out.size());
+	const std::size_t grain = options.grain ? options.grain
+	                                        : grain_size(sizeof(X) + sizeof(Z), sizeof(Z));
+	for_range(in.size(), grain, [&](std::size_t begin, std::size_t end) {
+		for (std::size_t i = begin; i < end; ++i)
+			out[i] = op(in[i]);
+	}, options);
+}
+
+// out[i] = op(in1[i], in2[i])
+template <typename X, typename B1, typename Y, typename B2, typename Z, typename B3, typename Op>
+void transform(UnitSpan<X,B1> in1, UnitSpan<Y,B2> in2, UnitSpan<Z,B3> out, Op op, const Options& options = Options())
+{
+	assert(in1.size() == out.size() && in2.size() == out.size());
+	const std::size_t grain = options.grain ? options.grain
+	                                        : grain_size(sizeof(X) + sizeof(Y) + sizeof(Z), sizeof(Z));
+	for_range(out.size(), grain, [&](std::size_t begin, std::size_t end) {
+		for (std::size_t i = begin; i < end; ++i)
+			out[i] = op(in1[i], in2[i]);
+	}, options);
+}
+
+// As above, into a new array whose unit is the return type of op
+//
+//     auto force = parallel::transform(make_span(mass), make_span(acceleration),
+//                                      [](Kilograms m, Meters_Second2 a) { return m * a; });
+template <typename X, typename B1, typename Op,
+          typename R = decltype(std::declval<Op&>()(std::declval<const Unit<std::remove_const_t<X>,B1>&>()))>
+UnitArray<typename R::rep, typename R::base> transform(UnitSpan<X,B1> in, Op op, const Options& options = Options())
+{
+	UnitArray<typename R::rep, typename R::base> out(in.size());
+	transform(in, make_span(out), op, options);
+	return out;
+}
+
+template <typename X, typename B1, typename Y, typename B2, typename Op,
+          typename R = decltype(std::declval<Op&>()(std::declval<const Unit<std::remove_const_t<X>,B1>&>(),
+                                                     std::declval<const Unit<std::remove_const_t<Y>,B2>&>()))>
+UnitArray<typename R::rep, typename R::base> transform(UnitSpan<X,B1> in1, UnitSpan<Y,B2> in2, Op op, const Options& options = Options())
+{
+	UnitArray<typename R::rep, typename R::base> out(in1.size());
+	transform(in1, in2, make_span(out), op, options);
+	return out;
+}
+
+} // parallel
+} // sunit
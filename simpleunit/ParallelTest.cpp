@@ -0,0 +1,108 @@
+#include "simpleunit/Parallel.h"
+#include <atomic>
+#include <stdexcept>
+#include "gtest/gtest.h"
+
+using namespace std;
+using namespace sunit;
+
+TEST(ParallelTest, ThreadPool)
+{
+	parallel::ThreadPool pool(3);
+	EXPECT_EQ(3u, pool.size());
+
+	std::atomic<int> count(0);
+	for (int i = 0; i < 1000; ++i)
+		pool.execute([&count] { ++count; });
+	while (count < 1000)
+		pool.try_run_one();
+	EXPECT_EQ(1000, count);
+}
+
+TEST(ParallelTest, TransformForce)
+{
+	using namespace si;
+
+	const std::size_t n = 100003;
+	UnitArray<float, Mass<kg>> mass(n);
+	UnitArray<float, Acceleration<meter, second>> acceleration(n);
+	for (std::size_t i = 0; i < n; ++i) {
+		mass[i] = Kilograms(1 + i % 10);
+		acceleration[i] = Meters_Second2(0.5f * (i % 3));
+	}
+
+	auto kernel = [](const Kilograms& m, const Meters_Second2& a) { return m * a; };
+
+	// The output unit follows from the kernel
+	auto force = parallel::transform(make_span(mass), make_span(acceleration), kernel);
+	EXPECT_EQ(1, (std::is_same<KilogramMeters_Second2, decltype(force)::value_type>::value));
+	ASSERT_EQ(n, force.size());
+	for (std::size_t i = 0; i < n; ++i)
+		ASSERT_FLOAT_EQ((1 + i % 10) * 0.5f * (i % 3), force[i].value());
+
+	// Into an existing span, at any grain
+	for (std::size_t grain : {1, 7, 4096}) {
+		UnitArray<float, Force<meter, second, kg>> out(n);
+		parallel::Options options;
+		options.grain = grain;
+		parallel::transform(make_span(mass), make_span(acceleration), make_span(out), kernel, options);
+		EXPECT_FLOAT_EQ(force[n - 1].value(), out[n - 1].value());
+		EXPECT_FLOAT_EQ(force[n / 2].value(), out[n / 2].value());
+	}
+}
+
+TEST(ParallelTest, TransformConverts)
+{
+	using namespace si;
+
+	UnitArray<float, Length<meter>> in = {Meters(1), Meters(2), Meters(3)};
+	UnitArray<float, Length<std::centi>> out(3);
+	parallel::Options options;
+	options.grain = 1;
+	parallel::transform(make_span(in), make_span(out), [](const Meters& m) { return m * 2; }, options);
+	EXPECT_FLOAT_EQ(600, out[2].value());
+
+	//UnitArray<float, Time<second>> bad(3);
+	//parallel::transform(make_span(in), make_span(bad), [](const Meters& m) { return m; });  // Should not compile
+}
+
+TEST(ParallelTest, ForEach)
+{
+	using namespace si;
+
+	UnitArray<float, Length<meter>> values(10000, Meters(1));
+	parallel::Options options;
+	options.grain = 100;
+	parallel::for_each(make_span(values), [](Meters& m) { m *= 3; }, options);
+	for (const auto& v : values)
+		ASSERT_FLOAT_EQ(3, v.value());
+}
+
+TEST(ParallelTest, Executor)
+{
+	using namespace si;
+
+	// A user-supplied executor, here one that runs tasks immediately
+	std::atomic<int> scheduled(0);
+	parallel::Options options;
+	options.grain = 10;
+	options.executor = [&scheduled](std::function<void()> task) { ++scheduled; task(); };
+
+	UnitArray<float, Length<meter>> in(1000, Meters(2));
+	auto out = parallel::transform(make_span(in), [](const Meters& m) { return m * m; }, options);
+	EXPECT_EQ(2, int(decltype(out)::value_type::base::dim::d1));
+	EXPECT_FLOAT_EQ(4, out[999].value());
+	EXPECT_EQ(99, scheduled);
+}
+
+TEST(ParallelTest, Exceptions)
+{
+	using namespace si;
+
+	UnitArray<float, Length<meter>> values(1000, Meters(1));
+	parallel::Options options;
+	options.grain = 10;
+	EXPECT_THROW(parallel::for_each(make_span(values), [](Meters& m) {
+		if (m.value() == 1) throw std::runtime_error("bad value");
+	}, options), std::runtime_error);
+}
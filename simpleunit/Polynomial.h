@@ -0,0 +1,162 @@
+#pragma once
+
+#include "simpleunit/DynamicUnit.h"
+#include "simpleunit/UnitSpan.h"
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+namespace sunit {
+
+// A polynomial y = a0 + a1 x + ... + aN x^N from XUnit to YUnit, of degree N. Coefficient k is in
+// YUnit / XUnit^k, worked out at compile time, and may be given in any unit of that dimension:
+//
+//     // Height of a dropped ball: h = h0 + v0 t + a t^2 / 2
+//     Polynomial<Seconds, Meters, 2> height(Meters(100), Meters_Second(0), Meters_Second2(-4.9f));
+//     Meters h = height(Seconds(2));
+//     height.evaluate(make_span(times), make_span(heights));
+//
+// Scales of the coefficients, of x and of y fold into plain coefficients on construction, so
+// evaluation is arithmetic on values alone, by Horner's rule or Estrin's scheme.
+
+enum class PolynomialScheme
+{
+	horner,  // fewest operations, each depending on the last
+	estrin   // more operations, but in independent pairs that pipeline
+};
+
+namespace detail
+{
+	template <typename DY, typename DX, int K>
+	using CoefficientDim = Dim<DY::d1 - K * DX::d1, DY::d2 - K * DX::d2, DY::d3 - K * DX::d3>;
+
+	template <typename T, std::size_t N>
+	T horner(const std::array<T, N + 1>& c, T x)
+	{
+		T y = c[N];
+		for (std::size_t k = N; k-- > 0;)
+			y = y * x + c[k];
+		return y;
+	}
+
+	// Pairs c[k] + c[k+1] x, then pairs of those with x^2, and so on with x^4...
+	template <typename T, std::size_t N>
+	T estrin(const std::array<T, N + 1>& c, T x)
+	{
+		std::array<T, N + 1> t;
+		std::size_t n = N + 1;
+		for (std::size_t k = 0; k < n; k += 2)
+			t[k / 2] = k + 1 < n ? c[k] + c[k + 1] * x : c[k];
+		n = (n + 1) / 2;
+		for (T p = x * x; n > 1; p *= p) {
+			for (std::size_t k = 0; k < n; k += 2)
+				t[k / 2] = k + 1 < n ? t[k] + t[k + 1] * p : t[k];
+			n = (n + 1) / 2;
+		}
+		return t[0];
+	}
+}
+
+template <typename XUnit, typename YUnit, std::size_t N>
+class Polynomial
+{
+public:
+	using x_unit = XUnit;
+	using y_unit = YUnit;
+	using rep = typename YUnit::rep;
+
+	static constexpr std::size_t degree = N;
+
+	// The unit of coefficient k: YUnit / XUnit^k, in YUnit's ratios where it has them
+	template <std::size_t K>
+	using coefficient_unit = Unit<rep, CommonBase<detail::CoefficientDim<typename YUnit::base::dim, typename XUnit::base::dim, int(K)>,
+	                                              typename YUnit::base, typename XUnit::base>>;
+
+	// From the N + 1 coefficients, a0 first, each in any unit of its dimension
+	template <typename... C, typename = std::enable_if_t<sizeof...(C) == N + 1>>
+	explicit Polynomial(const C&... coefficients)
+	{
+		set(std::make_index_sequence<N + 1>(), coefficients...);
+	}
+
+	// The same curve, for x and y in other units of the same dimensions
+	template <typename X2, typename Y2>
+	Polynomial(const Polynomial<X2,Y2,N>& rhs)
+	{
+		const double sx = conversion_factor(dynamic_unit<typename XUnit::base>(), dynamic_unit<typename X2::base>());
+		const double sy = conversion_factor(dynamic_unit<typename Y2::base>(), dynamic_unit<typename YUnit::base>());
+		double p = sy;
+		for (std::size_t k = 0; k <= N; ++k, p *= sx)
+			c_[k] = static_cast<rep>(rhs.values()[k] * p);
+	}
+
+	template <std::size_t K>
+	coefficient_unit<K> coefficient() const
+	{
+		static_assert(K <= N, "no such coefficient");
+		return coefficient_unit<K>(static_cast<rep>(c_[K] / fold<K>()));
+	}
+
+	// The folded coefficients: y's value from x's, in YUnit and XUnit
+	const std::array<rep, N + 1>& values() const { return c_; }
+
+	YUnit operator()(const XUnit& x, PolynomialScheme scheme = PolynomialScheme::horner) const
+	{
+		const rep v = static_cast<rep>(x.value());
+		return YUnit(scheme == PolynomialScheme::horner ? detail::horner<rep, N>(c_, v) : detail::estrin<rep, N>(c_, v));
+	}
+
+	// y[i] = p(x[i]) over spans, with no conversion in the loop
+	template <typename X, typename Y>
+	void evaluate(UnitSpan<X, typename XUnit::base> x, UnitSpan<Y, typename YUnit::base> y,
+	              PolynomialScheme scheme = PolynomialScheme::horner) const
+	{
+		static_assert(std::is_same<std::remove_const_t<X>, typename XUnit::rep>::value &&
+		              std::is_same<Y, rep>::value, "spans of the polynomial's units");
+		assert(x.size() == y.size());
+		const X* in = x.values();
+		rep* out = y.values();
+		const std::array<rep, N + 1> c = c_;
+		if (scheme == PolynomialScheme::horner)
+			for (std::size_t i = 0; i < x.size(); ++i)
+				out[i] = detail::horner<rep, N>(c, static_cast<rep>(in[i]));
+		else
+			for (std::size_t i = 0; i < x.size(); ++i)
+				out[i] = detail::estrin<rep, N>(c, static_cast<rep>(in[i]));
+	}
+
+	UnitArray<rep, typename YUnit::base> operator()(UnitSpan<const typename XUnit::rep, typename XUnit::base> x,
+	                                                PolynomialScheme scheme = PolynomialScheme::horner) const
+	{
+		UnitArray<rep, typename YUnit::base> y(x.size());
+		evaluate(x, make_span(y), scheme);
+		return y;
+	}
+
+private:
+	// What a coefficient's value is multiplied by to act on x's value and give y's
+	template <std::size_t K>
+	static double fold()
+	{
+		double s = dynamic_unit<typename coefficient_unit<K>::base>().scale;
+		for (std::size_t k = 0; k < K; ++k)
+			s *= dynamic_unit<typename XUnit::base>().scale;
+		return s / dynamic_unit<typename YUnit::base>().scale;
+	}
+
+	template <std::size_t... K, typename... C>
+	void set(std::index_sequence<K...>, const C&... coefficients)
+	{
+		const int expand[] = {0, (c_[K] = static_cast<rep>(coefficient_unit<K>(coefficients).value() * fold<K>()), 0)...};
+		(void)expand;
+	}
+
+	std::array<rep, N + 1> c_;
+};
+
+template <typename XUnit, typename YUnit, std::size_t N>
+constexpr std::size_t Polynomial<XUnit,YUnit,N>::degree;
+
+} // sunit
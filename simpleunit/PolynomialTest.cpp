@@ -0,0 +1,80 @@
+#include "simpleunit/Polynomial.h"
+#include "gtest/gtest.h"
+
+using namespace std;
+using namespace sunit;
+
+namespace
+{
+	using Milliseconds = Unit<float, Time<std::milli>>;
+	using Millimeters = Unit<float, Length<std::milli>>;
+	using Centimeters_Second2 = Unit<double, Acceleration<std::centi, si::second>>;
+	using Height = Polynomial<si::Seconds, si::Meters, 2>;
+}
+
+TEST(PolynomialTest, CoefficientUnits)
+{
+	static_assert(is_same<Height::coefficient_unit<0>::base::dim, Dim<1>>::value, "a0 is a length");
+	static_assert(is_same<Height::coefficient_unit<1>::base::dim, Dim<1,-1>>::value, "a1 is a speed");
+	static_assert(is_same<Height::coefficient_unit<2>::base::dim, Dim<1,-2>>::value, "a2 is an acceleration");
+	static_assert(Height::degree == 2, "");
+}
+
+TEST(PolynomialTest, Evaluate)
+{
+	const Height h(si::Meters(100), si::Meters_Second(2), si::Meters_Second2(-4.9f));
+	EXPECT_FLOAT_EQ(100, h(si::Seconds(0)).value());
+	EXPECT_FLOAT_EQ(100 + 4 - 19.6f, h(si::Seconds(2)).value());
+	EXPECT_FLOAT_EQ(100 + 4 - 19.6f, h(si::Seconds(2), PolynomialScheme::estrin).value());
+	EXPECT_FLOAT_EQ(-4.9f, h.coefficient<2>().value());
+}
+
+TEST(PolynomialTest, CoefficientScalesFold)
+{
+	// The same curve, with coefficients given in millimetres and cm/s^2
+	const Height h(Millimeters(100000), si::Meters_Second(2), Centimeters_Second2(-490));
+	EXPECT_FLOAT_EQ(100, h.values()[0]);
+	EXPECT_FLOAT_EQ(-4.9f, h.values()[2]);
+	EXPECT_FLOAT_EQ(100 + 4 - 19.6f, h(si::Seconds(2)).value());
+
+	// And for x in milliseconds and y in millimetres: the conversions are in the coefficients
+	const Polynomial<Milliseconds, Millimeters, 2> ms(h);
+	EXPECT_NEAR(100000, ms.values()[0], 1e-2);
+	EXPECT_NEAR(2, ms.values()[1], 1e-6);
+	EXPECT_NEAR(-4.9e-3, ms.values()[2], 1e-9);
+	EXPECT_NEAR(84400, ms(Milliseconds(2000)).value(), 1e-1);
+	// Coefficients read back in the natural unit for that x and y
+	EXPECT_NEAR(2, ms.coefficient<1>().value(), 1e-6);
+}
+
+TEST(PolynomialTest, EstrinMatchesHorner)
+{
+	using P = Polynomial<Unit<double, BaseUnit<Dim<0>>>, Unit<double, BaseUnit<Dim<0>>>, 7>;
+	using D = Unit<double, BaseUnit<Dim<0>>>;
+	const P p(D(1), D(-2), D(0.5), D(3), D(-0.25), D(0.125), D(1.5), D(-0.75));
+	for (double x = -2; x <= 2; x += 0.125) {
+		const double expected = 1 - 2 * x + 0.5 * x * x + 3 * pow(x, 3) - 0.25 * pow(x, 4) + 0.125 * pow(x, 5) + 1.5 * pow(x, 6) - 0.75 * pow(x, 7);
+		EXPECT_NEAR(expected, p(D(x)).value(), 1e-9);
+		EXPECT_NEAR(expected, p(D(x), PolynomialScheme::estrin).value(), 1e-9);
+	}
+	const Polynomial<D, D, 0> constant(D(3));
+	EXPECT_EQ(3, constant(D(7), PolynomialScheme::estrin).value());
+	const Polynomial<D, D, 4> quartic(D(1), D(1), D(1), D(1), D(1));
+	EXPECT_EQ(31, quartic(D(2), PolynomialScheme::estrin).value());
+}
+
+TEST(PolynomialTest, Bulk)
+{
+	const Height h(si::Meters(100), si::Meters_Second(2), si::Meters_Second2(-4.9f));
+	UnitArray<float, Time<si::second>> t;
+	for (int i = 0; i < 1000; ++i)
+		t.push_back(si::Seconds(i * 0.01f));
+	const auto y = h(make_span(t));
+	UnitArray<float, Length<si::meter>> e(t.size());
+	h.evaluate(make_span(t), make_span(e), PolynomialScheme::estrin);
+	ASSERT_EQ(t.size(), y.size());
+	for (size_t i = 0; i < t.size(); ++i) {
+		EXPECT_FLOAT_EQ(h(t[i]).value(), y[i].value());
+		EXPECT_NEAR(y[i].value(), e[i].value(), 1e-4);
+	}
+}
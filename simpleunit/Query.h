@@ -0,0 +1,384 @@
+#pragma once
+
+#include "simpleunit/Accumulator.h"
+#include "simpleunit/Parallel.h"
+#include "simpleunit/UnitSpan.h"
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace sunit {
+
+// Filtering, projection and aggregation over the columns of a UnitSoA. Predicates are given in any
+// unit of the column's dimension, and converted to the column's unit once, when added:
+//
+//     using Kilometers_Hour = Unit<float, Velocity<std::kilo, si::hour>>;
+//     auto fast = query(trips).where<1>(above(Kilometers_Hour(30)));   // column 1 in m/s
+//     std::size_t n = fast.count();
+//     Meters total = fast.sum<2>();
+//     auto by_vehicle = fast.group_by<0, 2>();
+//
+// Rows are filtered in blocks, each predicate narrowing a selection vector of row indices, so
+// later predicates only test rows still selected. Blocks are filtered, and groups aggregated in
+// hash tables, in parallel, then combined in order.
+
+enum class Comparison { less, less_equal, greater, greater_equal, equal, not_equal, between };
+
+template <typename U>
+struct Predicate
+{
+	Comparison comparison;
+	U value;
+	U upper;  // for between
+};
+
+template <typename T, typename B> Predicate<Unit<T,B>> below(const Unit<T,B>& x) { return {Comparison::less, x, x}; }
+template <typename T, typename B> Predicate<Unit<T,B>> at_most(const Unit<T,B>& x) { return {Comparison::less_equal, x, x}; }
+template <typename T, typename B> Predicate<Unit<T,B>> above(const Unit<T,B>& x) { return {Comparison::greater, x, x}; }
+template <typename T, typename B> Predicate<Unit<T,B>> at_least(const Unit<T,B>& x) { return {Comparison::greater_equal, x, x}; }
+template <typename T, typename B> Predicate<Unit<T,B>> equals(const Unit<T,B>& x) { return {Comparison::equal, x, x}; }
+template <typename T, typename B> Predicate<Unit<T,B>> not_equals(const Unit<T,B>& x) { return {Comparison::not_equal, x, x}; }
+
+// lo <= x <= hi
+template <typename T, typename B>
+Predicate<Unit<T,B>> between(const Unit<T,B>& lo, const Unit<T,B>& hi) { return {Comparison::between, lo, hi}; }
+
+namespace detail
+{
+	// Sums of a column: integers in 64 bits, floating point with Neumaier's compensation
+	template <typename T, bool = std::is_floating_point<T>::value>
+	struct ColumnSum
+	{
+		using type = T;
+		using policy = NeumaierSum<T>;
+	};
+
+	template <typename T>
+	struct ColumnSum<T, false>
+	{
+		using type = std::conditional_t<std::is_signed<T>::value, std::int64_t, std::uint64_t>;
+		using policy = WideSum<type>;
+	};
+
+	// Sum and range of a set of values of a column, merged across parts in any grouping
+	template <typename T>
+	struct ColumnSummary
+	{
+		typename ColumnSum<T>::policy sum;
+		T min = std::numeric_limits<T>::max();
+		T max = std::numeric_limits<T>::lowest();
+
+		void add(T x)
+		{
+			sum.add(static_cast<typename ColumnSum<T>::type>(x));
+			min = std::min(min, x);
+			max = std::max(max, x);
+		}
+
+		void merge(const ColumnSummary& rhs)
+		{
+			sum.merge(rhs.sum);
+			min = std::min(min, rhs.min);
+			max = std::max(max, rhs.max);
+		}
+	};
+}
+
+// Aggregates of one group of rows. Integer sums are 64-bit
+template <typename Key, typename Value>
+struct QueryGroup
+{
+	using sum_unit = Unit<typename detail::ColumnSum<typename Value::rep>::type, typename Value::base>;
+
+	Key key;
+	std::size_t count;
+	sum_unit sum;
+	Value min;
+	Value max;
+
+	Value mean() const
+	{
+		using S = typename sum_unit::rep;
+		return Value(static_cast<typename Value::rep>(sum.value() / static_cast<S>(count)));
+	}
+};
+
+namespace detail
+{
+	// Narrow a selection: keep the rows of sel[0, n) (or, if dense, of [base, base + n)) that pass
+	template <typename T, typename F>
+	std::size_t select_rows(const T* x, std::size_t base, std::size_t n, bool dense, std::uint32_t* sel, F pass)
+	{
+		std::size_t k = 0;
+		if (dense)
+			for (std::size_t i = 0; i < n; ++i) {
+				sel[k] = static_cast<std::uint32_t>(base + i);
+				k += pass(x[base + i]);
+			}
+		else
+			for (std::size_t i = 0; i < n; ++i) {
+				const std::uint32_t row = sel[i];
+				sel[k] = row;
+				k += pass(x[row]);
+			}
+		return k;
+	}
+
+	// Integers compare in double, so that fractional thresholds keep their meaning
+	template <typename T>
+	using CompareType = std::conditional_t<std::is_floating_point<T>::value, T, double>;
+
+	template <typename T>
+	std::size_t filter_rows(const T* x, Comparison c, CompareType<T> a, CompareType<T> b,
+	                        std::size_t base, std::size_t n, bool dense, std::uint32_t* sel)
+	{
+		using C = CompareType<T>;
+		switch (c) {
+		case Comparison::less: return select_rows(x, base, n, dense, sel, [a](T v) { return static_cast<C>(v) < a; });
+		case Comparison::less_equal: return select_rows(x, base, n, dense, sel, [a](T v) { return static_cast<C>(v) <= a; });
+		case Comparison::greater: return select_rows(x, base, n, dense, sel, [a](T v) { return static_cast<C>(v) > a; });
+		case Comparison::greater_equal: return select_rows(x, base, n, dense, sel, [a](T v) { return static_cast<C>(v) >= a; });
+		case Comparison::equal: return select_rows(x, base, n, dense, sel, [a](T v) { return static_cast<C>(v) == a; });
+		case Comparison::not_equal: return select_rows(x, base, n, dense, sel, [a](T v) { return static_cast<C>(v) != a; });
+		case Comparison::between:
+			return select_rows(x, base, n, dense, sel, [a, b](T v) { return (static_cast<C>(v) >= a) & (static_cast<C>(v) <= b); });
+		}
+		return 0;
+	}
+}
+
+template <typename Table>
+class Query;
+
+template <typename Alloc, typename... Units>
+class Query<BasicUnitSoA<Alloc, Units...>>
+{
+public:
+	using table_type = BasicUnitSoA<Alloc, Units...>;
+	template <std::size_t I>
+	using column_unit = typename table_type::template column_unit<I>;
+	template <std::size_t I>
+	using sum_unit = typename QueryGroup<column_unit<I>, column_unit<I>>::sum_unit;
+
+	static constexpr std::size_t block = 1024;
+
+	// The query refers to the table's columns, so the table must outlive it
+	explicit Query(const table_type& table, const parallel::Options& options = parallel::Options())
+		: table_(table), options_(options)
+	{
+		assert(table.size() <= std::numeric_limits<std::uint32_t>::max());
+	}
+
+	Query(const table_type&&, const parallel::Options& = parallel::Options()) = delete;
+
+	// Keep rows whose column I passes, with the predicate's values converted to the column's unit
+	template <std::size_t I, typename X, typename Bx>
+	Query& where(const Predicate<Unit<X,Bx>>& p)
+	{
+		using U = column_unit<I>;
+		using T = typename U::rep;
+		using C = detail::CompareType<T>;
+		const C a = unit_cast<Unit<C, typename U::base>>(p.value).value();
+		const C b = unit_cast<Unit<C, typename U::base>>(p.upper).value();
+		const T* x = table_.template column<I>().values();
+		const Comparison c = p.comparison;
+		filters_.push_back([=](std::size_t base, std::size_t n, bool dense, std::uint32_t* sel) {
+			return detail::filter_rows(x, c, a, b, base, n, dense, sel);
+		});
+		return *this;
+	}
+
+	// Indices of the rows selected, in order
+	std::vector<std::uint32_t> selection() const
+	{
+		std::vector<std::uint32_t> out;
+		for (const auto& part : parts())
+			out.insert(out.end(), part.begin(), part.end());
+		return out;
+	}
+
+	std::size_t count() const
+	{
+		std::size_t n = 0;
+		for (const auto& part : parts())
+			n += part.size();
+		return n;
+	}
+
+	// Integer columns sum in 64 bits, floating-point columns with compensation
+	template <std::size_t I>
+	sum_unit<I> sum() const { return sum_unit<I>(summary<I>().sum.result()); }
+
+	// The smallest and largest values selected: max() and lowest() of the rep if none are
+	template <std::size_t I>
+	column_unit<I> min() const { return column_unit<I>(summary<I>().min); }
+
+	template <std::size_t I>
+	column_unit<I> max() const { return column_unit<I>(summary<I>().max); }
+
+	template <std::size_t I>
+	column_unit<I> mean() const
+	{
+		using T = typename column_unit<I>::rep;
+		using S = typename sum_unit<I>::rep;
+		std::size_t n = 0;
+		const S sum = summary<I>(&n).sum.result();
+		return column_unit<I>(n ? static_cast<T>(sum / static_cast<S>(n)) : T(0));
+	}
+
+	// The selected rows of the given columns
+	template <std::size_t... I>
+	UnitSoA<column_unit<I>...> select() const
+	{
+		const std::vector<std::uint32_t> rows = selection();
+		UnitSoA<column_unit<I>...> out(rows.size());
+		gather(rows, out, std::index_sequence<I...>(), std::index_sequence_for<column_unit<I>...>());
+		return out;
+	}
+
+	// Count, sum, min and max of column V for each value of column K, in order of key
+	template <std::size_t K, std::size_t V>
+	std::vector<QueryGroup<column_unit<K>, column_unit<V>>> group_by() const
+	{
+		using Key = typename column_unit<K>::rep;
+		using T = typename column_unit<V>::rep;
+		struct State
+		{
+			std::size_t count = 0;
+			detail::ColumnSummary<T> summary;
+		};
+		using Map = std::unordered_map<Key, State>;
+
+		const Key* keys = table_.template column<K>().values();
+		const T* values = table_.template column<V>().values();
+		const std::vector<std::vector<std::uint32_t>> selected = parts();
+		std::vector<Map> maps(selected.size());
+		parallel::for_range(selected.size(), grain(), [&](std::size_t p0, std::size_t p1) {
+			for (std::size_t p = p0; p < p1; ++p)
+				for (std::uint32_t row : selected[p]) {
+					State& s = maps[p][keys[row]];
+					++s.count;
+					s.summary.add(values[row]);
+				}
+		}, options_);
+
+		Map all;
+		for (const Map& m : maps)
+			for (const auto& kv : m) {
+				State& s = all[kv.first];
+				s.count += kv.second.count;
+				s.summary.merge(kv.second.summary);
+			}
+
+		std::vector<QueryGroup<column_unit<K>, column_unit<V>>> groups;
+		groups.reserve(all.size());
+		for (const auto& kv : all)
+			groups.push_back({column_unit<K>(kv.first), kv.second.count, sum_unit<V>(kv.second.summary.sum.result()),
+			                  column_unit<V>(kv.second.summary.min), column_unit<V>(kv.second.summary.max)});
+		std::sort(groups.begin(), groups.end(), [](const auto& a, const auto& b) { return a.key.value() < b.key.value(); });
+		return groups;
+	}
+
+private:
+	using Filter = std::function<std::size_t(std::size_t base, std::size_t n, bool dense, std::uint32_t* sel)>;
+
+	// Rows per part, each filtered by one task
+	static constexpr std::size_t part_blocks = 16;
+
+	// Parts per task, from the options' grain in rows
+	std::size_t grain() const { return std::max<std::size_t>(1, options_.grain / (part_blocks * block)); }
+
+	// The selected rows of each part of the table, in order
+	std::vector<std::vector<std::uint32_t>> parts() const
+	{
+		const std::size_t n = table_.size();
+		const std::size_t rows = part_blocks * block;
+		std::vector<std::vector<std::uint32_t>> out((n + rows - 1) / rows);
+		parallel::for_range(out.size(), grain(), [&](std::size_t p0, std::size_t p1) {
+			std::uint32_t sel[block];
+			for (std::size_t p = p0; p < p1; ++p) {
+				std::vector<std::uint32_t>& part = out[p];
+				for (std::size_t b = p * rows; b < std::min(n, (p + 1) * rows); b += block) {
+					const std::size_t m = std::min(block, n - b);
+					std::size_t k = m;
+					bool dense = true;
+					for (const Filter& f : filters_) {
+						k = f(b, k, dense, sel);
+						dense = false;
+						if (k == 0) break;
+					}
+					if (dense)
+						for (std::size_t i = 0; i < m; ++i)
+							part.push_back(static_cast<std::uint32_t>(b + i));
+					else
+						part.insert(part.end(), sel, sel + k);
+				}
+			}
+		}, options_);
+		return out;
+	}
+
+	// Sum, min and max of column I over the selected rows, with their count if asked, from one pass
+	// of the filters
+	template <std::size_t I>
+	detail::ColumnSummary<typename column_unit<I>::rep> summary(std::size_t* count = nullptr) const
+	{
+		using T = typename column_unit<I>::rep;
+		const T* x = table_.template column<I>().values();
+		const std::vector<std::vector<std::uint32_t>> selected = parts();
+		if (count) {
+			*count = 0;
+			for (const auto& part : selected)
+				*count += part.size();
+		}
+		std::vector<detail::ColumnSummary<T>> partial(selected.size());
+		parallel::for_range(selected.size(), grain(), [&](std::size_t p0, std::size_t p1) {
+			for (std::size_t p = p0; p < p1; ++p)
+				for (std::uint32_t row : selected[p])
+					partial[p].add(x[row]);
+		}, options_);
+		detail::ColumnSummary<T> total;
+		for (const auto& s : partial)
+			total.merge(s);
+		return total;
+	}
+
+	template <typename Out, std::size_t... I, std::size_t... J>
+	void gather(const std::vector<std::uint32_t>& rows, Out& out, std::index_sequence<I...>, std::index_sequence<J...>) const
+	{
+		auto copy = [&rows](auto in, auto dst) {
+			for (std::size_t r = 0; r < rows.size(); ++r)
+				dst[r] = in[rows[r]];
+			return 0;
+		};
+		const int expand[] = {0, copy(table_.template column<I>().values(), out.template column<J>().values())...};
+		(void)expand;
+	}
+
+	const table_type& table_;
+	parallel::Options options_;
+	std::vector<Filter> filters_;
+};
+
+template <typename Alloc, typename... Units>
+constexpr std::size_t Query<BasicUnitSoA<Alloc, Units...>>::block;
+template <typename Alloc, typename... Units>
+constexpr std::size_t Query<BasicUnitSoA<Alloc, Units...>>::part_blocks;
+
+template <typename Alloc, typename... Units>
+Query<BasicUnitSoA<Alloc, Units...>> query(const BasicUnitSoA<Alloc, Units...>& table,
+                                           const parallel::Options& options = parallel::Options())
+{
+	return Query<BasicUnitSoA<Alloc, Units...>>(table, options);
+}
+
+// A query over a temporary table would outlive it
+template <typename Alloc, typename... Units>
+void query(const BasicUnitSoA<Alloc, Units...>&&, const parallel::Options& = parallel::Options()) = delete;
+
+} // sunit
@@ -0,0 +1,150 @@
+#include "simpleunit/Query.h"
+#include <algorithm>
+#include <cstdint>
+#include "gtest/gtest.h"
+
+using namespace std;
+using namespace sunit;
+
+namespace
+{
+	using Vehicles = Unit<int32_t, BaseUnit<Dim<0>>>;
+	using Kilometers_Hour = Unit<float, Velocity<std::kilo, si::hour>>;
+	using Millimeters = Unit<int32_t, Length<std::milli>>;
+	using Trips = UnitSoA<Vehicles, si::Meters_Second, si::Meters>;
+
+	Trips trips(size_t n)
+	{
+		Trips t;
+		for (size_t i = 0; i < n; ++i)
+			t.push_back(Vehicles(int32_t(i % 7)), si::Meters_Second(float(i % 20)), si::Meters(float(i % 11)));
+		return t;
+	}
+
+	template <typename T, typename = void>
+	struct can_query : false_type {};
+	template <typename T>
+	struct can_query<T, decltype(void(query(declval<T>())))> : true_type {};
+}
+
+TEST(QueryTest, NoTemporaries)
+{
+	static_assert(can_query<const Trips&>::value, "a query of a table");
+	static_assert(!can_query<Trips>::value, "a query of a temporary table would dangle");
+}
+
+TEST(QueryTest, TypedPredicate)
+{
+	// 30 km/h is 8.33 m/s, so speeds 9 to 19 of each 20 pass
+	const Trips t = trips(100000);
+	auto fast = query(t).where<1>(above(Kilometers_Hour(30)));
+	EXPECT_EQ(100000u / 20 * 11, fast.count());
+
+	const vector<uint32_t> rows = fast.selection();
+	ASSERT_EQ(fast.count(), rows.size());
+	for (size_t i = 1; i < rows.size(); ++i)
+		EXPECT_LT(rows[i - 1], rows[i]);
+	for (uint32_t r : rows)
+		EXPECT_GT(t.column<1>()[r].value(), 30 / 3.6f);
+}
+
+TEST(QueryTest, Conjunction)
+{
+	const Trips t = trips(50000);
+	auto q = query(t).where<1>(between(si::Meters_Second(5), si::Meters_Second(10)))
+	                 .where<2>(below(Millimeters(3500)))
+	                 .where<0>(not_equals(Vehicles(3)));
+	size_t expected = 0;
+	double sum = 0;
+	float lo = 1e9f, hi = -1e9f;
+	for (size_t i = 0; i < t.size(); ++i) {
+		const float v = t.column<1>()[i].value();
+		const float d = t.column<2>()[i].value();
+		if (v >= 5 && v <= 10 && d < 3.5f && t.column<0>()[i].value() != 3) {
+			++expected;
+			sum += d;
+			lo = min(lo, d);
+			hi = max(hi, d);
+		}
+	}
+	EXPECT_EQ(expected, q.count());
+	EXPECT_FLOAT_EQ(float(sum), q.sum<2>().value());
+	EXPECT_EQ(lo, q.min<2>().value());
+	EXPECT_EQ(hi, q.max<2>().value());
+	EXPECT_FLOAT_EQ(float(sum / expected), q.mean<2>().value());
+}
+
+TEST(QueryTest, IntegerColumnFractionalThreshold)
+{
+	// Compared in double, so 2.5 vehicles keeps 3 to 6
+	const Trips t = trips(7000);
+	EXPECT_EQ(4000u, query(t).where<0>(above(Unit<double, BaseUnit<Dim<0>>>(2.5))).count());
+	EXPECT_EQ(1000u, query(t).where<0>(equals(Vehicles(2))).count());
+}
+
+TEST(QueryTest, Select)
+{
+	const Trips t = trips(3000);
+	const auto out = query(t).where<2>(at_least(si::Meters(10))).select<2, 0>();
+	ASSERT_EQ(3000u / 11 + (3000 % 11 > 10), out.size());
+	for (size_t r = 0; r < out.size(); ++r)
+		EXPECT_EQ(10.f, out.column<0>()[r].value());
+	EXPECT_EQ(int32_t(10 % 7), out.column<1>()[0].value());
+}
+
+TEST(QueryTest, GroupBy)
+{
+	parallel::Options options;
+	options.grain = 1;
+	const Trips t = trips(70000);
+	const auto groups = query(t, options).where<1>(at_most(si::Meters_Second(3))).group_by<0, 2>();
+	ASSERT_EQ(7u, groups.size());
+
+	size_t total = 0;
+	for (size_t g = 0; g < groups.size(); ++g) {
+		EXPECT_EQ(int32_t(g), groups[g].key.value());
+		size_t n = 0;
+		double sum = 0;
+		for (size_t i = 0; i < t.size(); ++i)
+			if (t.column<0>()[i].value() == int32_t(g) && t.column<1>()[i].value() <= 3) {
+				++n;
+				sum += t.column<2>()[i].value();
+			}
+		EXPECT_EQ(n, groups[g].count);
+		EXPECT_FLOAT_EQ(float(sum), groups[g].sum.value());
+		EXPECT_FLOAT_EQ(float(sum / n), groups[g].mean().value());
+		EXPECT_EQ(0.f, groups[g].min.value());
+		EXPECT_EQ(10.f, groups[g].max.value());
+		total += groups[g].count;
+	}
+	EXPECT_EQ(query(t).where<1>(at_most(si::Meters_Second(3))).count(), total);
+}
+
+TEST(QueryTest, LargeSums)
+{
+	// 4e6 rows of 1000 vehicles overflow an int32 sum; 4e6 rows of 0.1 m drift in a plain float sum
+	const size_t n = 4000000;
+	UnitSoA<Vehicles, si::Meters> t(n);
+	fill(t.column<0>().values(), t.column<0>().values() + n, 1000);
+	fill(t.column<1>().values(), t.column<1>().values() + n, 0.1f);
+	auto q = query(t);
+	static_assert(is_same<decltype(q.sum<0>()), Unit<int64_t, Vehicles::base>>::value, "integers sum in 64 bits");
+	EXPECT_EQ(int64_t(n) * 1000, q.sum<0>().value());
+	EXPECT_EQ(1000, q.mean<0>().value());
+	EXPECT_FLOAT_EQ(float(n * double(0.1f)), q.sum<1>().value());
+	EXPECT_FLOAT_EQ(0.1f, q.mean<1>().value());
+
+	const auto groups = q.group_by<0, 0>();
+	ASSERT_EQ(1u, groups.size());
+	EXPECT_EQ(int64_t(n) * 1000, groups[0].sum.value());
+	EXPECT_EQ(1000, groups[0].mean().value());
+}
+
+TEST(QueryTest, Empty)
+{
+	const Trips t;
+	auto q = query(t).where<1>(above(si::Meters_Second(1)));
+	EXPECT_EQ(0u, q.count());
+	EXPECT_EQ(0.f, q.mean<2>().value());
+	EXPECT_TRUE((q.group_by<0, 2>().empty()));
+}
@@ -0,0 +1,232 @@
+#pragma once
+
+#include "simpleunit/Accumulator.h"
+#include "simpleunit/Calculus.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <numeric>
+#include <type_traits>
+#include <vector>
+
+namespace sunit {
+
+// Least-squares lines and correlation between two columns of units. The slope of a fit of y on x
+// is in the unit of y / x and the intercept in y's unit; correlations are dimensionless:
+//
+//     LinearFit<Seconds, Meters> line = linear_fit(make_span(times), make_span(positions));
+//     Meters_Second v = line.slope;
+//     Meters p = line(Seconds(2));
+//     double r = pearson(make_span(times), make_span(positions));
+
+template <typename XUnit, typename YUnit>
+struct LinearFit
+{
+	using slope_unit = DerivativeUnit<YUnit, XUnit>;
+
+	slope_unit slope;
+	YUnit intercept;
+
+	YUnit operator()(const XUnit& x) const { return intercept + unit_cast<YUnit>(slope * x); }
+};
+
+// Single-pass count, means, variances and covariance of a stream of (x, y) pairs, from which the
+// fit and the Pearson correlation follow.
+//
+// As RunningStats, pairs are added by Welford's update and partial results merge by Chan et al.'s
+// pairwise combination, so pairs gathered in separate chunks or on separate threads merge in any
+// order.
+template <typename XUnit, typename YUnit>
+class RunningCovariance;
+
+template <typename X, typename Bx, typename Y, typename By>
+class RunningCovariance<Unit<X,Bx>, Unit<Y,By>>
+{
+public:
+	using T = std::common_type_t<X,Y>;
+	using x_unit = Unit<X,Bx>;
+	using y_unit = Unit<Y,By>;
+	using covariance_unit = IntegralUnit<Unit<T,Bx>, Unit<T,By>>;
+
+	static_assert(std::is_floating_point<T>::value, "moments are gathered in floating point");
+
+	// Bulk updates convert a block to T, take its means by compensated sums across lanes, then its
+	// moments about those means, and merge each block
+	static constexpr std::size_t block_size = 1024;
+
+	RunningCovariance& add(const x_unit& xu, const y_unit& yu)
+	{
+		const T x = xu.value(), y = yu.value();
+		++n_;
+		const T n = static_cast<T>(n_);
+		const T dx = x - mean_x_;
+		const T dy = y - mean_y_;
+		mean_x_ += dx / n;
+		mean_y_ += dy / n;
+		m2x_ += dx * (x - mean_x_);
+		m2y_ += dy * (y - mean_y_);
+		cxy_ += dx * (y - mean_y_);
+		return *this;
+	}
+
+	RunningCovariance& add(UnitSpan<const X,Bx> x, UnitSpan<const Y,By> y)
+	{
+		assert(x.size() == y.size());
+		for (std::size_t i = 0; i < x.size(); i += block_size)
+			merge(summarise(x.values() + i, y.values() + i, std::min(block_size, x.size() - i)));
+		return *this;
+	}
+
+	RunningCovariance& merge(const RunningCovariance& rhs)
+	{
+		if (rhs.n_ == 0) return *this;
+		if (n_ == 0) return *this = rhs;
+
+		const T na = static_cast<T>(n_);
+		const T nb = static_cast<T>(rhs.n_);
+		const T n = na + nb;
+		const T dx = rhs.mean_x_ - mean_x_;
+		const T dy = rhs.mean_y_ - mean_y_;
+		const T w = na * nb / n;
+
+		m2x_ += rhs.m2x_ + dx * dx * w;
+		m2y_ += rhs.m2y_ + dy * dy * w;
+		cxy_ += rhs.cxy_ + dx * dy * w;
+		mean_x_ += dx * nb / n;
+		mean_y_ += dy * nb / n;
+		n_ += rhs.n_;
+		return *this;
+	}
+
+	std::size_t count() const { return n_; }
+
+	Unit<T,Bx> mean_x() const { return Unit<T,Bx>(mean_x_); }
+	Unit<T,By> mean_y() const { return Unit<T,By>(mean_y_); }
+
+	// Sample (n - 1) covariance, in the unit of x * y
+	covariance_unit covariance() const
+	{
+		return Unit<T,Bx>(n_ > 1 ? cxy_ / static_cast<T>(n_ - 1) : T(0)) * Unit<T,By>(1);
+	}
+
+	// The Pearson correlation: zero if either x or y is constant
+	T correlation() const
+	{
+		return m2x_ > 0 && m2y_ > 0 ? cxy_ / std::sqrt(m2x_ * m2y_) : T(0);
+	}
+
+	// The least-squares line of y on x. Its slope is zero if x is constant
+	LinearFit<Unit<T,Bx>, Unit<T,By>> fit() const
+	{
+		const T slope = m2x_ > 0 ? cxy_ / m2x_ : T(0);
+		return {Unit<T,By>(slope) / Unit<T,Bx>(1), Unit<T,By>(mean_y_ - slope * mean_x_)};
+	}
+
+private:
+	static RunningCovariance summarise(const X* px, const Y* py, std::size_t n)
+	{
+		RunningCovariance block;
+		if (n == 0) return block;
+
+		T x[block_size], y[block_size];
+		std::copy(px, px + n, x);
+		std::copy(py, py + n, y);
+		NeumaierSum<T> sx, sy;
+		sx.add(x, n);
+		sy.add(y, n);
+		const T mx = sx.result() / static_cast<T>(n);
+		const T my = sy.result() / static_cast<T>(n);
+
+		T m2x[accumulator_lanes] = {};
+		T m2y[accumulator_lanes] = {};
+		T cxy[accumulator_lanes] = {};
+		std::size_t i = 0;
+		for (; i + accumulator_lanes <= n; i += accumulator_lanes) {
+			for (std::size_t l = 0; l < accumulator_lanes; ++l) {
+				const T dx = x[i + l] - mx;
+				const T dy = y[i + l] - my;
+				m2x[l] += dx * dx;
+				m2y[l] += dy * dy;
+				cxy[l] += dx * dy;
+			}
+		}
+		for (; i < n; ++i) {
+			const T dx = x[i] - mx;
+			const T dy = y[i] - my;
+			m2x[0] += dx * dx;
+			m2y[0] += dy * dy;
+			cxy[0] += dx * dy;
+		}
+		for (std::size_t l = 0; l < accumulator_lanes; ++l) {
+			block.m2x_ += m2x[l];
+			block.m2y_ += m2y[l];
+			block.cxy_ += cxy[l];
+		}
+		block.n_ = n;
+		block.mean_x_ = mx;
+		block.mean_y_ = my;
+		return block;
+	}
+
+	std::size_t n_ = 0;
+	T mean_x_ = 0;
+	T mean_y_ = 0;
+	T m2x_ = 0;
+	T m2y_ = 0;
+	T cxy_ = 0;
+};
+
+template <typename X, typename Bx, typename Y, typename By>
+constexpr std::size_t RunningCovariance<Unit<X,Bx>, Unit<Y,By>>::block_size;
+
+template <typename X, typename Bx, typename Y, typename By>
+using Covariance = RunningCovariance<Unit<std::remove_const_t<X>,Bx>, Unit<std::remove_const_t<Y>,By>>;
+
+template <typename X, typename Bx, typename Y, typename By>
+auto linear_fit(UnitSpan<X,Bx> x, UnitSpan<Y,By> y) -> decltype(Covariance<X,Bx,Y,By>().fit())
+{
+	return Covariance<X,Bx,Y,By>().add(x, y).fit();
+}
+
+template <typename X, typename Bx, typename Y, typename By>
+auto pearson(UnitSpan<X,Bx> x, UnitSpan<Y,By> y) -> decltype(Covariance<X,Bx,Y,By>().correlation())
+{
+	return Covariance<X,Bx,Y,By>().add(x, y).correlation();
+}
+
+namespace detail
+{
+	// Ranks from 1, with tied values sharing the mean of their ranks
+	template <typename T>
+	std::vector<double> ranks(const T* v, std::size_t n)
+	{
+		std::vector<std::size_t> order(n);
+		std::iota(order.begin(), order.end(), std::size_t(0));
+		std::sort(order.begin(), order.end(), [v](std::size_t a, std::size_t b) { return v[a] < v[b]; });
+		std::vector<double> rank(n);
+		for (std::size_t i = 0; i < n;) {
+			std::size_t j = i + 1;
+			while (j < n && !(v[order[i]] < v[order[j]]))
+				++j;
+			const double r = (i + j + 1) / 2.0;
+			for (; i < j; ++i)
+				rank[order[i]] = r;
+		}
+		return rank;
+	}
+}
+
+// The Spearman rank correlation: the Pearson correlation of the ranks of x and y. Ranking needs
+// all of the data, so unlike the Pearson correlation it has no streaming form
+template <typename X, typename Bx, typename Y, typename By>
+double spearman(UnitSpan<X,Bx> x, UnitSpan<Y,By> y)
+{
+	assert(x.size() == y.size());
+	const std::vector<double> rx = detail::ranks(x.values(), x.size());
+	const std::vector<double> ry = detail::ranks(y.values(), y.size());
+	using Rank = Unit<double>;
+	return RunningCovariance<Rank, Rank>().add(UnitSpan<const double>(rx.data(), rx.size()),
+	                                           UnitSpan<const double>(ry.data(), ry.size())).correlation();
+}
+
+} // sunit
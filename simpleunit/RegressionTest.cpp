@@ -0,0 +1,118 @@
+#include "simpleunit/Regression.h"
+#include <cmath>
+#include "gtest/gtest.h"
+
+using namespace std;
+using namespace sunit;
+
+namespace
+{
+	using Seconds = Unit<double, Time<si::second>>;
+	using Millimeters = Unit<float, Length<std::milli>>;
+	using Meters = Unit<double, Length<si::meter>>;
+	using Meters_Second = Unit<double, Velocity<si::meter, si::second>>;
+
+	// A sensor drifting at 2.5 mm/s from 40 mm, with a small periodic error
+	void drift(size_t n, UnitArray<double, Time<si::second>>& t, UnitArray<float, Length<std::milli>>& x)
+	{
+		for (size_t i = 0; i < n; ++i) {
+			const double s = 0.01 * i;
+			t.push_back(Seconds(s));
+			x.push_back(Millimeters(static_cast<float>(40 + 2.5 * s + 0.1 * sin(1.7 * i))));
+		}
+	}
+}
+
+TEST(RegressionTest, Units)
+{
+	using Fit = LinearFit<Unit<double, Time<si::second>>, Unit<double, Length<std::milli>>>;
+	static_assert(is_same<Fit::slope_unit::base::dim, Dim<1,-1>>::value, "slope is a speed");
+	static_assert(is_same<Fit::slope_unit::base::r1, std::milli>::value, "in millimetres");
+	static_assert(is_same<decltype(Fit::intercept), Unit<double, Length<std::milli>>>::value, "intercept is a length");
+	using Cov = RunningCovariance<Seconds, Millimeters>;
+	static_assert(is_same<Cov::covariance_unit::base::dim, Dim<1,1>>::value, "covariance is a length times a time");
+}
+
+TEST(RegressionTest, LinearFit)
+{
+	UnitArray<double, Time<si::second>> t;
+	UnitArray<float, Length<std::milli>> x;
+	drift(10000, t, x);
+
+	const auto line = linear_fit(make_span(t), make_span(x));
+	EXPECT_NEAR(2.5, line.slope.value(), 1e-3);
+	EXPECT_NEAR(40, line.intercept.value(), 1e-2);
+	EXPECT_NEAR(0.0025, unit_cast<Meters_Second>(line.slope).value(), 1e-6);
+	EXPECT_NEAR(40 + 2.5 * 50, line(Seconds(50)).value(), 1e-2);
+	EXPECT_GT(pearson(make_span(t), make_span(x)), 0.999);
+}
+
+TEST(RegressionTest, SameUnits)
+{
+	// y = 3 - 2x exactly, in one unit: the slope is a plain number
+	UnitArray<double, Length<si::meter>> x, y;
+	for (int i = 0; i < 100; ++i) {
+		x.push_back(Meters(i));
+		y.push_back(Meters(3 - 2.0 * i));
+	}
+	const auto line = linear_fit(make_span(x), make_span(y));
+	static_assert(is_same<decay_t<decltype(line.slope)>, double>::value, "dimensionless");
+	EXPECT_DOUBLE_EQ(-2, line.slope);
+	EXPECT_NEAR(3, line.intercept.value(), 1e-12);
+	EXPECT_DOUBLE_EQ(-1, pearson(make_span(x), make_span(y)));
+	EXPECT_DOUBLE_EQ(-1, spearman(make_span(x), make_span(y)));
+}
+
+TEST(RegressionTest, MergeMatchesSinglePass)
+{
+	UnitArray<double, Time<si::second>> t;
+	UnitArray<float, Length<std::milli>> x;
+	drift(5000, t, x);
+
+	RunningCovariance<Seconds, Millimeters> all, a, b, single;
+	all.add(make_span(t), make_span(x));
+	a.add(make_span(t).subspan(0, 1234), make_span(x).subspan(0, 1234));
+	b.add(make_span(t).subspan(1234, 5000 - 1234), make_span(x).subspan(1234, 5000 - 1234));
+	b.merge(a);
+	for (size_t i = 0; i < t.size(); ++i)
+		single.add(t[i], x[i]);
+
+	EXPECT_EQ(all.count(), b.count());
+	EXPECT_NEAR(all.mean_x().value(), b.mean_x().value(), 1e-9);
+	EXPECT_NEAR(all.mean_y().value(), b.mean_y().value(), 1e-9);
+	EXPECT_NEAR(all.covariance().value(), b.covariance().value(), 1e-6);
+	EXPECT_NEAR(all.correlation(), b.correlation(), 1e-12);
+	EXPECT_NEAR(all.fit().slope.value(), single.fit().slope.value(), 1e-9);
+	EXPECT_NEAR(all.fit().intercept.value(), single.fit().intercept.value(), 1e-7);
+}
+
+TEST(RegressionTest, OffsetData)
+{
+	// Large offsets, where naive sums of squares lose all precision
+	UnitArray<double, Time<si::second>> t;
+	UnitArray<double, Length<si::meter>> x;
+	for (int i = 0; i < 4096; ++i) {
+		t.push_back(Seconds(1e9 + i));
+		x.push_back(Meters(1e8 + 0.5 * i + (i % 2 ? 0.25 : -0.25)));
+	}
+	const auto line = linear_fit(make_span(t), make_span(x));
+	EXPECT_NEAR(0.5, line.slope.value(), 1e-6);
+	EXPECT_NEAR(1e8, line(Seconds(1e9)).value(), 1e-3);
+}
+
+TEST(RegressionTest, Spearman)
+{
+	// Monotonic but far from linear, with ties
+	UnitArray<double, Time<si::second>> t;
+	UnitArray<double, Length<si::meter>> x;
+	for (int i = 0; i < 50; ++i) {
+		t.push_back(Seconds(i));
+		x.push_back(Meters(exp(0.3 * (i / 2))));
+	}
+	EXPECT_LT(pearson(make_span(t), make_span(x)), 0.9);
+	EXPECT_GT(spearman(make_span(t), make_span(x)), 0.99);
+	EXPECT_LT(spearman(make_span(t), make_span(x)), 1);
+
+	const double constant[] = {1, 1, 1};
+	EXPECT_EQ(0, spearman(UnitSpan<const double>(constant, 3), UnitSpan<const double>(constant, 3)));
+}
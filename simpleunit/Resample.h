@@ -0,0 +1,143 @@
+#pragma once
+
+#include "simpleunit/Accumulator.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <vector>
+
+namespace sunit {
+
+// A sample rate fixed at compile time: R in the frequency unit B, e.g. SampleRate<std::kilo> is
+// 1000 Hz, as is SampleRate<std::ratio<1>, Frequency<std::milli>>
+template <typename R, typename B = Frequency<std::ratio<1>>>
+struct SampleRate
+{
+	using ratio = R;
+	using base = B;
+	using hertz = std::ratio_multiply<R, BaseConversion<B, Frequency<std::ratio<1>>>>;
+
+	template <typename T = float>
+	static constexpr Unit<T,B> value() { return Unit<T,B>(static_cast<T>(R::num) / static_cast<T>(R::den)); }
+};
+
+// Polyphase resampling between two sample rates by the rational factor To / From, reduced to
+// lowest terms at compile time (1000 Hz to 400 Hz is up 2, down 5). Equivalent to upsampling by
+// `up`, low-pass filtering below the lower of the two Nyquist frequencies, then keeping every
+// `down`th sample, but computes only the samples kept, each from one phase of the filter.
+//
+// The filter is a Kaiser-windowed sinc spanning `zero_crossings` input samples either side, with
+// its delay removed, so output sample n is at time n / To as input sample i is at i / From.
+template <typename From, typename To, typename T = float>
+class Resampler
+{
+public:
+	using factor = std::ratio_divide<typename To::hertz, typename From::hertz>;
+	static constexpr std::intmax_t up = factor::num;
+	static constexpr std::intmax_t down = factor::den;
+
+	explicit Resampler(std::size_t zero_crossings = 10, double beta = 5)
+	{
+		const std::size_t m = static_cast<std::size_t>(std::max(up, down));
+		const std::size_t half = zero_crossings * m;
+		const std::size_t length = 2 * half + 1;
+		delay_ = half;
+
+		// Cutoff in cycles per upsampled sample, with a gain of `up` to restore the amplitude
+		// lost to the inserted zeros
+		const double pi = std::acos(-1.0);
+		const double fc = 0.5 / m;
+		std::vector<double> h(length);
+		for (std::size_t j = 0; j < length; ++j) {
+			const double t = static_cast<double>(j) - static_cast<double>(half);
+			const double sinc = t == 0 ? 2 * fc : std::sin(2 * pi * fc * t) / (pi * t);
+			const double r = t / static_cast<double>(half);
+			h[j] = up * sinc * bessel_i0(beta * std::sqrt(std::max(0.0, 1 - r * r))) / bessel_i0(beta);
+		}
+
+		// Each phase's taps, reversed so that they run forwards over the input
+		taps_ = (length + up - 1) / up;
+		phases_.assign(up * taps_, T(0));
+		for (std::size_t p = 0; p < static_cast<std::size_t>(up); ++p)
+			for (std::size_t k = 0; k < taps_ && p + k * up < length; ++k)
+				phases_[p * taps_ + taps_ - 1 - k] = static_cast<T>(h[p + k * up]);
+	}
+
+	static std::size_t output_size(std::size_t n) { return (n * up + down - 1) / down; }
+
+	template <typename X, typename B>
+	void process(UnitSpan<X,B> in, UnitSpan<T,B> out) const
+	{
+		assert(out.size() == output_size(in.size()));
+		const X* x = in.values();
+		T* y = out.values();
+		const std::ptrdiff_t n = static_cast<std::ptrdiff_t>(in.size());
+		const std::ptrdiff_t K = static_cast<std::ptrdiff_t>(taps_);
+
+		for (std::size_t j = 0; j < out.size(); ++j) {
+			const std::size_t t = j * down + delay_;
+			const T* h = &phases_[(t % up) * taps_];
+			// Input i - K + 1 + m meets tap m; clip to the input, which is zero beyond its ends
+			const std::ptrdiff_t first = static_cast<std::ptrdiff_t>(t / up) - K + 1;
+			const std::ptrdiff_t lo = std::max<std::ptrdiff_t>(0, -first);
+			const std::ptrdiff_t hi = std::min<std::ptrdiff_t>(K, n - first);
+			y[j] = lo < hi ? dot(h + lo, x + first + lo, static_cast<std::size_t>(hi - lo)) : T(0);
+		}
+	}
+
+	template <typename X, typename B>
+	UnitArray<T,B> operator()(UnitSpan<X,B> in) const
+	{
+		UnitArray<T,B> out(output_size(in.size()));
+		process(in, make_span(out));
+		return out;
+	}
+
+private:
+	template <typename X>
+	static T dot(const T* h, const X* x, std::size_t n)
+	{
+		T lanes[accumulator_lanes] = {};
+		std::size_t i = 0;
+		for (; i + accumulator_lanes <= n; i += accumulator_lanes)
+			for (std::size_t l = 0; l < accumulator_lanes; ++l)
+				lanes[l] += h[i + l] * static_cast<T>(x[i + l]);
+		T sum = 0;
+		for (; i < n; ++i)
+			sum += h[i] * static_cast<T>(x[i]);
+		for (std::size_t l = 0; l < accumulator_lanes; ++l)
+			sum += lanes[l];
+		return sum;
+	}
+
+	// Modified Bessel function of the first kind, order zero
+	static double bessel_i0(double x)
+	{
+		double sum = 1, term = 1;
+		for (int k = 1; k < 50 && term > 1e-17 * sum; ++k) {
+			term *= (x / (2 * k)) * (x / (2 * k));
+			sum += term;
+		}
+		return sum;
+	}
+
+	std::size_t taps_;
+	std::size_t delay_;
+	std::vector<T> phases_;
+};
+
+template <typename From, typename To, typename T>
+constexpr std::intmax_t Resampler<From, To, T>::up;
+template <typename From, typename To, typename T>
+constexpr std::intmax_t Resampler<From, To, T>::down;
+
+// Keep every nth sample, after filtering out frequencies above the new Nyquist frequency
+template <std::intmax_t N, typename T, typename B>
+UnitArray<std::remove_const_t<T>,B> decimate(UnitSpan<T,B> in, std::size_t zero_crossings = 10)
+{
+	using From = SampleRate<std::ratio<N>>;
+	using To = SampleRate<std::ratio<1>>;
+	return Resampler<From, To, std::remove_const_t<T>>(zero_crossings)(in);
+}
+
+} // sunit
@@ -0,0 +1,88 @@
+#include "simpleunit/Resample.h"
+#include <cmath>
+#include "gtest/gtest.h"
+
+using namespace std;
+using namespace sunit;
+
+namespace
+{
+	using Hz1000 = SampleRate<std::kilo>;
+	using Hz400 = SampleRate<std::ratio<400>>;
+	using Hz10 = SampleRate<std::ratio<10>>;
+
+	sunit::UnitArray<float, Acceleration<si::meter, si::second>> sine(double frequency, double rate, std::size_t n)
+	{
+		const double pi = std::acos(-1.0);
+		sunit::UnitArray<float, Acceleration<si::meter, si::second>> x(n);
+		for (std::size_t i = 0; i < n; ++i)
+			x[i] = si::Meters_Second2(float(std::sin(2 * pi * frequency * i / rate)));
+		return x;
+	}
+}
+
+TEST(ResampleTest, Factors)
+{
+	using namespace si;
+
+	EXPECT_EQ(2, (Resampler<Hz1000, Hz400>::up));
+	EXPECT_EQ(5, (Resampler<Hz1000, Hz400>::down));
+	EXPECT_EQ(5, (Resampler<Hz400, Hz1000>::up));
+	EXPECT_EQ(1, (Resampler<Hz1000, Hz10>::up));
+	EXPECT_EQ(100, (Resampler<Hz1000, Hz10>::down));
+
+	// Rates in any frequency unit
+	using Khz1 = SampleRate<std::ratio<1>, Frequency<std::milli>>;
+	EXPECT_EQ(1, (std::is_same<Hz1000::hertz, Khz1::hertz>::value));
+	EXPECT_EQ(100, (Resampler<Khz1, Hz10>::down));
+	EXPECT_FLOAT_EQ(1000, Khz1::value().as<Hertz>().value());
+
+	EXPECT_EQ(400u, (Resampler<Hz1000, Hz400>::output_size(1000)));
+	EXPECT_EQ(3u, (Resampler<Hz1000, Hz400>::output_size(6)));
+}
+
+TEST(ResampleTest, Down)
+{
+	using namespace si;
+
+	// A 20 Hz sine from 1 kHz to 400 Hz: away from the ends, the samples of the same sine
+	auto x = sine(20, 1000, 2000);
+	Resampler<Hz1000, Hz400> resample;
+	auto y = resample(make_span(x));
+	EXPECT_EQ(1, (std::is_same<Meters_Second2, decltype(y)::value_type>::value));
+	ASSERT_EQ(800u, y.size());
+	const auto expected = sine(20, 400, 800);
+	for (std::size_t i = 50; i < 750; ++i)
+		ASSERT_NEAR(expected[i].value(), y[i].value(), 2e-3);
+}
+
+TEST(ResampleTest, Up)
+{
+	using namespace si;
+
+	auto x = sine(20, 400, 800);
+	Resampler<Hz400, Hz1000> resample;
+	auto y = resample(make_span(x));
+	ASSERT_EQ(2000u, y.size());
+	const auto expected = sine(20, 1000, 2000);
+	for (std::size_t i = 100; i < 1900; ++i)
+		ASSERT_NEAR(expected[i].value(), y[i].value(), 2e-3);
+}
+
+TEST(ResampleTest, Decimate)
+{
+	using namespace si;
+
+	// A 1 Hz component survives decimation from 1 kHz to 10 Hz; a 100 Hz one (which would alias
+	// to DC) does not
+	auto slow = sine(1, 1000, 10000);
+	auto fast = sine(100, 1000, 10000);
+	for (std::size_t i = 0; i < slow.size(); ++i)
+		slow[i] += fast[i];
+
+	auto y = decimate<100>(make_span(slow));
+	ASSERT_EQ(100u, y.size());
+	const auto expected = sine(1, 10, 100);
+	for (std::size_t i = 10; i < 90; ++i)
+		ASSERT_NEAR(expected[i].value(), y[i].value(), 5e-3);
+}
@@ -0,0 +1,224 @@
+#pragma once
+
+#include "simpleunit/UnitSpan.h"
+#include "simpleunit/UnitVec.h"
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+
+namespace sunit {
+
+// Rotations, which are dimensionless, acting on vectors of units. Rotating a UnitVec<3,T,B> gives
+// a UnitVec<3,T,B>: the dimension and scale are carried by the type and never touched, so the
+// arithmetic runs on the plain values:
+//
+//     auto q = Quaternion<double>::axis_angle({{0, 0, 1}}, pi / 2);
+//     UnitVec<3, float, Velocity<meter, second>> v2 = q * v;
+//     rotate(q, x, y, z, x, y, z);        // columns of a UnitSoA, in place
+//
+// Angles are in radians.
+
+template <typename S>
+struct Quaternion
+{
+	S w = 1, x = 0, y = 0, z = 0;
+
+	static Quaternion identity() { return Quaternion(); }
+
+	// A rotation by an angle about an axis, which need not be of unit length
+	static Quaternion axis_angle(const std::array<S, 3>& axis, S radians)
+	{
+		const S n = std::sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+		assert(n > 0);
+		const S s = std::sin(radians / 2) / n;
+		return Quaternion{std::cos(radians / 2), axis[0] * s, axis[1] * s, axis[2] * s};
+	}
+
+	// The inverse, for a unit quaternion
+	Quaternion conjugate() const { return Quaternion{w, -x, -y, -z}; }
+
+	S norm() const { return std::sqrt(w * w + x * x + y * y + z * z); }
+
+	Quaternion normalized() const
+	{
+		const S n = norm();
+		return Quaternion{w / n, x / n, y / n, z / n};
+	}
+
+	// The rotation by b, then by a
+	friend Quaternion operator*(const Quaternion& a, const Quaternion& b)
+	{
+		return Quaternion{a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z,
+		                  a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+		                  a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+		                  a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w};
+	}
+
+	// Rotate plain values: v + 2w(u x v) + 2u x (u x v), for the vector part u
+	template <typename T>
+	void rotate(T& vx, T& vy, T& vz) const
+	{
+		const S tx = 2 * (y * vz - z * vy);
+		const S ty = 2 * (z * vx - x * vz);
+		const S tz = 2 * (x * vy - y * vx);
+		const S rx = vx + w * tx + (y * tz - z * ty);
+		const S ry = vy + w * ty + (z * tx - x * tz);
+		const S rz = vz + w * tz + (x * ty - y * tx);
+		vx = static_cast<T>(rx);
+		vy = static_cast<T>(ry);
+		vz = static_cast<T>(rz);
+	}
+
+	template <typename T, typename B>
+	friend UnitVec<3,T,B> operator*(const Quaternion& q, UnitVec<3,T,B> v)
+	{
+		q.rotate(v[0].value(), v[1].value(), v[2].value());
+		return v;
+	}
+};
+
+// A rotation as a 3x3 orthonormal matrix: cheaper than a quaternion per vector, when many vectors
+// share a rotation
+template <typename S>
+struct RotationMatrix
+{
+	std::array<std::array<S, 3>, 3> m = {{{{1, 0, 0}}, {{0, 1, 0}}, {{0, 0, 1}}}};
+
+	RotationMatrix() = default;
+
+	explicit RotationMatrix(const Quaternion<S>& q)
+	{
+		const S w = q.w, x = q.x, y = q.y, z = q.z;
+		m = {{{{1 - 2 * (y * y + z * z), 2 * (x * y - w * z), 2 * (x * z + w * y)}},
+		      {{2 * (x * y + w * z), 1 - 2 * (x * x + z * z), 2 * (y * z - w * x)}},
+		      {{2 * (x * z - w * y), 2 * (y * z + w * x), 1 - 2 * (x * x + y * y)}}}};
+	}
+
+	// The inverse
+	RotationMatrix transpose() const
+	{
+		RotationMatrix t;
+		for (std::size_t i = 0; i < 3; ++i)
+			for (std::size_t j = 0; j < 3; ++j)
+				t.m[i][j] = m[j][i];
+		return t;
+	}
+
+	friend RotationMatrix operator*(const RotationMatrix& a, const RotationMatrix& b)
+	{
+		RotationMatrix c;
+		for (std::size_t i = 0; i < 3; ++i)
+			for (std::size_t j = 0; j < 3; ++j)
+				c.m[i][j] = a.m[i][0] * b.m[0][j] + a.m[i][1] * b.m[1][j] + a.m[i][2] * b.m[2][j];
+		return c;
+	}
+
+	template <typename T>
+	void rotate(T& vx, T& vy, T& vz) const
+	{
+		const S rx = m[0][0] * vx + m[0][1] * vy + m[0][2] * vz;
+		const S ry = m[1][0] * vx + m[1][1] * vy + m[1][2] * vz;
+		const S rz = m[2][0] * vx + m[2][1] * vy + m[2][2] * vz;
+		vx = static_cast<T>(rx);
+		vy = static_cast<T>(ry);
+		vz = static_cast<T>(rz);
+	}
+
+	template <typename T, typename B>
+	friend UnitVec<3,T,B> operator*(const RotationMatrix& r, UnitVec<3,T,B> v)
+	{
+		r.rotate(v[0].value(), v[1].value(), v[2].value());
+		return v;
+	}
+};
+
+// The quaternion of a rotation matrix, by the largest of its diagonal terms (Shepperd's method)
+template <typename S>
+Quaternion<S> quaternion(const RotationMatrix<S>& r)
+{
+	const auto& m = r.m;
+	const S trace = m[0][0] + m[1][1] + m[2][2];
+	Quaternion<S> q;
+	if (trace > m[0][0] && trace > m[1][1] && trace > m[2][2]) {
+		const S s = 2 * std::sqrt(1 + trace);
+		q = {s / 4, (m[2][1] - m[1][2]) / s, (m[0][2] - m[2][0]) / s, (m[1][0] - m[0][1]) / s};
+	}
+	else if (m[0][0] >= m[1][1] && m[0][0] >= m[2][2]) {
+		const S s = 2 * std::sqrt(1 + m[0][0] - m[1][1] - m[2][2]);
+		q = {(m[2][1] - m[1][2]) / s, s / 4, (m[0][1] + m[1][0]) / s, (m[0][2] + m[2][0]) / s};
+	}
+	else if (m[1][1] >= m[2][2]) {
+		const S s = 2 * std::sqrt(1 - m[0][0] + m[1][1] - m[2][2]);
+		q = {(m[0][2] - m[2][0]) / s, (m[0][1] + m[1][0]) / s, s / 4, (m[1][2] + m[2][1]) / s};
+	}
+	else {
+		const S s = 2 * std::sqrt(1 - m[0][0] - m[1][1] + m[2][2]);
+		q = {(m[1][0] - m[0][1]) / s, (m[0][2] + m[2][0]) / s, (m[1][2] + m[2][1]) / s, s / 4};
+	}
+	return q.w < 0 ? Quaternion<S>{-q.w, -q.x, -q.y, -q.z} : q;
+}
+
+// Rotate n vectors, given as columns of components, by one rotation. The output columns are of
+// the input's unit, and may be the input columns themselves
+template <typename S, typename X, typename T, typename B>
+void rotate(const RotationMatrix<S>& r, UnitSpan<X,B> x, UnitSpan<X,B> y, UnitSpan<X,B> z,
+            UnitSpan<T,B> out_x, UnitSpan<T,B> out_y, UnitSpan<T,B> out_z)
+{
+	const std::size_t n = x.size();
+	assert(y.size() == n && z.size() == n && out_x.size() == n && out_y.size() == n && out_z.size() == n);
+	const X* px = x.values();
+	const X* py = y.values();
+	const X* pz = z.values();
+	T* ox = out_x.values();
+	T* oy = out_y.values();
+	T* oz = out_z.values();
+	for (std::size_t i = 0; i < n; ++i) {
+		T vx = px[i], vy = py[i], vz = pz[i];
+		r.rotate(vx, vy, vz);
+		ox[i] = vx;
+		oy[i] = vy;
+		oz[i] = vz;
+	}
+}
+
+template <typename S, typename X, typename T, typename B>
+void rotate(const Quaternion<S>& q, UnitSpan<X,B> x, UnitSpan<X,B> y, UnitSpan<X,B> z,
+            UnitSpan<T,B> out_x, UnitSpan<T,B> out_y, UnitSpan<T,B> out_z)
+{
+	rotate(RotationMatrix<S>(q), x, y, z, out_x, out_y, out_z);
+}
+
+// Rotate n vectors each by its own rotation, q[i] for vector i
+template <typename S, typename X, typename T, typename B>
+void rotate(const Quaternion<S>* q, UnitSpan<X,B> x, UnitSpan<X,B> y, UnitSpan<X,B> z,
+            UnitSpan<T,B> out_x, UnitSpan<T,B> out_y, UnitSpan<T,B> out_z)
+{
+	const std::size_t n = x.size();
+	assert(y.size() == n && z.size() == n && out_x.size() == n && out_y.size() == n && out_z.size() == n);
+	const X* px = x.values();
+	const X* py = y.values();
+	const X* pz = z.values();
+	T* ox = out_x.values();
+	T* oy = out_y.values();
+	T* oz = out_z.values();
+	for (std::size_t i = 0; i < n; ++i) {
+		T vx = px[i], vy = py[i], vz = pz[i];
+		q[i].rotate(vx, vy, vz);
+		ox[i] = vx;
+		oy[i] = vy;
+		oz[i] = vz;
+	}
+}
+
+// Rotate three columns of a UnitSoA, which must share a base, in place
+template <std::size_t I, std::size_t J, std::size_t K, typename R, typename Alloc, typename... Units>
+void rotate(const R& rotation, BasicUnitSoA<Alloc, Units...>& columns)
+{
+	auto x = columns.template column<I>();
+	auto y = columns.template column<J>();
+	auto z = columns.template column<K>();
+	rotate(rotation, x, y, z, x, y, z);
+}
+
+} // sunit
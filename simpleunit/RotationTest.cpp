@@ -0,0 +1,99 @@
+#include "simpleunit/Rotation.h"
+#include <random>
+#include "gtest/gtest.h"
+
+using namespace std;
+using namespace sunit;
+
+namespace
+{
+	const double pi = 3.14159265358979323846;
+
+	using Velocity_ = Velocity<si::meter, si::second>;
+	using Meters_Second = Unit<float, Velocity_>;
+	using Speed = UnitVec<3, float, Velocity_>;
+
+	void expect_near(const Speed& a, const Speed& b, float tolerance = 1e-5f)
+	{
+		for (size_t i = 0; i < 3; ++i)
+			EXPECT_NEAR(a[i].value(), b[i].value(), tolerance) << "component " << i;
+	}
+
+	Quaternion<double> random_rotation(mt19937& rng)
+	{
+		normal_distribution<double> n;
+		return Quaternion<double>{n(rng), n(rng), n(rng), n(rng)}.normalized();
+	}
+}
+
+TEST(RotationTest, QuarterTurn)
+{
+	const auto q = Quaternion<double>::axis_angle({{0, 0, 2}}, pi / 2);
+	const Speed v(Meters_Second(1), Meters_Second(0), Meters_Second(3));
+	// The unit and scale come through in the type
+	const Speed r = q * v;
+	expect_near(Speed(Meters_Second(0), Meters_Second(1), Meters_Second(3)), r);
+	expect_near(r, RotationMatrix<double>(q) * v);
+	expect_near(v, q.conjugate() * r);
+}
+
+TEST(RotationTest, Composition)
+{
+	mt19937 rng(7);
+	const auto a = random_rotation(rng), b = random_rotation(rng);
+	const Speed v(Meters_Second(1), Meters_Second(-2), Meters_Second(0.5f));
+	expect_near(a * (b * v), (a * b) * v);
+	const RotationMatrix<double> ma(a), mb(b);
+	expect_near(a * (b * v), (ma * mb) * v);
+	expect_near(v, ma.transpose() * (ma * v));
+}
+
+TEST(RotationTest, MatrixToQuaternion)
+{
+	mt19937 rng(11);
+	for (int i = 0; i < 100; ++i) {
+		const auto q = random_rotation(rng);
+		const auto p = quaternion(RotationMatrix<double>(q));
+		const double sign = q.w < 0 ? -1 : 1;
+		EXPECT_NEAR(sign * q.w, p.w, 1e-9);
+		EXPECT_NEAR(sign * q.x, p.x, 1e-9);
+		EXPECT_NEAR(sign * q.y, p.y, 1e-9);
+		EXPECT_NEAR(sign * q.z, p.z, 1e-9);
+	}
+	// Half turns, where the trace is smallest
+	for (const auto& axis : {array<double, 3>{{1, 0, 0}}, array<double, 3>{{0, 1, 0}}, array<double, 3>{{0, 0, 1}}}) {
+		const auto q = Quaternion<double>::axis_angle(axis, pi);
+		const auto p = quaternion(RotationMatrix<double>(q));
+		EXPECT_NEAR(1, abs(q.x * p.x + q.y * p.y + q.z * p.z + q.w * p.w), 1e-9);
+	}
+}
+
+TEST(RotationTest, Batch)
+{
+	mt19937 rng(3);
+	uniform_real_distribution<float> u(-10, 10);
+	UnitSoA<Meters_Second, Meters_Second, Meters_Second> v;
+	for (int i = 0; i < 1000; ++i)
+		v.push_back(Meters_Second(u(rng)), Meters_Second(u(rng)), Meters_Second(u(rng)));
+	const auto before = v;
+
+	const auto q = random_rotation(rng);
+	rotate<0, 1, 2>(q, v);
+	for (size_t i = 0; i < v.size(); ++i) {
+		const Speed a(before.column<0>()[i], before.column<1>()[i], before.column<2>()[i]);
+		const Speed b(v.column<0>()[i], v.column<1>()[i], v.column<2>()[i]);
+		expect_near(q * a, b, 1e-4f);
+	}
+
+	// One rotation per vector, into separate columns
+	vector<Quaternion<double>> qs;
+	for (size_t i = 0; i < v.size(); ++i)
+		qs.push_back(random_rotation(rng));
+	UnitSoA<Meters_Second, Meters_Second, Meters_Second> out(v.size());
+	rotate(qs.data(), before.column<0>(), before.column<1>(), before.column<2>(), out.column<0>(), out.column<1>(), out.column<2>());
+	for (size_t i = 0; i < v.size(); ++i) {
+		const Speed a(before.column<0>()[i], before.column<1>()[i], before.column<2>()[i]);
+		const Speed b(out.column<0>()[i], out.column<1>()[i], out.column<2>()[i]);
+		expect_near(qs[i] * a, b, 1e-4f);
+	}
+}
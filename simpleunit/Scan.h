@@ -0,0 +1,198 @@
+#pragma once
+
+#include "simpleunit/Parallel.h"
+#include <vector>
+
+namespace sunit {
+
+namespace detail
+{
+	constexpr std::size_t scan_group = 8;
+
+	// Scan the addends load(i) for i in [begin, end), starting from carry, passing each prefix to
+	// store(i, prefix). Each group's local prefix depends only on its own addends, so groups overlap
+	// and only a single add per group waits on the running carry.
+	template <typename Z, typename Load, typename Store>
+	Z scan_block(std::size_t begin, std::size_t end, Z carry, bool inclusive, Load& load, Store& store)
+	{
+		std::size_t i = begin;
+		for (; i + scan_group <= end; i += scan_group) {
+			Z local[scan_group];
+			for (std::size_t l = 0; l < scan_group; ++l)
+				local[l] = load(i + l);
+			Z prefix[scan_group];
+			prefix[0] = local[0];
+			for (std::size_t l = 1; l < scan_group; ++l)
+				prefix[l] = prefix[l - 1] + local[l];
+			if (inclusive) {
+				for (std::size_t l = 0; l < scan_group; ++l)
+					store(i + l, carry + prefix[l]);
+			}
+			else {
+				store(i, carry);
+				for (std::size_t l = 1; l < scan_group; ++l)
+					store(i + l, carry + prefix[l - 1]);
+			}
+			carry += prefix[scan_group - 1];
+		}
+		for (; i < end; ++i) {
+			const Z z = load(i);
+			if (inclusive) {
+				carry += z;
+				store(i, carry);
+			}
+			else {
+				store(i, carry);
+				carry += z;
+			}
+		}
+		return carry;
+	}
+
+	// Two-pass blocked scan: total each block in parallel, scan the (few) block totals, then scan
+	// each block in parallel from its offset
+	template <typename Z, typename Load, typename Store>
+	void scan(std::size_t n, bool inclusive, Load load, Store store, std::size_t grain, const parallel::Options& options)
+	{
+		const std::size_t blocks = (n + grain - 1) / grain;
+		if (blocks <= 1) {
+			scan_block<Z>(0, n, Z(0), inclusive, load, store);
+			return;
+		}
+
+		std::vector<Z> offsets(blocks);
+		parallel::for_range(blocks, 1, [&](std::size_t b0, std::size_t b1) {
+			for (std::size_t b = b0; b < b1; ++b) {
+				const std::size_t begin = b * grain;
+				const std::size_t end = std::min(n, begin + grain);
+				Z lanes[scan_group] = {};
+				std::size_t i = begin;
+				for (; i + scan_group <= end; i += scan_group)
+					for (std::size_t l = 0; l < scan_group; ++l)
+						lanes[l] += load(i + l);
+				Z total = 0;
+				for (; i < end; ++i)
+					total += load(i);
+				for (std::size_t l = 0; l < scan_group; ++l)
+					total += lanes[l];
+				offsets[b] = total;
+			}
+		}, options);
+
+		Z carry = 0;
+		for (std::size_t b = 0; b < blocks; ++b) {
+			const Z total = offsets[b];
+			offsets[b] = carry;
+			carry += total;
+		}
+
+		parallel::for_range(blocks, 1, [&](std::size_t b0, std::size_t b1) {
+			for (std::size_t b = b0; b < b1; ++b)
+				scan_block<Z>(b * grain, std::min(n, (b + 1) * grain), offsets[b], inclusive, load, store);
+		}, options);
+	}
+
+	template <typename X, typename Z>
+	std::size_t scan_grain(const parallel::Options& options)
+	{
+		return options.grain ? options.grain : parallel::grain_size(sizeof(X) + sizeof(Z), sizeof(Z));
+	}
+}
+
+// Running sums of a span. The output may be at any scale of the same dimension, with the
+// conversion applied as each value is loaded. `in` and `out` may be the same span.
+//
+// Sums over separate blocks are formed in parallel and then combined, so floating-point results
+// may differ in rounding from a serial loop.
+template <typename T, typename B, typename Z, typename B3>
+void inclusive_scan(UnitSpan<T,B> in, UnitSpan<Z,B3> out, const parallel::Options& options = parallel::Options())
+{
+	using D = AddType<typename B::dim, typename B3::dim>;
+	assert(in.size() == out.size());
+
+	const Z k = conversion_factor<Z, B, B3, D>();
+	const T* x = in.values();
+	Z* y = out.values();
+	detail::scan<Z>(in.size(), true,
+	                [x, k](std::size_t i) { return static_cast<Z>(x[i]) * k; },
+	                [y](std::size_t i, Z v) { y[i] = v; },
+	                detail::scan_grain<T,Z>(options), options);
+}
+
+template <typename T, typename B, typename Z, typename B3>
+void exclusive_scan(UnitSpan<T,B> in, UnitSpan<Z,B3> out, const parallel::Options& options = parallel::Options())
+{
+	using D = AddType<typename B::dim, typename B3::dim>;
+	assert(in.size() == out.size());
+
+	const Z k = conversion_factor<Z, B, B3, D>();
+	const T* x = in.values();
+	Z* y = out.values();
+	detail::scan<Z>(in.size(), false,
+	                [x, k](std::size_t i) { return static_cast<Z>(x[i]) * k; },
+	                [y](std::size_t i, Z v) { y[i] = v; },
+	                detail::scan_grain<T,Z>(options), options);
+}
+
+template <typename T, typename B>
+UnitArray<std::remove_const_t<T>,B> inclusive_scan(UnitSpan<T,B> in, const parallel::Options& options = parallel::Options())
+{
+	UnitArray<std::remove_const_t<T>,B> out(in.size());
+	inclusive_scan(in, make_span(out), options);
+	return out;
+}
+
+template <typename T, typename B>
+UnitArray<std::remove_const_t<T>,B> exclusive_scan(UnitSpan<T,B> in, const parallel::Options& options = parallel::Options())
+{
+	UnitArray<std::remove_const_t<T>,B> out(in.size());
+	exclusive_scan(in, make_span(out), options);
+	return out;
+}
+
+// Running trapezoidal integral of values sampled every `dt`, starting from zero. The result is in
+// the unit of values * dt, e.g. Meters_Second and Seconds give Meters.
+template <typename T, typename B, typename X, typename Bx,
+          typename R = decltype(std::declval<Unit<std::remove_const_t<T>,B>>() * std::declval<Unit<X,Bx>>())>
+UnitArray<typename R::rep, typename R::base> cumulative_integral(UnitSpan<T,B> values, const Unit<X,Bx>& dt,
+                                                                  const parallel::Options& options = parallel::Options())
+{
+	using Z = typename R::rep;
+	using BR = typename R::base;
+
+	UnitArray<Z, BR> out(values.size());
+	const Z h = static_cast<Z>(dt.value()) * conversion_factor<Z, B, BR>() * conversion_factor<Z, Bx, BR>() / 2;
+	const T* v = values.values();
+	Z* y = make_span(out).values();
+	detail::scan<Z>(values.size(), true,
+	                [v, h](std::size_t i) { return i == 0 ? Z(0) : (static_cast<Z>(v[i - 1]) + static_cast<Z>(v[i])) * h; },
+	                [y](std::size_t i, Z z) { y[i] = z; },
+	                detail::scan_grain<T,Z>(options), options);
+	return out;
+}
+
+// As above, for values sampled at the given (increasing) times
+template <typename T, typename B, typename X, typename Bx,
+          typename R = decltype(std::declval<Unit<std::remove_const_t<T>,B>>() * std::declval<Unit<std::remove_const_t<X>,Bx>>())>
+UnitArray<typename R::rep, typename R::base> cumulative_integral(UnitSpan<T,B> values, UnitSpan<X,Bx> times,
+                                                                  const parallel::Options& options = parallel::Options())
+{
+	using Z = typename R::rep;
+	using BR = typename R::base;
+	assert(values.size() == times.size());
+
+	UnitArray<Z, BR> out(values.size());
+	const Z k = conversion_factor<Z, B, BR>() * conversion_factor<Z, Bx, BR>() / 2;
+	const T* v = values.values();
+	const X* t = times.values();
+	Z* y = make_span(out).values();
+	detail::scan<Z>(values.size(), true,
+	                [v, t, k](std::size_t i) {
+	                	return i == 0 ? Z(0) : (static_cast<Z>(v[i - 1]) + static_cast<Z>(v[i])) * static_cast<Z>(t[i] - t[i - 1]) * k;
+	                },
+	                [y](std::size_t i, Z z) { y[i] = z; },
+	                detail::scan_grain<T,Z>(options), options);
+	return out;
+}
+
+} // sunit
@@ -0,0 +1,89 @@
+#include "simpleunit/Scan.h"
+#include "gtest/gtest.h"
+
+using namespace std;
+using namespace sunit;
+
+TEST(ScanTest, InclusiveExclusive)
+{
+	using namespace si;
+
+	// Small integers sum exactly, so every grain must agree with a serial loop
+	const std::size_t n = 100003;
+	UnitArray<double, Length<meter>> in(n);
+	for (std::size_t i = 0; i < n; ++i)
+		in[i] = Unit<double, Length<meter>>(double(i % 7) - 3);
+
+	for (std::size_t grain : {0, 1, 5, 8, 1000}) {
+		parallel::Options options;
+		options.grain = grain;
+		auto inclusive = inclusive_scan(make_span(in), options);
+		auto exclusive = exclusive_scan(make_span(in), options);
+		ASSERT_EQ(n, inclusive.size());
+		double sum = 0;
+		for (std::size_t i = 0; i < n; ++i) {
+			ASSERT_EQ(sum, exclusive[i].value());
+			sum += in[i].value();
+			ASSERT_EQ(sum, inclusive[i].value());
+		}
+	}
+}
+
+TEST(ScanTest, InPlaceAndConverting)
+{
+	using namespace si;
+
+	UnitArray<float, Length<meter>> in = {Meters(1), Meters(2), Meters(3), Meters(4)};
+	UnitArray<float, Length<std::centi>> out(4);
+	inclusive_scan(make_span(in), make_span(out));
+	EXPECT_FLOAT_EQ(100, out[0].value());
+	EXPECT_FLOAT_EQ(1000, out[3].value());
+
+	// A float span summed into double
+	UnitArray<double, Length<meter>> wide(4);
+	exclusive_scan(make_span(in), make_span(wide));
+	EXPECT_EQ(6, wide[3].value());
+
+	exclusive_scan(make_span(in), make_span(in));
+	EXPECT_FLOAT_EQ(0, in[0].value());
+	EXPECT_FLOAT_EQ(6, in[3].value());
+
+	//UnitArray<float, Time<second>> bad(4);
+	//inclusive_scan(make_span(in), make_span(bad));  // Should not compile
+}
+
+TEST(ScanTest, CumulativeIntegral)
+{
+	using namespace si;
+
+	// Constant acceleration from rest: v = a t, x = a t^2 / 2, which the trapezoid rule integrates exactly
+	const std::size_t n = 1001;
+	UnitArray<float, Velocity<meter, second>> velocity(n);
+	for (std::size_t i = 0; i < n; ++i)
+		velocity[i] = Meters_Second(2 * 0.5f * i);
+
+	parallel::Options options;
+	options.grain = 64;
+	auto position = cumulative_integral(make_span(velocity), Seconds(0.5f), options);
+	EXPECT_EQ(1, (std::is_same<Meters, decltype(position)::value_type>::value));
+	ASSERT_EQ(n, position.size());
+	EXPECT_EQ(0, position[0].value());
+	for (std::size_t i = 0; i < n; ++i) {
+		const float t = 0.5f * i;
+		ASSERT_NEAR(t * t, position[i].value(), 1e-6 * t * t);
+	}
+
+	// The step is converted to the unit of the result
+	auto minutes = cumulative_integral(make_span(velocity), Minutes(1));
+	EXPECT_EQ(1, (std::is_same<Meters, decltype(minutes)::value_type>::value));
+	EXPECT_FLOAT_EQ(30, minutes[1].value());
+
+	// Irregular sample times
+	UnitArray<float, Time<second>> times = {Seconds(0), Seconds(1), Seconds(3), Seconds(3.5f)};
+	UnitArray<float, Velocity<meter, second>> v = {Meters_Second(1), Meters_Second(1), Meters_Second(3), Meters_Second(3)};
+	auto x = cumulative_integral(make_span(v), make_span(times));
+	EXPECT_FLOAT_EQ(0, x[0].value());
+	EXPECT_FLOAT_EQ(1, x[1].value());
+	EXPECT_FLOAT_EQ(5, x[2].value());
+	EXPECT_FLOAT_EQ(6.5f, x[3].value());
+}
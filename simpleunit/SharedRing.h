@@ -0,0 +1,378 @@
+#pragma once
+
+#include "simpleunit/Unit.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace sunit {
+
+// A record of units, laid out as a plain struct, for passing through shared memory
+//
+//     using Sample = UnitRecord<Seconds, Meters, Meters_Second>;
+//     Sample s = make_record(Seconds(t), Meters(x), Meters_Second(v));
+//     Meters x = get<1>(s);
+template <typename... Units>
+struct UnitRecord;
+
+template <typename U>
+struct UnitRecord<U>
+{
+	U first;
+};
+
+template <typename U, typename V, typename... Rest>
+struct UnitRecord<U, V, Rest...>
+{
+	U first;
+	UnitRecord<V, Rest...> rest;
+};
+
+namespace detail
+{
+	template <std::size_t I>
+	struct RecordField
+	{
+		template <typename R>
+		static auto& of(R& r) { return RecordField<I - 1>::of(r.rest); }
+	};
+
+	template <>
+	struct RecordField<0>
+	{
+		template <typename R>
+		static auto& of(R& r) { return r.first; }
+	};
+}
+
+template <std::size_t I, typename... Units>
+auto& get(UnitRecord<Units...>& r) { return detail::RecordField<I>::of(r); }
+
+template <std::size_t I, typename... Units>
+const auto& get(const UnitRecord<Units...>& r) { return detail::RecordField<I>::of(r); }
+
+template <typename U>
+UnitRecord<U> make_record(const U& first)
+{
+	return UnitRecord<U>{first};
+}
+
+template <typename U, typename V, typename... Rest>
+UnitRecord<U, V, Rest...> make_record(const U& first, const V& second, const Rest&... rest)
+{
+	return UnitRecord<U, V, Rest...>{first, make_record(second, rest...)};
+}
+
+enum class RingProducers : std::uint32_t { single = 1, multiple = 2 };
+
+namespace detail
+{
+	// How one field of a record is stored, written into the segment by its creator and checked by
+	// everyone attaching
+	struct RingField
+	{
+		std::uint32_t kind;  // 'f' floating-point, 'i' signed or 'u' unsigned integer
+		std::uint32_t size;
+		std::uint32_t offset;
+		std::int32_t dim[3];
+		std::int64_t ratio[3][2];
+
+		bool operator==(const RingField& rhs) const { return std::memcmp(this, &rhs, sizeof(RingField)) == 0; }
+	};
+
+	template <typename U>
+	RingField ring_field(std::size_t offset)
+	{
+		using T = typename U::rep;
+		using B = typename U::base;
+		static_assert(std::is_arithmetic<T>::value, "shared records hold arithmetic reps");
+		RingField f;
+		std::memset(&f, 0, sizeof(f));
+		f.kind = std::is_floating_point<T>::value ? 'f' : std::is_signed<T>::value ? 'i' : 'u';
+		f.size = sizeof(T);
+		f.offset = static_cast<std::uint32_t>(offset);
+		f.dim[0] = B::dim::d1;
+		f.dim[1] = B::dim::d2;
+		f.dim[2] = B::dim::d3;
+		const std::int64_t ratios[3][2] = {{B::r1::num, B::r1::den}, {B::r2::num, B::r2::den}, {B::r3::num, B::r3::den}};
+		std::memcpy(f.ratio, ratios, sizeof(ratios));
+		return f;
+	}
+
+	template <typename... Units, std::size_t... I>
+	void ring_schema(RingField* fields, std::index_sequence<I...>)
+	{
+		UnitRecord<Units...> r;
+		const char* base = reinterpret_cast<const char*>(&r);
+		const RingField f[] = {ring_field<Units>(reinterpret_cast<const char*>(&get<I>(r)) - base)...};
+		std::copy(f, f + sizeof...(Units), fields);
+	}
+
+	struct RingHeader
+	{
+		static constexpr std::uint64_t magic_value = 0x676e6952746e7573;  // "suntRing"
+		static constexpr std::uint32_t version_value = 1;
+		static constexpr std::size_t max_fields = 16;
+
+		std::atomic<std::uint64_t> magic;
+		std::uint32_t version;
+		std::uint32_t producers;
+		std::uint64_t capacity;
+		std::uint64_t record_size;
+		std::uint32_t field_count;
+		RingField fields[max_fields];
+
+		// Records [tail, head) are ready to read; producers have claimed up to `reserved`
+		alignas(64) std::atomic<std::uint64_t> head;
+		alignas(64) std::atomic<std::uint64_t> reserved;
+		alignas(64) std::atomic<std::uint64_t> tail;
+	};
+
+	constexpr std::uint64_t RingHeader::magic_value;
+	constexpr std::uint32_t RingHeader::version_value;
+	constexpr std::size_t RingHeader::max_fields;
+
+	constexpr std::size_t ring_records_offset() { return (sizeof(RingHeader) + 63) / 64 * 64; }
+}
+
+// A bounded queue of records in POSIX shared memory, between processes (or threads) on one host.
+// The creator writes each field's rep, dimension and ratios into the segment; attaching checks them
+// against the attacher's record type, so records are then read in place with no per-record checks.
+//
+//     auto ring = SharedRing<Seconds, Meters>::create("/acquisition", 1 << 16);   // producer
+//     auto ring = SharedRing<Seconds, Meters>::attach("/acquisition");            // consumer
+//
+// There is one consumer. There may be one producer, or several if created with
+// RingProducers::multiple, in which case each claims slots by compare-and-swap and publishes them
+// in order of claiming. Batches cost one claim (if several producers) and one publish, however
+// many records they hold.
+//
+// A SharedRing object is used by one thread: it caches the consumer's position unsynchronized. Each
+// producer thread attaches its own object, as does each producer process.
+template <typename... Units>
+class SharedRing
+{
+	static_assert(sizeof...(Units) <= detail::RingHeader::max_fields, "too many fields for a shared record");
+	static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "shared rings need lock-free 64-bit atomics");
+
+public:
+	using record_type = UnitRecord<Units...>;
+	static_assert(std::is_trivially_copyable<record_type>::value, "shared records must be trivially copyable");
+
+	// Create a segment holding `capacity` records (rounded up to a power of two), replacing any of
+	// the same name. Throws std::runtime_error if it cannot be created
+	static SharedRing create(const std::string& name, std::size_t capacity, RingProducers producers = RingProducers::single)
+	{
+		std::size_t size = 1;
+		while (size < capacity) size *= 2;
+
+		const int fd = ::shm_open(name.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0600);
+		if (fd < 0)
+			throw std::runtime_error("cannot create shared memory " + name);
+		const std::size_t bytes = detail::ring_records_offset() + size * sizeof(record_type);
+		if (::ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+			::close(fd);
+			throw std::runtime_error("cannot size shared memory " + name);
+		}
+		SharedRing ring(fd, bytes, name);
+
+		auto* h = new (ring.base_) detail::RingHeader;
+		h->version = detail::RingHeader::version_value;
+		h->producers = static_cast<std::uint32_t>(producers);
+		h->capacity = size;
+		h->record_size = sizeof(record_type);
+		h->field_count = sizeof...(Units);
+		detail::ring_schema<Units...>(h->fields, std::index_sequence_for<Units...>());
+		h->head.store(0, std::memory_order_relaxed);
+		h->reserved.store(0, std::memory_order_relaxed);
+		h->tail.store(0, std::memory_order_relaxed);
+		h->magic.store(detail::RingHeader::magic_value, std::memory_order_release);
+		ring.init();
+		return ring;
+	}
+
+	// Attach to an existing segment. Throws std::runtime_error if it cannot be opened, and
+	// std::invalid_argument if its records are not of this type
+	static SharedRing attach(const std::string& name)
+	{
+		const int fd = ::shm_open(name.c_str(), O_RDWR, 0);
+		if (fd < 0)
+			throw std::runtime_error("cannot open shared memory " + name);
+		struct stat st;
+		if (::fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < detail::ring_records_offset()) {
+			::close(fd);
+			throw std::runtime_error("not a shared ring: " + name);
+		}
+		SharedRing ring(fd, static_cast<std::size_t>(st.st_size), name);
+
+		const detail::RingHeader* h = ring.header();
+		if (h->magic.load(std::memory_order_acquire) != detail::RingHeader::magic_value
+		    || h->version != detail::RingHeader::version_value)
+			throw std::runtime_error("not a shared ring: " + name);
+		if (ring.size_ < detail::ring_records_offset() + h->capacity * h->record_size)
+			throw std::runtime_error("truncated shared ring: " + name);
+
+		detail::RingField fields[sizeof...(Units) + 1];
+		detail::ring_schema<Units...>(fields, std::index_sequence_for<Units...>());
+		if (h->field_count != sizeof...(Units))
+			throw std::invalid_argument(name + ": records have " + std::to_string(h->field_count) + " fields, not "
+			                            + std::to_string(sizeof...(Units)));
+		for (std::size_t i = 0; i < sizeof...(Units); ++i)
+			if (!(h->fields[i] == fields[i]))
+				throw std::invalid_argument(name + ": field " + std::to_string(i) + " differs in rep, unit or layout");
+		if (h->record_size != sizeof(record_type))
+			throw std::invalid_argument(name + ": records differ in size");
+		ring.init();
+		return ring;
+	}
+
+	// Remove the name; the memory is freed once every process has detached
+	static void remove(const std::string& name) { ::shm_unlink(name.c_str()); }
+
+	SharedRing(SharedRing&& rhs) noexcept { swap(rhs); }
+	SharedRing& operator=(SharedRing rhs) noexcept { swap(rhs); return *this; }
+	SharedRing(const SharedRing&) = delete;
+
+	~SharedRing()
+	{
+		if (base_)
+			::munmap(base_, size_);
+	}
+
+	std::size_t capacity() const { return mask_ + 1; }
+
+	// Records ready to read
+	std::size_t size() const
+	{
+		return static_cast<std::size_t>(header()->head.load(std::memory_order_acquire) - header()->tail.load(std::memory_order_acquire));
+	}
+
+	// Producer: push as many of the records as fit, returning how many
+	std::size_t push(const record_type* records, std::size_t n)
+	{
+		detail::RingHeader* h = header();
+		std::uint64_t start;
+		if (multiple_) {
+			start = h->reserved.load(std::memory_order_relaxed);
+			do {
+				n = std::min<std::size_t>(n, free_from(start, n));
+				if (n == 0) return 0;
+			} while (!h->reserved.compare_exchange_weak(start, start + n, std::memory_order_relaxed));
+		}
+		else {
+			start = h->head.load(std::memory_order_relaxed);
+			n = std::min<std::size_t>(n, free_from(start, n));
+			if (n == 0) return 0;
+		}
+
+		const std::size_t first = static_cast<std::size_t>(start) & mask_;
+		const std::size_t run = std::min(n, capacity() - first);
+		std::memcpy(records_ + first, records, run * sizeof(record_type));
+		std::memcpy(records_, records + run, (n - run) * sizeof(record_type));
+
+		// Publish in order of claiming, after any earlier producers
+		if (multiple_)
+			while (h->head.load(std::memory_order_acquire) != start)
+				std::this_thread::yield();
+		h->head.store(start + n, std::memory_order_release);
+		return n;
+	}
+
+	bool try_push(const record_type& r) { return push(&r, 1) == 1; }
+
+	// Consumer: pass up to `max` ready records to f(const record_type* records, std::size_t n), in
+	// place, as one or two contiguous runs, then release their slots. Returns the number consumed
+	template <typename F>
+	std::size_t consume(F f, std::size_t max = std::size_t(-1))
+	{
+		detail::RingHeader* h = header();
+		const std::uint64_t tail = h->tail.load(std::memory_order_relaxed);
+		if (cached_head_ <= tail || cached_head_ - tail < max)
+			cached_head_ = h->head.load(std::memory_order_acquire);
+		const std::size_t n = static_cast<std::size_t>(std::min<std::uint64_t>(cached_head_ - tail, max));
+		if (n == 0) return 0;
+
+		const std::size_t first = static_cast<std::size_t>(tail) & mask_;
+		const std::size_t run = std::min(n, capacity() - first);
+		f(static_cast<const record_type*>(records_ + first), run);
+		if (run < n)
+			f(static_cast<const record_type*>(records_), n - run);
+		h->tail.store(tail + n, std::memory_order_release);
+		return n;
+	}
+
+	// Consumer: copy out up to n records
+	std::size_t pop(record_type* out, std::size_t n)
+	{
+		return consume([&out](const record_type* r, std::size_t k) {
+			std::memcpy(out, r, k * sizeof(record_type));
+			out += k;
+		}, n);
+	}
+
+	bool try_pop(record_type& r) { return pop(&r, 1) == 1; }
+
+private:
+	SharedRing() = default;
+
+	SharedRing(int fd, std::size_t size, const std::string& name) : size_(size)
+	{
+		void* p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		::close(fd);
+		if (p == MAP_FAILED)
+			throw std::runtime_error("cannot map shared memory " + name);
+		base_ = p;
+	}
+
+	void init()
+	{
+		const detail::RingHeader* h = header();
+		mask_ = static_cast<std::size_t>(h->capacity) - 1;
+		multiple_ = h->producers == static_cast<std::uint32_t>(RingProducers::multiple);
+		records_ = reinterpret_cast<record_type*>(static_cast<char*>(base_) + detail::ring_records_offset());
+	}
+
+	// Slots free for records from `start`, reading the consumer's position only when those last
+	// seen are not enough for `want`
+	std::size_t free_from(std::uint64_t start, std::size_t want)
+	{
+		if (start - cached_tail_ + want > capacity())
+			cached_tail_ = header()->tail.load(std::memory_order_acquire);
+		return capacity() - static_cast<std::size_t>(start - cached_tail_);
+	}
+
+	detail::RingHeader* header() const { return static_cast<detail::RingHeader*>(base_); }
+
+	void swap(SharedRing& rhs) noexcept
+	{
+		std::swap(base_, rhs.base_);
+		std::swap(size_, rhs.size_);
+		std::swap(records_, rhs.records_);
+		std::swap(mask_, rhs.mask_);
+		std::swap(multiple_, rhs.multiple_);
+		std::swap(cached_head_, rhs.cached_head_);
+		std::swap(cached_tail_, rhs.cached_tail_);
+	}
+
+	void* base_ = nullptr;
+	std::size_t size_ = 0;
+	record_type* records_ = nullptr;
+	std::size_t mask_ = 0;
+	bool multiple_ = false;
+	std::uint64_t cached_head_ = 0;
+	std::uint64_t cached_tail_ = 0;
+};
+
+} // sunit
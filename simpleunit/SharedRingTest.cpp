@@ -0,0 +1,113 @@
+#include "simpleunit/SharedRing.h"
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include "gtest/gtest.h"
+
+using namespace std;
+using namespace sunit;
+
+namespace
+{
+	using Sample = UnitRecord<si::Seconds, si::Meters, Unit<int32_t, Time<std::milli>>>;
+	using Ring = SharedRing<si::Seconds, si::Meters, Unit<int32_t, Time<std::milli>>>;
+
+	string segment(const char* name) { return "/sunit_" + string(name) + "_" + to_string(::getpid()); }
+}
+
+TEST(SharedRingTest, Record)
+{
+	using namespace si;
+
+	Sample s = make_record(Seconds(1.5f), Meters(2), Unit<int32_t, Time<std::milli>>(3));
+	EXPECT_FLOAT_EQ(1.5f, get<0>(s).value());
+	EXPECT_FLOAT_EQ(2, get<1>(s).value());
+	get<2>(s) = Unit<int32_t, Time<std::milli>>(4);
+	EXPECT_EQ(4, get<2>(s).value());
+	EXPECT_EQ(12u, sizeof(Sample));
+}
+
+TEST(SharedRingTest, Attach)
+{
+	using namespace si;
+
+	const string name = segment("attach");
+	Ring producer = Ring::create(name, 10);
+	Ring consumer = Ring::attach(name);
+	EXPECT_EQ(16u, consumer.capacity());
+
+	vector<Sample> batch;
+	for (int i = 0; i < 20; ++i)
+		batch.push_back(make_record(Seconds(float(i)), Meters(i * 2.0f), Unit<int32_t, Time<std::milli>>(i)));
+	EXPECT_EQ(16u, producer.push(batch.data(), batch.size()));
+	EXPECT_FALSE(producer.try_push(batch[0]));
+	EXPECT_EQ(16u, consumer.size());
+
+	// Read in place, in two runs once the ring wraps
+	Sample s[4];
+	ASSERT_EQ(4u, consumer.pop(s, 4));
+	EXPECT_FLOAT_EQ(3, get<0>(s[3]).value());
+	EXPECT_EQ(4u, producer.push(batch.data() + 16, 4));
+	int expected = 4;
+	EXPECT_EQ(16u, consumer.consume([&](const Sample* r, size_t n) {
+		for (size_t i = 0; i < n; ++i, ++expected) {
+			EXPECT_FLOAT_EQ(float(expected), get<0>(r[i]).value());
+			EXPECT_EQ(expected, get<2>(r[i]).value());
+		}
+	}));
+	EXPECT_EQ(20, expected);
+	EXPECT_EQ(0u, consumer.size());
+	EXPECT_FALSE(consumer.try_pop(s[0]));
+
+	// The schema must match
+	EXPECT_THROW((SharedRing<Seconds, Meters>::attach(name)), invalid_argument);
+	EXPECT_THROW((SharedRing<Seconds, Centimeters, Unit<int32_t, Time<std::milli>>>::attach(name)), invalid_argument);
+	EXPECT_THROW((SharedRing<Seconds, Meters, Unit<uint32_t, Time<std::milli>>>::attach(name)), invalid_argument);
+	EXPECT_THROW((SharedRing<Seconds, Meters_Second, Unit<int32_t, Time<std::milli>>>::attach(name)), invalid_argument);
+
+	Ring::remove(name);
+	EXPECT_THROW(Ring::attach(name), runtime_error);
+}
+
+TEST(SharedRingTest, Producers)
+{
+	using namespace si;
+	using Pair = UnitRecord<Seconds, Unit<int64_t, Length<meter>>>;
+	using PairRing = SharedRing<Seconds, Unit<int64_t, Length<meter>>>;
+
+	const int producers = 3;
+	const int64_t per_producer = 5000;
+	const string name = segment("producers");
+	PairRing ring = PairRing::create(name, 256, RingProducers::multiple);
+
+	vector<thread> threads;
+	for (int p = 0; p < producers; ++p)
+		threads.emplace_back([&name, p, per_producer] {
+			PairRing r = PairRing::attach(name);
+			Pair batch[7];
+			for (int64_t i = 0; i < per_producer;) {
+				const size_t n = static_cast<size_t>(std::min<int64_t>(7, per_producer - i));
+				for (size_t k = 0; k < n; ++k)
+					batch[k] = make_record(Seconds(float(p)), Unit<int64_t, Length<meter>>(i + k));
+				i += r.push(batch, n);
+			}
+		});
+
+	// Each producer's records arrive in its own order
+	vector<int64_t> next(producers, 0);
+	int64_t total = 0;
+	while (total < producers * per_producer)
+		total += ring.consume([&](const Pair* r, size_t n) {
+			for (size_t i = 0; i < n; ++i) {
+				const int p = static_cast<int>(get<0>(r[i]).value());
+				EXPECT_EQ(next[p]++, get<1>(r[i]).value());
+			}
+		});
+	for (auto& t : threads)
+		t.join();
+	for (int p = 0; p < producers; ++p)
+		EXPECT_EQ(per_producer, next[p]);
+	PairRing::remove(name);
+}
@@ -0,0 +1,404 @@
+#pragma once
+
+#include "simpleunit/Parallel.h"
+#include "simpleunit/UnitSpan.h"
+#include "simpleunit/UnitVec.h"
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace sunit {
+
+// Root finding and least-squares fitting in units. Brackets, starting points, tolerances and
+// results are Units; a tolerance may be in any unit of x's dimension, converted once on entry:
+//
+//     auto r = brent(f, Seconds(0), Seconds(10), Unit<double, Time<std::milli>>(1));
+//     if (r.converged) ... r.x ...
+//
+//     auto fit = levenberg_marquardt<0, 1>(data, [](Seconds t, Meters h0, Meters_Second2 g) {
+//         return h0 - 0.5f * g * t * t; }, std::make_tuple(Meters(90), Meters_Second2(9)));
+//
+// Solvers call f with Units and read the values of what it returns, so f may return any unit.
+
+template <typename U>
+struct Root
+{
+	U x;
+	std::size_t iterations;
+	bool converged;
+};
+
+namespace detail
+{
+	template <typename X, typename Bx, typename Y, typename By>
+	X root_tolerance(const Unit<Y,By>& tolerance)
+	{
+		static_assert(std::is_floating_point<X>::value, "roots are found in floating point");
+		return std::abs(unit_cast<Unit<X,Bx>>(tolerance).value());
+	}
+
+	template <typename X, typename Bx, typename F>
+	X evaluate_root(F& f, X x)
+	{
+		return static_cast<X>(f(Unit<X,Bx>(x)).value());
+	}
+}
+
+// Bisection of a bracket [lo, hi] over which f changes sign, until it is narrower than the
+// tolerance. Throws std::invalid_argument if f does not change sign
+template <typename F, typename X, typename Bx, typename Y, typename By>
+Root<Unit<X,Bx>> bisect(F f, const Unit<X,Bx>& lo, const Unit<X,Bx>& hi, const Unit<Y,By>& tolerance,
+                        std::size_t max_iterations = 200)
+{
+	const X tol = detail::root_tolerance<X,Bx>(tolerance);
+	X a = lo.value(), b = hi.value();
+	X fa = detail::evaluate_root<X,Bx>(f, a);
+	const X fb = detail::evaluate_root<X,Bx>(f, b);
+	if (fa == 0) return {lo, 0, true};
+	if (fb == 0) return {hi, 0, true};
+	if ((fa < 0) == (fb < 0))
+		throw std::invalid_argument("bisect: f does not change sign over the bracket");
+
+	for (std::size_t i = 1; i <= max_iterations; ++i) {
+		const X m = a + (b - a) / 2;
+		const X fm = detail::evaluate_root<X,Bx>(f, m);
+		if (fm == 0 || std::abs(b - a) / 2 <= tol)
+			return {Unit<X,Bx>(m), i, true};
+		if ((fm < 0) == (fa < 0)) {
+			a = m;
+			fa = fm;
+		}
+		else
+			b = m;
+	}
+	return {Unit<X,Bx>(a + (b - a) / 2), max_iterations, false};
+}
+
+// Brent's method: inverse quadratic interpolation and secant steps, falling back to bisection,
+// over a bracket [lo, hi] over which f changes sign. Throws std::invalid_argument if it does not
+template <typename F, typename X, typename Bx, typename Y, typename By>
+Root<Unit<X,Bx>> brent(F f, const Unit<X,Bx>& lo, const Unit<X,Bx>& hi, const Unit<Y,By>& tolerance,
+                       std::size_t max_iterations = 100)
+{
+	const X tol = detail::root_tolerance<X,Bx>(tolerance);
+	const X eps = std::numeric_limits<X>::epsilon();
+	X a = lo.value(), b = hi.value();
+	X fa = detail::evaluate_root<X,Bx>(f, a);
+	X fb = detail::evaluate_root<X,Bx>(f, b);
+	if (fa == 0) return {lo, 0, true};
+	if (fb == 0) return {hi, 0, true};
+	if ((fa < 0) == (fb < 0))
+		throw std::invalid_argument("brent: f does not change sign over the bracket");
+
+	// b is the best estimate, a the previous one, and c the other end of the bracket
+	X c = a, fc = fa, d = b - a, e = d;
+	for (std::size_t i = 1; i <= max_iterations; ++i) {
+		if ((fb < 0) == (fc < 0)) {
+			c = a;
+			fc = fa;
+			d = e = b - a;
+		}
+		if (std::abs(fc) < std::abs(fb)) {
+			a = b; b = c; c = a;
+			fa = fb; fb = fc; fc = fa;
+		}
+		const X t = 2 * eps * std::abs(b) + tol / 2;
+		const X m = (c - b) / 2;
+		if (std::abs(m) <= t || fb == 0)
+			return {Unit<X,Bx>(b), i, true};
+
+		if (std::abs(e) >= t && std::abs(fa) > std::abs(fb)) {
+			X p, q;
+			const X s = fb / fa;
+			if (a == c) {
+				p = 2 * m * s;
+				q = 1 - s;
+			}
+			else {
+				const X qa = fa / fc, r = fb / fc;
+				p = s * (2 * m * qa * (qa - r) - (b - a) * (r - 1));
+				q = (qa - 1) * (r - 1) * (s - 1);
+			}
+			if (p > 0) q = -q;
+			else p = -p;
+			if (2 * p < std::min(3 * m * q - std::abs(t * q), std::abs(e * q))) {
+				e = d;
+				d = p / q;
+			}
+			else
+				d = e = m;
+		}
+		else
+			d = e = m;
+
+		a = b;
+		fa = fb;
+		b += std::abs(d) > t ? d : (m > 0 ? t : -t);
+		fb = detail::evaluate_root<X,Bx>(f, b);
+	}
+	return {Unit<X,Bx>(b), max_iterations, false};
+}
+
+// Newton's method from x0, with df the derivative of f: its unit must be f's over x's, so that
+// each step f / df is in x's dimension. Stops when a step is within the tolerance
+template <typename F, typename DF, typename X, typename Bx, typename Y, typename By>
+Root<Unit<X,Bx>> newton(F f, DF df, const Unit<X,Bx>& x0, const Unit<Y,By>& tolerance,
+                        std::size_t max_iterations = 50)
+{
+	const X tol = detail::root_tolerance<X,Bx>(tolerance);
+	Unit<X,Bx> x = x0;
+	for (std::size_t i = 1; i <= max_iterations; ++i) {
+		const auto slope = df(x);
+		if (slope.value() == 0)
+			return {x, i, false};
+		const X step = unit_cast<Unit<X,Bx>>(f(x) / slope).value();
+		x = Unit<X,Bx>(x.value() - step);
+		if (!std::isfinite(x.value()))
+			return {x, i, false};
+		if (std::abs(step) <= tol)
+			return {x, i, true};
+	}
+	return {x, max_iterations, false};
+}
+
+// Levenberg-Marquardt
+
+struct FitOptions
+{
+	std::size_t max_iterations = 100;
+
+	// Stop when an accepted step reduces the sum of squares by less than this fraction. It is
+	// relative, so it does not depend on the units of y
+	double tolerance = 1e-12;
+
+	// Initial damping, relative to the diagonal of J'J
+	double damping = 1e-3;
+
+	parallel::Options parallel;
+};
+
+template <typename... P>
+struct FitResult
+{
+	std::tuple<P...> parameters;
+
+	// Sum of squared residuals, in the values of the data's y unit, squared
+	double residual;
+	std::size_t iterations;
+	bool converged;
+};
+
+namespace detail
+{
+	// Sums over data points of J'J, J'r and r'r, for M parameters
+	template <std::size_t M>
+	struct NormalEquations
+	{
+		std::array<double, M * M> jtj = {};
+		std::array<double, M> jtr = {};
+		double rtr = 0;
+
+		NormalEquations& operator+=(const NormalEquations& rhs)
+		{
+			for (std::size_t k = 0; k < M * M; ++k) jtj[k] += rhs.jtj[k];
+			for (std::size_t k = 0; k < M; ++k) jtr[k] += rhs.jtr[k];
+			rtr += rhs.rtr;
+			return *this;
+		}
+	};
+
+	// Solve A x = b for symmetric positive definite A, by Cholesky. False if A is not
+	template <std::size_t M>
+	bool cholesky_solve(std::array<double, M * M> a, std::array<double, M>& b)
+	{
+		for (std::size_t j = 0; j < M; ++j) {
+			double d = a[j * M + j];
+			for (std::size_t k = 0; k < j; ++k)
+				d -= a[j * M + k] * a[j * M + k];
+			if (!(d > 0)) return false;
+			a[j * M + j] = std::sqrt(d);
+			for (std::size_t i = j + 1; i < M; ++i) {
+				double s = a[i * M + j];
+				for (std::size_t k = 0; k < j; ++k)
+					s -= a[i * M + k] * a[j * M + k];
+				a[i * M + j] = s / a[j * M + j];
+			}
+		}
+		for (std::size_t i = 0; i < M; ++i) {
+			for (std::size_t k = 0; k < i; ++k)
+				b[i] -= a[i * M + k] * b[k];
+			b[i] /= a[i * M + i];
+		}
+		for (std::size_t i = M; i-- > 0;) {
+			for (std::size_t k = i + 1; k < M; ++k)
+				b[i] -= a[k * M + i] * b[k];
+			b[i] /= a[i * M + i];
+		}
+		return true;
+	}
+
+	template <typename Model, typename XU, typename YU, typename... P>
+	class FitProblem
+	{
+	public:
+		static constexpr std::size_t M = sizeof...(P);
+		static constexpr std::size_t block = 256;
+
+		FitProblem(Model& model, const typename XU::rep* x, const typename YU::rep* y, std::size_t n, const parallel::Options& options)
+			: model_(model), x_(x), y_(y), n_(n), options_(options) {}
+
+		// Residuals y - f(x) a block at a time, and the Jacobian of f by forward differences, one
+		// parameter per pass over the block, so each pass is a loop across data points
+		NormalEquations<M> accumulate(const std::array<double, M>& p, bool jacobian) const
+		{
+			const std::size_t blocks = (n_ + block - 1) / block;
+			const std::size_t per_part = 16;
+			std::vector<NormalEquations<M>> parts((blocks + per_part - 1) / per_part);
+			parallel::for_range(parts.size(), 1, [&](std::size_t q0, std::size_t q1) {
+				double r[block], f0[block];
+				std::array<std::array<double, block>, M> j;
+				for (std::size_t q = q0; q < q1; ++q) {
+					NormalEquations<M>& sums = parts[q];
+					for (std::size_t b = q * per_part * block; b < std::min(n_, (q + 1) * per_part * block); b += block) {
+						const std::size_t m = n_ - b < block ? n_ - b : block;
+						evaluate(p, b, m, f0);
+						for (std::size_t i = 0; i < m; ++i) {
+							r[i] = static_cast<double>(y_[b + i]) - f0[i];
+							sums.rtr += r[i] * r[i];
+						}
+						if (!jacobian) continue;
+						for (std::size_t k = 0; k < M; ++k) {
+							std::array<double, M> pk = p;
+							const double h = std::sqrt(epsilon_[k]) * std::max(std::abs(p[k]), 1.0);
+							pk[k] = round_[k](p[k] + h);
+							evaluate(pk, b, m, j[k].data());
+							const double inv = 1 / (pk[k] - p[k]);
+							for (std::size_t i = 0; i < m; ++i)
+								j[k][i] = (j[k][i] - f0[i]) * inv;
+						}
+						for (std::size_t k = 0; k < M; ++k) {
+							double s = 0;
+							for (std::size_t i = 0; i < m; ++i)
+								s += j[k][i] * r[i];
+							sums.jtr[k] += s;
+							for (std::size_t l = 0; l <= k; ++l) {
+								double t = 0;
+								for (std::size_t i = 0; i < m; ++i)
+									t += j[k][i] * j[l][i];
+								sums.jtj[k * M + l] += t;
+							}
+						}
+					}
+				}
+			}, options_);
+
+			NormalEquations<M> total;
+			for (const auto& part : parts)
+				total += part;
+			for (std::size_t k = 0; k < M; ++k)
+				for (std::size_t l = k + 1; l < M; ++l)
+					total.jtj[k * M + l] = total.jtj[l * M + k];
+			return total;
+		}
+
+		std::tuple<P...> parameters(const std::array<double, M>& p) const
+		{
+			return parameters(p, std::index_sequence_for<P...>());
+		}
+
+	private:
+		void evaluate(const std::array<double, M>& p, std::size_t begin, std::size_t m, double* out) const
+		{
+			evaluate(p, begin, m, out, std::index_sequence_for<P...>());
+		}
+
+		template <std::size_t... K>
+		void evaluate(const std::array<double, M>& p, std::size_t begin, std::size_t m, double* out, std::index_sequence<K...>) const
+		{
+			const std::tuple<P...> params(P(static_cast<typename P::rep>(p[K]))...);
+			for (std::size_t i = 0; i < m; ++i)
+				out[i] = unit_cast<Unit<double, typename YU::base>>(model_(XU(x_[begin + i]), std::get<K>(params)...)).value();
+		}
+
+		template <typename R>
+		static double round_to(double v) { return static_cast<double>(static_cast<R>(v)); }
+
+		template <std::size_t... K>
+		std::tuple<P...> parameters(const std::array<double, M>& p, std::index_sequence<K...>) const
+		{
+			return std::tuple<P...>(P(static_cast<typename P::rep>(p[K]))...);
+		}
+
+		// Per parameter, the precision of its rep and a rounding to it, so steps are steps taken
+		const std::array<double, M> epsilon_ = {{std::numeric_limits<typename P::rep>::epsilon()...}};
+		const std::array<double (*)(double), M> round_ = {{&round_to<typename P::rep>...}};
+
+		Model& model_;
+		const typename XU::rep* x_;
+		const typename YU::rep* y_;
+		std::size_t n_;
+		parallel::Options options_;
+	};
+
+	template <typename... P, std::size_t... K>
+	std::array<double, sizeof...(P)> parameter_values(const std::tuple<P...>& p, std::index_sequence<K...>)
+	{
+		return {{static_cast<double>(std::get<K>(p).value())...}};
+	}
+}
+
+// Fit the parameters of model(x, p...) to columns IX (x) and IY (y) of a UnitSoA, minimizing the
+// sum of squared residuals by Levenberg-Marquardt. The model is called with x in column IX's unit
+// and the parameters in the units of initial, and its result is converted to column IY's unit
+template <std::size_t IX, std::size_t IY, typename Model, typename Alloc, typename... Units, typename... P>
+FitResult<P...> levenberg_marquardt(const BasicUnitSoA<Alloc, Units...>& data, Model model, const std::tuple<P...>& initial,
+                                    const FitOptions& options = FitOptions())
+{
+	using XU = typename BasicUnitSoA<Alloc, Units...>::template column_unit<IX>;
+	using YU = typename BasicUnitSoA<Alloc, Units...>::template column_unit<IY>;
+	constexpr std::size_t M = sizeof...(P);
+	static_assert(detail::all_of<std::is_floating_point<typename P::rep>::value...>::value, "parameters are fitted in floating point");
+	const detail::FitProblem<Model, XU, YU, P...> problem(model, data.template column<IX>().values(),
+	                                                      data.template column<IY>().values(), data.size(), options.parallel);
+
+	std::array<double, M> p = detail::parameter_values(initial, std::index_sequence_for<P...>());
+	detail::NormalEquations<M> eq = problem.accumulate(p, true);
+	double lambda = options.damping;
+	for (std::size_t iteration = 1; iteration <= options.max_iterations; ++iteration) {
+		// Solve (J'J + lambda diag(J'J)) step = J'r, raising the damping until the step helps
+		for (;;) {
+			std::array<double, M * M> a = eq.jtj;
+			for (std::size_t k = 0; k < M; ++k)
+				a[k * M + k] += lambda * std::max(eq.jtj[k * M + k], 1e-300);
+			std::array<double, M> step = eq.jtr;
+			if (detail::cholesky_solve<M>(a, step)) {
+				std::array<double, M> trial = p;
+				for (std::size_t k = 0; k < M; ++k)
+					trial[k] += step[k];
+				const detail::NormalEquations<M> next = problem.accumulate(trial, false);
+				if (std::isfinite(next.rtr) && next.rtr <= eq.rtr) {
+					const bool small = eq.rtr - next.rtr <= options.tolerance * eq.rtr;
+					p = trial;
+					lambda = std::max(lambda / 10, 1e-12);
+					if (small)
+						return {problem.parameters(p), next.rtr, iteration, true};
+					eq = problem.accumulate(p, true);
+					break;
+				}
+			}
+			lambda *= 10;
+			if (lambda > 1e16)
+				return {problem.parameters(p), eq.rtr, iteration, eq.rtr == 0};
+		}
+	}
+	return {problem.parameters(p), eq.rtr, options.max_iterations, false};
+}
+
+} // sunit
@@ -0,0 +1,111 @@
+#include "simpleunit/Solve.h"
+#include "gtest/gtest.h"
+#include <stdexcept>
+
+using namespace std;
+using namespace sunit;
+
+namespace
+{
+	using Seconds = Unit<double, Time<si::second>>;
+	using Milliseconds = Unit<double, Time<std::milli>>;
+	using Meters = Unit<double, Length<si::meter>>;
+	using Meters_Second = Unit<double, Velocity<si::meter, si::second>>;
+	using Meters_Second2 = Unit<double, Acceleration<si::meter, si::second>>;
+
+	// Height of a ball thrown up at 20 m/s from 100 m
+	Meters height(Seconds t)
+	{
+		return Meters(100) + Meters_Second(20) * t - Meters_Second2(4.9) * t * t;
+	}
+
+	Meters_Second speed(Seconds t)
+	{
+		return Meters_Second(20) - Meters_Second2(9.8) * t;
+	}
+
+	const double landing = (20 + sqrt(400 + 4 * 4.9 * 100)) / 9.8;
+}
+
+TEST(SolveTest, Bisect)
+{
+	const auto r = bisect(height, Seconds(0), Seconds(20), Milliseconds(0.001));
+	EXPECT_TRUE(r.converged);
+	EXPECT_NEAR(landing, r.x.value(), 1e-6);
+	EXPECT_THROW(bisect(height, Seconds(0), Seconds(1), Seconds(1e-6)), std::invalid_argument);
+}
+
+TEST(SolveTest, Brent)
+{
+	const auto r = brent(height, Seconds(0), Seconds(20), Milliseconds(1e-6));
+	EXPECT_TRUE(r.converged);
+	EXPECT_NEAR(landing, r.x.value(), 1e-8);
+	EXPECT_LT(r.iterations, 20u);
+	EXPECT_THROW(brent(height, Seconds(0), Seconds(1), Seconds(1e-6)), std::invalid_argument);
+
+	// The bracket may be in any unit of time; the root comes back in it
+	const auto ms = brent([](Milliseconds t) { return height(unit_cast<Seconds>(t)); },
+	                      Milliseconds(0), Milliseconds(20000), Seconds(1e-9));
+	EXPECT_NEAR(landing * 1000, ms.x.value(), 1e-5);
+}
+
+TEST(SolveTest, Newton)
+{
+	const auto r = newton(height, speed, Seconds(10), Milliseconds(1e-6));
+	EXPECT_TRUE(r.converged);
+	EXPECT_NEAR(landing, r.x.value(), 1e-9);
+
+	// At the top of the flight the slope is zero
+	const auto flat = newton(height, speed, Seconds(20 / 9.8), Seconds(1e-9));
+	EXPECT_FALSE(flat.converged);
+}
+
+TEST(SolveTest, LevenbergMarquardt)
+{
+	using Data = UnitSoA<Unit<float, Time<si::second>>, Unit<float, Length<std::milli>>>;
+	const size_t n = 5000;
+	Data data(n);
+	auto t = data.column<0>().values();
+	auto h = data.column<1>().values();
+	for (size_t i = 0; i < n; ++i) {
+		t[i] = 4.f * i / n;
+		const double noise = (i % 7 == 0 ? 1 : -1) * 0.5e-3 * (i % 3);
+		h[i] = static_cast<float>(1000 * (90 + 5 * t[i] - 4.9 * t[i] * t[i] + noise));
+	}
+
+	FitOptions options;
+	options.tolerance = 1e-10;
+	const auto fit = levenberg_marquardt<0, 1>(data,
+		[](Seconds s, Meters h0, Unit<float, Velocity<si::meter, si::second>> v0, Meters_Second2 g) {
+			return h0 + v0 * s - 0.5 * g * s * s; },
+		make_tuple(Meters(50), Unit<float, Velocity<si::meter, si::second>>(0), Meters_Second2(5)), options);
+	EXPECT_TRUE(fit.converged);
+	EXPECT_NEAR(90, get<0>(fit.parameters).value(), 1e-3);
+	EXPECT_NEAR(5, get<1>(fit.parameters).value(), 1e-3);
+	EXPECT_NEAR(9.8, get<2>(fit.parameters).value(), 1e-3);
+
+	// Residuals are in the data's millimetres: each is within a millimetre
+	EXPECT_LT(fit.residual, n * 1.0);
+}
+
+TEST(SolveTest, LevenbergMarquardtNonlinear)
+{
+	using Data = UnitSoA<Unit<double, Time<si::second>>, Unit<double, Length<si::meter>>>;
+	const size_t n = 1000;
+	Data data(n);
+	auto t = data.column<0>().values();
+	auto x = data.column<1>().values();
+	for (size_t i = 0; i < n; ++i) {
+		t[i] = 10.0 * i / n;
+		x[i] = 3 * exp(-0.7 * t[i]);
+	}
+
+	using Per_Second = Unit<double, Frequency<si::second>>;
+	const auto fit = levenberg_marquardt<0, 1>(data,
+		[](Seconds s, Meters a, Per_Second k) { return a * exp(-(k * s).value()); },
+		make_tuple(Meters(1), Per_Second(0.1)));
+	EXPECT_TRUE(fit.converged);
+	EXPECT_NEAR(3, get<0>(fit.parameters).value(), 1e-6);
+	EXPECT_NEAR(0.7, get<1>(fit.parameters).value(), 1e-6);
+	EXPECT_NEAR(0, fit.residual, 1e-10);
+}
@@ -0,0 +1,433 @@
+#pragma once
+
+#include "simpleunit/Parallel.h"
+#include "simpleunit/UnitSpan.h"
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace sunit {
+namespace spatial {
+
+// Neighbour search over points given as length columns, each in any unit. Points are converted
+// once, on building, to the index's unit, as are the centre and radius of each query, so the
+// search loops run on plain values:
+//
+//     auto tree = spatial::kd_tree<Meters, 0, 1, 2>(particles);     // columns in m, mm, ...
+//     auto near = tree.within({{Meters(1), Meters(2), Meters(0)}}, Centimeters(5));
+//     auto grid = spatial::uniform_grid<Meters, 0, 1, 2>(particles, Centimeters(10));
+//
+// Results are row indices into the columns the index was built from.
+
+namespace detail
+{
+	template <typename U, typename X, typename Bx>
+	typename U::rep length_value(const Unit<X,Bx>& x)
+	{
+		static_assert(std::is_same<typename Bx::dim, typename U::base::dim>::value, "positions and radii are lengths");
+		return unit_cast<U>(x).value();
+	}
+
+	// Coordinates of N-dimensional points, one array per axis, with each point's source row
+	template <std::size_t N, typename T>
+	struct PointSet
+	{
+		std::array<std::vector<T>, N> coords;
+		std::vector<std::uint32_t> rows;
+
+		std::size_t size() const { return rows.size(); }
+
+		// Reorder to the given source rows, from columns in source order
+		void gather(const std::array<std::vector<T>, N>& source, std::vector<std::uint32_t> order)
+		{
+			for (std::size_t d = 0; d < N; ++d) {
+				coords[d].resize(order.size());
+				for (std::size_t i = 0; i < order.size(); ++i)
+					coords[d][i] = source[d][order[i]];
+			}
+			rows = std::move(order);
+		}
+
+		T distance2(std::size_t i, const std::array<T, N>& q) const
+		{
+			T d2 = 0;
+			for (std::size_t d = 0; d < N; ++d) {
+				const T t = coords[d][i] - q[d];
+				d2 += t * t;
+			}
+			return d2;
+		}
+
+		// Squared distances from q of points [lo, hi), as a loop over each axis that vectorizes
+		void distances2(std::size_t lo, std::size_t hi, const std::array<T, N>& q, T* out) const
+		{
+			std::fill(out, out + (hi - lo), T(0));
+			for (std::size_t d = 0; d < N; ++d) {
+				const T* x = coords[d].data() + lo;
+				const T qd = q[d];
+				for (std::size_t i = 0; i < hi - lo; ++i) {
+					const T t = x[i] - qd;
+					out[i] += t * t;
+				}
+			}
+		}
+	};
+
+	template <typename U, std::size_t N, typename... X, typename... Bx>
+	std::array<std::vector<typename U::rep>, N> convert_columns(UnitSpan<X,Bx>... columns)
+	{
+		static_assert(sizeof...(X) == N, "one column per axis");
+		const std::size_t sizes[] = {columns.size()...};
+		for (std::size_t s : sizes) {
+			assert(s == sizes[0]);
+			(void)s;
+		}
+		assert(sizes[0] <= std::numeric_limits<std::uint32_t>::max());
+		std::array<std::vector<typename U::rep>, N> out;
+		std::size_t d = 0;
+		const int expand[] = {0, (out[d].resize(columns.size()),
+			std::transform(columns.begin(), columns.end(), out[d++].begin(),
+			               [](const Unit<std::remove_const_t<X>,Bx>& x) { return length_value<U>(x); }), 0)...};
+		(void)expand;
+		return out;
+	}
+
+	template <typename U, std::size_t N, typename X, typename Bx>
+	std::array<typename U::rep, N> convert_point(const std::array<Unit<X,Bx>, N>& p)
+	{
+		std::array<typename U::rep, N> out;
+		for (std::size_t d = 0; d < N; ++d)
+			out[d] = length_value<U>(p[d]);
+		return out;
+	}
+}
+
+// A k-d tree in an implicit layout: points are ordered so that each node is the median of its
+// range of the arrays, splitting on axis depth % N, with its subtrees either side. There are no
+// node records or pointers, and leaves of up to leaf_size points are scanned as contiguous runs
+template <std::size_t N, typename T, typename B>
+class KdTree
+{
+public:
+	using length = Unit<T,B>;
+	using point = std::array<length, N>;
+
+	static constexpr std::size_t leaf_size = 16;
+
+	// Build from one length column per axis, all of the same size. Each level of the tree is
+	// partitioned in parallel over its nodes
+	template <typename... X, typename... Bx>
+	explicit KdTree(UnitSpan<X,Bx>... columns) : KdTree(parallel::Options(), columns...) {}
+
+	template <typename... X, typename... Bx>
+	explicit KdTree(const parallel::Options& options, UnitSpan<X,Bx>... columns)
+	{
+		const std::array<std::vector<T>, N> source = detail::convert_columns<length, N>(columns...);
+		const std::size_t n = source[0].size();
+		std::vector<std::uint32_t> order(n);
+		for (std::size_t i = 0; i < n; ++i)
+			order[i] = static_cast<std::uint32_t>(i);
+
+		std::vector<std::pair<std::size_t, std::size_t>> level, next;
+		if (n > leaf_size)
+			level.emplace_back(0, n);
+		for (std::size_t depth = 0; !level.empty(); ++depth) {
+			const std::vector<T>& axis = source[depth % N];
+			parallel::for_range(level.size(), 1, [&](std::size_t r0, std::size_t r1) {
+				for (std::size_t r = r0; r < r1; ++r) {
+					const std::size_t lo = level[r].first, hi = level[r].second;
+					std::nth_element(order.begin() + lo, order.begin() + (lo + hi) / 2, order.begin() + hi,
+					                 [&axis](std::uint32_t a, std::uint32_t b) { return axis[a] < axis[b]; });
+				}
+			}, options);
+			next.clear();
+			for (const auto& range : level) {
+				const std::size_t mid = (range.first + range.second) / 2;
+				if (mid - range.first > leaf_size) next.emplace_back(range.first, mid);
+				if (range.second - mid - 1 > leaf_size) next.emplace_back(mid + 1, range.second);
+			}
+			level.swap(next);
+		}
+		points_.gather(source, std::move(order));
+	}
+
+	// Marks slots of a batch query beyond the number of points
+	static constexpr std::uint32_t no_row = std::numeric_limits<std::uint32_t>::max();
+
+	std::size_t size() const { return points_.size(); }
+
+	// Rows of the points within radius r of centre (inclusive), in no particular order
+	template <typename X, typename Bx, typename Y, typename By>
+	std::vector<std::uint32_t> within(const std::array<Unit<X,Bx>, N>& centre, const Unit<Y,By>& r) const
+	{
+		std::vector<std::uint32_t> out;
+		for_each_within(centre, r, [&out](std::uint32_t row) { out.push_back(row); });
+		return out;
+	}
+
+	// Call f(row) for each point within radius r of centre
+	template <typename X, typename Bx, typename Y, typename By, typename F>
+	void for_each_within(const std::array<Unit<X,Bx>, N>& centre, const Unit<Y,By>& r, F f) const
+	{
+		const T radius = detail::length_value<length>(r);
+		if (size() == 0 || radius < 0) return;
+		search_within(0, size(), 0, detail::convert_point<length>(centre), radius * radius, f);
+	}
+
+	// Rows of the k points nearest centre, nearest first
+	template <typename X, typename Bx>
+	std::vector<std::uint32_t> nearest(const std::array<Unit<X,Bx>, N>& centre, std::size_t k) const
+	{
+		std::vector<std::uint32_t> out(std::min(k, size()));
+		search_nearest(detail::convert_point<length>(centre), out.size(), out.data());
+		return out;
+	}
+
+	// The k nearest neighbours of each of a batch of points, given as columns in the tree's unit,
+	// into out (k rows per query, nearest first), in parallel over the queries. If the tree holds
+	// fewer than k points, the remaining slots of each row are no_row
+	template <typename... X>
+	void nearest(std::size_t k, std::uint32_t* out, const parallel::Options& options, UnitSpan<X,B>... queries) const
+	{
+		static_assert(sizeof...(X) == N, "one column per axis");
+		const std::size_t found = std::min(k, size());
+		const std::array<const T*, N> q = {{queries.values()...}};
+		const std::size_t sizes[] = {queries.size()...};
+		parallel::for_range(sizes[0], 64, [&](std::size_t i0, std::size_t i1) {
+			std::array<T, N> p;
+			for (std::size_t i = i0; i < i1; ++i) {
+				for (std::size_t d = 0; d < N; ++d)
+					p[d] = q[d][i];
+				search_nearest(p, found, out + i * k);
+				std::fill(out + i * k + found, out + (i + 1) * k, no_row);
+			}
+		}, options);
+	}
+
+private:
+	template <typename F>
+	void search_within(std::size_t lo, std::size_t hi, std::size_t depth, const std::array<T, N>& q, T r2, F& f) const
+	{
+		if (hi - lo <= leaf_size) {
+			T d2[leaf_size];
+			points_.distances2(lo, hi, q, d2);
+			for (std::size_t i = 0; i < hi - lo; ++i)
+				if (d2[i] <= r2)
+					f(points_.rows[lo + i]);
+			return;
+		}
+		const std::size_t mid = (lo + hi) / 2;
+		const std::size_t axis = depth % N;
+		const T diff = q[axis] - points_.coords[axis][mid];
+		if (points_.distance2(mid, q) <= r2)
+			f(points_.rows[mid]);
+		if (diff <= 0 || diff * diff <= r2)
+			search_within(lo, mid, depth + 1, q, r2, f);
+		if (diff >= 0 || diff * diff <= r2)
+			search_within(mid + 1, hi, depth + 1, q, r2, f);
+	}
+
+	// The k nearest, kept as a max-heap on distance while searching
+	void search_nearest(const std::array<T, N>& q, std::size_t k, std::uint32_t* out) const
+	{
+		if (k == 0) return;
+		std::vector<std::pair<T, std::uint32_t>> heap;
+		heap.reserve(k);
+		search_nearest(0, size(), 0, q, k, heap);
+		std::sort_heap(heap.begin(), heap.end());
+		for (std::size_t i = 0; i < heap.size(); ++i)
+			out[i] = points_.rows[heap[i].second];
+	}
+
+	static void offer(std::vector<std::pair<T, std::uint32_t>>& heap, std::size_t k, T d2, std::size_t i)
+	{
+		if (heap.size() < k) {
+			heap.emplace_back(d2, static_cast<std::uint32_t>(i));
+			std::push_heap(heap.begin(), heap.end());
+		}
+		else if (d2 < heap.front().first) {
+			std::pop_heap(heap.begin(), heap.end());
+			heap.back() = {d2, static_cast<std::uint32_t>(i)};
+			std::push_heap(heap.begin(), heap.end());
+		}
+	}
+
+	void search_nearest(std::size_t lo, std::size_t hi, std::size_t depth, const std::array<T, N>& q, std::size_t k,
+	                    std::vector<std::pair<T, std::uint32_t>>& heap) const
+	{
+		if (hi - lo <= leaf_size) {
+			T d2[leaf_size];
+			points_.distances2(lo, hi, q, d2);
+			for (std::size_t i = 0; i < hi - lo; ++i)
+				offer(heap, k, d2[i], lo + i);
+			return;
+		}
+		const std::size_t mid = (lo + hi) / 2;
+		const std::size_t axis = depth % N;
+		const T diff = q[axis] - points_.coords[axis][mid];
+		offer(heap, k, points_.distance2(mid, q), mid);
+		const bool left = diff < 0;
+		search_nearest(left ? lo : mid + 1, left ? mid : hi, depth + 1, q, k, heap);
+		if (heap.size() < k || diff * diff < heap.front().first)
+			search_nearest(left ? mid + 1 : lo, left ? hi : mid, depth + 1, q, k, heap);
+	}
+
+	detail::PointSet<N, T> points_;
+};
+
+template <std::size_t N, typename T, typename B>
+constexpr std::size_t KdTree<N,T,B>::leaf_size;
+
+template <std::size_t N, typename T, typename B>
+constexpr std::uint32_t KdTree<N,T,B>::no_row;
+
+// A uniform grid of cubic cells, hashed into a table about the size of the point count, so only
+// occupied cells cost memory. Points are sorted by bucket, so each bucket is a contiguous run.
+// Best when queries use a radius about the cell size
+template <std::size_t N, typename T, typename B>
+class UniformGrid
+{
+public:
+	using length = Unit<T,B>;
+
+	template <typename Y, typename By, typename... X, typename... Bx>
+	UniformGrid(const Unit<Y,By>& cell, UnitSpan<X,Bx>... columns) : UniformGrid(parallel::Options(), cell, columns...) {}
+
+	template <typename Y, typename By, typename... X, typename... Bx>
+	UniformGrid(const parallel::Options& options, const Unit<Y,By>& cell, UnitSpan<X,Bx>... columns)
+		: cell_(detail::length_value<length>(cell))
+	{
+		assert(cell_ > 0);
+		const std::array<std::vector<T>, N> source = detail::convert_columns<length, N>(columns...);
+		const std::size_t n = source[0].size();
+		std::size_t buckets = 16;
+		while (buckets < n) buckets *= 2;
+		mask_ = buckets - 1;
+
+		std::vector<std::uint32_t> bucket(n);
+		parallel::for_range(n, 4096, [&](std::size_t i0, std::size_t i1) {
+			for (std::size_t i = i0; i < i1; ++i) {
+				std::array<std::int64_t, N> c;
+				for (std::size_t d = 0; d < N; ++d)
+					c[d] = cell_of(source[d][i]);
+				bucket[i] = static_cast<std::uint32_t>(hash(c));
+			}
+		}, options);
+
+		// Counting sort by bucket
+		start_.assign(buckets + 1, 0);
+		for (std::uint32_t b : bucket)
+			++start_[b + 1];
+		for (std::size_t b = 0; b < buckets; ++b)
+			start_[b + 1] += start_[b];
+		std::vector<std::uint32_t> order(n);
+		std::vector<std::uint32_t> fill(start_.begin(), start_.end() - 1);
+		for (std::size_t i = 0; i < n; ++i)
+			order[fill[bucket[i]]++] = static_cast<std::uint32_t>(i);
+		points_.gather(source, std::move(order));
+	}
+
+	std::size_t size() const { return points_.size(); }
+	length cell() const { return length(cell_); }
+
+	template <typename X, typename Bx, typename Y, typename By>
+	std::vector<std::uint32_t> within(const std::array<Unit<X,Bx>, N>& centre, const Unit<Y,By>& r) const
+	{
+		std::vector<std::uint32_t> out;
+		for_each_within(centre, r, [&out](std::uint32_t row) { out.push_back(row); });
+		return out;
+	}
+
+	// Call f(row) for each point within radius r of centre, visiting each bucket the cells
+	// overlapping the query's bounding box hash to, once. When the box covers at least as many
+	// cells as there are buckets, every bucket is scanned instead
+	template <typename X, typename Bx, typename Y, typename By, typename F>
+	void for_each_within(const std::array<Unit<X,Bx>, N>& centre, const Unit<Y,By>& r, F f) const
+	{
+		const T radius = detail::length_value<length>(r);
+		if (size() == 0 || radius < 0) return;
+		const std::array<T, N> q = detail::convert_point<length>(centre);
+		double cells = 1;
+		for (std::size_t d = 0; d < N; ++d)
+			cells *= std::floor((q[d] + radius) / cell_) - std::floor((q[d] - radius) / cell_) + 1;
+
+		std::vector<std::uint32_t> buckets;
+		if (cells >= static_cast<double>(mask_ + 1)) {
+			buckets.resize(mask_ + 1);
+			std::iota(buckets.begin(), buckets.end(), std::uint32_t(0));
+		}
+		else {
+			std::array<std::int64_t, N> lo, hi, c;
+			for (std::size_t d = 0; d < N; ++d) {
+				lo[d] = c[d] = cell_of(q[d] - radius);
+				hi[d] = cell_of(q[d] + radius);
+			}
+			for (;;) {
+				buckets.push_back(static_cast<std::uint32_t>(hash(c)));
+				std::size_t d = 0;
+				while (d < N && c[d] == hi[d])
+					c[d] = lo[d], ++d;
+				if (d == N) break;
+				++c[d];
+			}
+			std::sort(buckets.begin(), buckets.end());
+			buckets.erase(std::unique(buckets.begin(), buckets.end()), buckets.end());
+		}
+
+		const T r2 = radius * radius;
+		std::vector<T> d2;
+		for (std::uint32_t b : buckets) {
+			const std::size_t first = start_[b], last = start_[b + 1];
+			d2.resize(last - first);
+			points_.distances2(first, last, q, d2.data());
+			for (std::size_t i = 0; i < last - first; ++i)
+				if (d2[i] <= r2)
+					f(points_.rows[first + i]);
+		}
+	}
+
+private:
+	std::int64_t cell_of(T x) const { return static_cast<std::int64_t>(std::floor(x / cell_)); }
+
+	std::size_t hash(const std::array<std::int64_t, N>& c) const
+	{
+		// Large primes per axis, as Teschner et al.'s spatial hashing
+		static const std::uint64_t primes[] = {73856093, 19349663, 83492791, 2654435761};
+		std::uint64_t h = 0;
+		for (std::size_t d = 0; d < N; ++d)
+			h ^= static_cast<std::uint64_t>(c[d]) * primes[d % 4];
+		h ^= h >> 29;
+		return static_cast<std::size_t>(h) & mask_;
+	}
+
+	T cell_;
+	std::size_t mask_ = 0;
+	std::vector<std::uint32_t> start_;
+	detail::PointSet<N, T> points_;
+};
+
+// Indexes over columns of a UnitSoA, in the given length unit
+template <typename Length, std::size_t... I, typename Alloc, typename... Units>
+KdTree<sizeof...(I), typename Length::rep, typename Length::base>
+kd_tree(const BasicUnitSoA<Alloc, Units...>& columns, const parallel::Options& options = parallel::Options())
+{
+	return KdTree<sizeof...(I), typename Length::rep, typename Length::base>(options, columns.template column<I>()...);
+}
+
+template <typename Length, std::size_t... I, typename Alloc, typename... Units, typename Y, typename By>
+UniformGrid<sizeof...(I), typename Length::rep, typename Length::base>
+uniform_grid(const BasicUnitSoA<Alloc, Units...>& columns, const Unit<Y,By>& cell,
+             const parallel::Options& options = parallel::Options())
+{
+	return UniformGrid<sizeof...(I), typename Length::rep, typename Length::base>(options, cell, columns.template column<I>()...);
+}
+
+} // spatial
+} // sunit
@@ -0,0 +1,182 @@
+#include "simpleunit/Spatial.h"
+#include <algorithm>
+#include <random>
+#include "gtest/gtest.h"
+
+using namespace std;
+using namespace sunit;
+
+namespace
+{
+	using Millimeters = Unit<float, Length<std::milli>>;
+	using Centimeters = Unit<double, Length<std::centi>>;
+	using Particles = UnitSoA<si::Meters, Millimeters, si::Meters>;
+
+	Particles particles(size_t n)
+	{
+		mt19937 rng(42);
+		uniform_real_distribution<float> u(-1, 1);
+		Particles p;
+		for (size_t i = 0; i < n; ++i)
+			p.push_back(si::Meters(u(rng)), Millimeters(1000 * u(rng)), si::Meters(u(rng)));
+		return p;
+	}
+
+	double distance2(const Particles& p, size_t i, const array<double, 3>& c)
+	{
+		const double dx = p.column<0>()[i].value() - c[0];
+		const double dy = p.column<1>()[i].value() / 1000 - c[1];
+		const double dz = p.column<2>()[i].value() - c[2];
+		return dx * dx + dy * dy + dz * dz;
+	}
+
+	// Rows within r metres by brute force, leaving out those too near the boundary to call
+	vector<uint32_t> brute_within(const Particles& p, const array<double, 3>& c, double r, vector<uint32_t>& unsure)
+	{
+		vector<uint32_t> out;
+		for (size_t i = 0; i < p.size(); ++i) {
+			const double d = sqrt(distance2(p, i, c));
+			if (abs(d - r) < 1e-5) unsure.push_back(uint32_t(i));
+			else if (d < r) out.push_back(uint32_t(i));
+		}
+		return out;
+	}
+
+	void expect_within(vector<uint32_t> found, vector<uint32_t> expected, const vector<uint32_t>& unsure)
+	{
+		found.erase(remove_if(found.begin(), found.end(), [&](uint32_t i) { return count(unsure.begin(), unsure.end(), i) > 0; }), found.end());
+		sort(found.begin(), found.end());
+		EXPECT_EQ(expected, found);
+	}
+
+	const array<array<double, 3>, 4> centres = {{{{0, 0, 0}}, {{0.5, -0.25, 0.9}}, {{-1, 1, -1}}, {{3, 3, 3}}}};
+}
+
+TEST(SpatialTest, KdTreeWithin)
+{
+	const Particles p = particles(20000);
+	const auto tree = spatial::kd_tree<si::Meters, 0, 1, 2>(p);
+	EXPECT_EQ(p.size(), tree.size());
+	for (const auto& c : centres) {
+		const array<si::Meters, 3> centre = {{si::Meters(float(c[0])), si::Meters(float(c[1])), si::Meters(float(c[2]))}};
+		vector<uint32_t> unsure;
+		const vector<uint32_t> expected = brute_within(p, c, 0.15, unsure);
+		expect_within(tree.within(centre, Centimeters(15)), expected, unsure);
+	}
+}
+
+TEST(SpatialTest, KdTreeCentreInOtherUnit)
+{
+	const Particles p = particles(5000);
+	const auto tree = spatial::kd_tree<si::Meters, 0, 1, 2>(p);
+	const array<Millimeters, 3> centre = {{Millimeters(500), Millimeters(-250), Millimeters(900)}};
+	vector<uint32_t> unsure;
+	const vector<uint32_t> expected = brute_within(p, centres[1], 0.3, unsure);
+	EXPECT_FALSE(expected.empty());
+	expect_within(tree.within(centre, Millimeters(300)), expected, unsure);
+}
+
+TEST(SpatialTest, KdTreeNearest)
+{
+	const Particles p = particles(10000);
+	const auto tree = spatial::kd_tree<si::Meters, 0, 1, 2>(p);
+	for (const auto& c : centres) {
+		const array<si::Meters, 3> centre = {{si::Meters(float(c[0])), si::Meters(float(c[1])), si::Meters(float(c[2]))}};
+		const vector<uint32_t> near = tree.nearest(centre, 8);
+		ASSERT_EQ(8u, near.size());
+
+		vector<double> d(p.size());
+		for (size_t i = 0; i < p.size(); ++i)
+			d[i] = distance2(p, i, c);
+		vector<double> sorted = d;
+		nth_element(sorted.begin(), sorted.begin() + 7, sorted.end());
+		for (size_t j = 0; j < near.size(); ++j) {
+			EXPECT_LE(d[near[j]], sorted[7] * (1 + 1e-5));
+			if (j) {
+				EXPECT_LE(d[near[j - 1]], d[near[j]] * (1 + 1e-5));
+			}
+		}
+	}
+}
+
+TEST(SpatialTest, KdTreeBatchNearest)
+{
+	const Particles p = particles(5000);
+	const auto tree = spatial::kd_tree<si::Meters, 0, 1, 2>(p);
+	UnitArray<float, Length<si::meter>> x, y, z;
+	for (const auto& c : centres) {
+		x.push_back(si::Meters(float(c[0])));
+		y.push_back(si::Meters(float(c[1])));
+		z.push_back(si::Meters(float(c[2])));
+	}
+	const size_t k = 4;
+	vector<uint32_t> out(x.size() * k);
+	tree.nearest(k, out.data(), parallel::Options(), make_span(x), make_span(y), make_span(z));
+	for (size_t q = 0; q < x.size(); ++q) {
+		const array<si::Meters, 3> centre = {{x[q], y[q], z[q]}};
+		const vector<uint32_t> one = tree.nearest(centre, k);
+		EXPECT_TRUE(equal(one.begin(), one.end(), out.begin() + q * k));
+	}
+}
+
+TEST(SpatialTest, KdTreeSmall)
+{
+	for (size_t n : {0, 1, 16, 17, 40}) {
+		const Particles p = particles(n);
+		const auto tree = spatial::kd_tree<si::Meters, 0, 1, 2>(p);
+		const array<si::Meters, 3> centre = {{si::Meters(0), si::Meters(0), si::Meters(0)}};
+		EXPECT_EQ(n, tree.within(centre, si::Meters(10)).size());
+		EXPECT_EQ(min<size_t>(n, 3), tree.nearest(centre, 3).size());
+
+		// A batch query for more neighbours than points fills the rest of each row with no_row
+		UnitArray<float, Length<si::meter>> zero(1);
+		vector<uint32_t> out(3, 0);
+		tree.nearest(3, out.data(), parallel::Options(), make_span(zero), make_span(zero), make_span(zero));
+		for (size_t j = n; j < 3; ++j)
+			EXPECT_EQ(tree.no_row, out[j]);
+	}
+}
+
+TEST(SpatialTest, UniformGridWithin)
+{
+	const Particles p = particles(20000);
+	const auto grid = spatial::uniform_grid<si::Meters, 0, 1, 2>(p, Centimeters(10));
+	EXPECT_FLOAT_EQ(0.1f, grid.cell().value());
+	for (const auto& c : centres)
+		for (double r : {0.05, 0.1, 0.25}) {
+			const array<si::Meters, 3> centre = {{si::Meters(float(c[0])), si::Meters(float(c[1])), si::Meters(float(c[2]))}};
+			vector<uint32_t> unsure;
+			const vector<uint32_t> expected = brute_within(p, c, r, unsure);
+			expect_within(grid.within(centre, si::Meters(float(r))), expected, unsure);
+		}
+}
+
+TEST(SpatialTest, UniformGridLargeRadius)
+{
+	// A radius of thousands of cells scans the buckets rather than enumerating the cells
+	const Particles p = particles(2000);
+	const auto grid = spatial::uniform_grid<si::Meters, 0, 1, 2>(p, Millimeters(1));
+	const array<si::Meters, 3> centre = {{si::Meters(0), si::Meters(0), si::Meters(0)}};
+	EXPECT_EQ(p.size(), grid.within(centre, si::Meters(10)).size());
+
+	const array<double, 3> c = {{0.2, -0.1, 0.3}};
+	vector<uint32_t> unsure;
+	const vector<uint32_t> expected = brute_within(p, c, 0.7, unsure);
+	const array<si::Meters, 3> at = {{si::Meters(0.2f), si::Meters(-0.1f), si::Meters(0.3f)}};
+	expect_within(grid.within(at, si::Meters(0.7f)), expected, unsure);
+}
+
+TEST(SpatialTest, TwoDimensions)
+{
+	UnitSoA<si::Meters, si::Meters> p;
+	for (int i = 0; i < 100; ++i)
+		for (int j = 0; j < 100; ++j)
+			p.push_back(si::Meters(float(i)), si::Meters(float(j)));
+	const array<si::Meters, 2> centre = {{si::Meters(50), si::Meters(50)}};
+	const auto tree = spatial::kd_tree<si::Meters, 0, 1>(p);
+	const auto grid = spatial::uniform_grid<si::Meters, 0, 1>(p, si::Meters(2));
+	// Lattice points within 1.5 of a lattice point: itself and the 8 around it
+	EXPECT_EQ(9u, tree.within(centre, si::Meters(1.5f)).size());
+	EXPECT_EQ(9u, grid.within(centre, si::Meters(1.5f)).size());
+	EXPECT_EQ(5u, tree.within(centre, si::Meters(1)).size());
+}
@@ -0,0 +1,164 @@
+#pragma once
+
+#include "simpleunit/Accumulator.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace sunit {
+
+// The unit of a squared quantity, at the same scales (e.g. Meters -> Meters2)
+template <typename T, typename B>
+using SquareUnit = Unit<T, BaseUnit<MulType<typename B::dim, typename B::dim>,
+                                    typename B::r1, typename B::r2, typename B::r3>>;
+
+// Single-pass count, mean, variance, skewness and range of a stream of units.
+//
+// Moments follow Welford's update for single values, and the pairwise combination of Chan et al.
+// (extended to the third moment by Pébay) for merging partial results, so statistics gathered on
+// separate threads can be merged in any order. The variance is returned in the squared unit.
+template <typename U>
+class RunningStats;
+
+template <typename T, typename B>
+class RunningStats<Unit<T,B>>
+{
+public:
+	using unit = Unit<T,B>;
+	using squared_unit = SquareUnit<T,B>;
+
+	// Bulk updates summarise the span a block at a time with a two-pass (mean, then deviations)
+	// loop over the block, which stays in cache and vectorizes, then merge each block
+	static constexpr std::size_t block_size = 4096;
+
+	RunningStats& operator+=(const unit& u)
+	{
+		const T x = u.value();
+		const T n1 = static_cast<T>(n_);
+		++n_;
+		const T n = static_cast<T>(n_);
+		const T delta = x - mean_;
+		const T delta_n = delta / n;
+		const T term = delta * delta_n * n1;
+		mean_ += delta_n;
+		m3_ += term * delta_n * (n - 2) - 3 * delta_n * m2_;
+		m2_ += term;
+		min_ = std::min(min_, x);
+		max_ = std::max(max_, x);
+		return *this;
+	}
+
+	RunningStats& operator+=(UnitSpan<const T,B> values)
+	{
+		const T* x = values.values();
+		for (std::size_t i = 0; i < values.size(); i += block_size)
+			merge(summarise(x + i, std::min(block_size, values.size() - i)));
+		return *this;
+	}
+
+	RunningStats& merge(const RunningStats& rhs)
+	{
+		if (rhs.n_ == 0) return *this;
+		if (n_ == 0) return *this = rhs;
+
+		const T na = static_cast<T>(n_);
+		const T nb = static_cast<T>(rhs.n_);
+		const T n = na + nb;
+		const T delta = rhs.mean_ - mean_;
+		const T delta_n = delta / n;
+
+		m3_ += rhs.m3_ + delta * delta_n * delta_n * na * nb * (na - nb)
+		     + 3 * delta_n * (na * rhs.m2_ - nb * m2_);
+		m2_ += rhs.m2_ + delta * delta_n * na * nb;
+		mean_ += delta_n * nb;
+		n_ += rhs.n_;
+		min_ = std::min(min_, rhs.min_);
+		max_ = std::max(max_, rhs.max_);
+		return *this;
+	}
+
+	std::size_t count() const { return n_; }
+
+	unit mean() const { return unit(mean_); }
+
+	// Sample (n - 1) and population (n) variance
+	squared_unit variance() const { return squared_unit(n_ > 1 ? m2_ / static_cast<T>(n_ - 1) : T(0)); }
+	squared_unit population_variance() const { return squared_unit(n_ > 0 ? m2_ / static_cast<T>(n_) : T(0)); }
+
+	unit stddev() const { return unit(std::sqrt(variance().value())); }
+
+	// Population skewness, dimensionless
+	T skewness() const
+	{
+		return m2_ > 0 ? std::sqrt(static_cast<T>(n_)) * m3_ / std::pow(m2_, T(1.5)) : T(0);
+	}
+
+	unit min() const { return unit(min_); }
+	unit max() const { return unit(max_); }
+
+private:
+	static RunningStats summarise(const T* x, std::size_t n)
+	{
+		RunningStats block;
+		if (n == 0) return block;
+
+		T sum[accumulator_lanes] = {};
+		T lo[accumulator_lanes], hi[accumulator_lanes];
+		std::fill(lo, lo + accumulator_lanes, std::numeric_limits<T>::max());
+		std::fill(hi, hi + accumulator_lanes, std::numeric_limits<T>::lowest());
+		std::size_t i = 0;
+		for (; i + accumulator_lanes <= n; i += accumulator_lanes) {
+			for (std::size_t l = 0; l < accumulator_lanes; ++l) {
+				sum[l] += x[i + l];
+				lo[l] = std::min(lo[l], x[i + l]);
+				hi[l] = std::max(hi[l], x[i + l]);
+			}
+		}
+		for (; i < n; ++i) {
+			sum[0] += x[i];
+			lo[0] = std::min(lo[0], x[i]);
+			hi[0] = std::max(hi[0], x[i]);
+		}
+		T total = 0;
+		for (std::size_t l = 0; l < accumulator_lanes; ++l) {
+			total += sum[l];
+			block.min_ = std::min(block.min_, lo[l]);
+			block.max_ = std::max(block.max_, hi[l]);
+		}
+		const T mean = total / static_cast<T>(n);
+
+		T m2[accumulator_lanes] = {};
+		T m3[accumulator_lanes] = {};
+		for (i = 0; i + accumulator_lanes <= n; i += accumulator_lanes) {
+			for (std::size_t l = 0; l < accumulator_lanes; ++l) {
+				const T d = x[i + l] - mean;
+				m2[l] += d * d;
+				m3[l] += d * d * d;
+			}
+		}
+		for (; i < n; ++i) {
+			const T d = x[i] - mean;
+			m2[0] += d * d;
+			m3[0] += d * d * d;
+		}
+		for (std::size_t l = 0; l < accumulator_lanes; ++l) {
+			block.m2_ += m2[l];
+			block.m3_ += m3[l];
+		}
+		block.n_ = n;
+		block.mean_ = mean;
+		return block;
+	}
+
+	std::size_t n_ = 0;
+	T mean_ = 0;
+	T m2_ = 0;
+	T m3_ = 0;
+	T min_ = std::numeric_limits<T>::max();
+	T max_ = std::numeric_limits<T>::lowest();
+};
+
+template <typename T, typename B>
+constexpr std::size_t RunningStats<Unit<T,B>>::block_size;
+
+} // sunit
@@ -0,0 +1,107 @@
+#include "simpleunit/Statistics.h"
+#include <cmath>
+#include "gtest/gtest.h"
+
+using namespace std;
+using namespace sunit;
+
+namespace
+{
+	// Skewed, offset data: squares of a sawtooth, shifted well away from zero
+	UnitArray<double, Length<si::meter>> samples(std::size_t n)
+	{
+		UnitArray<double, Length<si::meter>> values;
+		for (std::size_t i = 0; i < n; ++i) {
+			const double t = double(i % 101) / 10;
+			values.push_back(Unit<double, Length<si::meter>>(1000 + t * t));
+		}
+		return values;
+	}
+
+	struct Reference { double mean, variance, skewness; };
+
+	Reference reference(const UnitArray<double, Length<si::meter>>& values)
+	{
+		const double n = values.size();
+		double mean = 0;
+		for (const auto& v : values) mean += v.value();
+		mean /= n;
+		double m2 = 0, m3 = 0;
+		for (const auto& v : values) {
+			const double d = v.value() - mean;
+			m2 += d * d;
+			m3 += d * d * d;
+		}
+		return { mean, m2 / (n - 1), std::sqrt(n) * m3 / std::pow(m2, 1.5) };
+	}
+}
+
+TEST(StatisticsTest, Units)
+{
+	using namespace si;
+
+	RunningStats<Meters> stats;
+	stats += Meters(1);
+	stats += Meters(3);
+	stats += Centimeters(500);  // implicit conversion
+
+	EXPECT_EQ(3u, stats.count());
+	EXPECT_FLOAT_EQ(3, stats.mean().value());
+	EXPECT_FLOAT_EQ(4, stats.variance().value());
+	EXPECT_FLOAT_EQ(8.f/3, stats.population_variance().value());
+	EXPECT_FLOAT_EQ(2, stats.stddev().value());
+	EXPECT_FLOAT_EQ(1, stats.min().value());
+	EXPECT_FLOAT_EQ(5, stats.max().value());
+	EXPECT_FLOAT_EQ(0, stats.skewness());
+
+	// Variance is in the squared unit
+	EXPECT_EQ(1, (std::is_same<Meters, decltype(stats.mean())>::value));
+	EXPECT_EQ(1, (std::is_same<Meters2, decltype(stats.variance())>::value));
+	EXPECT_EQ(1, (std::is_same<Meters, decltype(stats.stddev())>::value));
+}
+
+TEST(StatisticsTest, StreamedBulkAndMerged)
+{
+	using Length = Unit<double, sunit::Length<si::meter>>;
+
+	const auto values = samples(100003);
+	const auto expected = reference(values);
+
+	RunningStats<Length> streamed;
+	for (const auto& v : values) streamed += v;
+
+	RunningStats<Length> bulk;
+	bulk += make_span(values);
+
+	// Uneven chunks merged in a different order
+	auto span = make_span(values);
+	RunningStats<Length> a, b, c;
+	a += span.subspan(0, 777);
+	b += span.subspan(777, 50000);
+	for (std::size_t i = 50777; i < span.size(); ++i) c += span[i];
+	c.merge(a).merge(b);
+
+	for (const auto* stats : {&streamed, &bulk, &c}) {
+		EXPECT_EQ(values.size(), stats->count());
+		EXPECT_NEAR(expected.mean, stats->mean().value(), 1e-12 * expected.mean);
+		EXPECT_NEAR(expected.variance, stats->variance().value(), 1e-9 * expected.variance);
+		EXPECT_NEAR(expected.skewness, stats->skewness(), 1e-9);
+		EXPECT_DOUBLE_EQ(1000, stats->min().value());
+		EXPECT_DOUBLE_EQ(1100, stats->max().value());
+	}
+	EXPECT_GT(expected.skewness, 0.1);
+}
+
+TEST(StatisticsTest, Empty)
+{
+	RunningStats<si::Meters> a, b;
+	a.merge(b);
+	EXPECT_EQ(0u, a.count());
+	EXPECT_FLOAT_EQ(0, a.variance().value());
+
+	b += si::Meters(2);
+	a.merge(b);
+	EXPECT_EQ(1u, a.count());
+	EXPECT_FLOAT_EQ(2, a.mean().value());
+	EXPECT_FLOAT_EQ(0, a.variance().value());
+}
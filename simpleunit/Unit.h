@@ -1,3 +1,5 @@
+#pragma once
+
 #include <iostream>
 #include <chrono>
 #include <ratio>
@@ -63,6 +65,11 @@ using IsMultiple = std::integral_constant<bool, (B1::r1::num * B2::r1::den) % (B
 template <typename T, typename B>
 class Unit;
 
+// Reps that behave like floating-point under conversion (no loss of information on rescaling)
+// may specialize this, as for std::chrono::treat_as_floating_point
+template <typename T>
+struct treat_as_floating_point : std::is_floating_point<T> {};
+
 constexpr int64_t ipow(int64_t base, int exp, int64_t result = 1) {
   return exp < 1 ? result : ipow(base*base, exp/2, (exp % 2) ? result*base : result);
 }
@@ -89,15 +96,26 @@ template <typename R1, typename R, int exp>
 using ConversionRatio = std::ratio_multiply<std::ratio<power_flip(R1::num, R1::den, exp), power_flip(R1::den, R1::num, exp)>,
                                             std::ratio<power_flip(R::den, R::num, exp), power_flip(R::num, R::den, exp)>>;
 
+// The factor taking a coefficient under base B1 to base B, for a quantity of dimension D
+template <typename B1, typename B, typename D = typename B1::dim>
+using BaseConversion = std::ratio_multiply<ConversionRatio<typename B1::r1, typename B::r1, D::d1>,
+                       std::ratio_multiply<ConversionRatio<typename B1::r2, typename B::r2, D::d2>,
+                                           ConversionRatio<typename B1::r3, typename B::r3, D::d3>>>;
+
+// The same factor as a value of type T, for applying a single conversion across many values
+template <typename T, typename B1, typename B, typename D = typename B1::dim>
+constexpr T conversion_factor()
+{
+	return static_cast<T>(BaseConversion<B1, B, D>::num) / static_cast<T>(BaseConversion<B1, B, D>::den);
+}
+
 template <typename ToUnit, typename X, typename B1, typename D = typename B1::dim>
 ToUnit dimension_cast(const Unit<X,B1>& unit)
 {
 	using Y = typename ToUnit::rep;
 	using B = typename ToUnit::base;
 
-	using conversion = std::ratio_multiply<ConversionRatio<typename B1::r1, typename B::r1, D::d1>,
-	                   std::ratio_multiply<ConversionRatio<typename B1::r2, typename B::r2, D::d2>,
-	                                       ConversionRatio<typename B1::r3, typename B::r3, D::d3>>>;
+	using conversion = BaseConversion<B1, B, D>;
 
 	return ToUnit(static_cast<Y>(unit.value()) * conversion::num / conversion::den);
 }
@@ -120,6 +138,7 @@ public:
 	using rep = T;
 	using base = B;
 
+	Unit() = default;
 	Unit(const T& val) : value_(val) {}
 
 	// The purpose of the following two construtors are to exclude the case for integral T but floating-point X
@@ -134,12 +153,12 @@ public:
 		value_ = unit_cast<Unit<T,B>>(rhs).value();
 	}
 
-	// The seemingly redundant test on `is_floating_point<X>` is required to make this
+	// The seemingly redundant test on `treat_as_floating_point<X>` is required to make this
 	// overload conditionally dependent on X (although there's probably a better way)
 	template < typename X, typename B1,
 		typename std::enable_if_t<
-		    (std::is_floating_point<T>::value && std::is_floating_point<X>::value) ||
-		    (std::is_floating_point<T>::value && !std::is_floating_point<X>::value), int> = 0 >
+		    (treat_as_floating_point<T>::value && treat_as_floating_point<X>::value) ||
+		    (treat_as_floating_point<T>::value && !treat_as_floating_point<X>::value), int> = 0 >
 	Unit(const Unit<X,B1>& rhs) {
 		value_ = unit_cast<Unit<T,B>>(rhs).value();
 	}
@@ -160,20 +179,23 @@ public:
 	template <typename X>
 	Unit& operator/=(const X& x) { value_ /= x; return *this; }
 
-	friend std::ostream& operator<<(std::ostream& os, const Unit& q)
-	{
-		return os << q.value()
-		       << " (" << base::r1::num << "/" << base::r1::den
-		       << ", " << base::r2::num << "/" << base::r2::den
-		       << ", " << base::r3::num << "/" << base::r3::den
-		       << ")"
-		       << " [" << base::dim::d1 << "," << base::dim::d2 << "," << base::dim::d3 << "]";
-	}
-
 private:
 	T value_;
 };
 
+// Generic printing. The named overloads at the end of this file are non-templates and so are
+// preferred over this one where they exist.
+template <typename T, typename B>
+std::ostream& operator<<(std::ostream& os, const Unit<T,B>& q)
+{
+	return os << q.value()
+	       << " (" << B::r1::num << "/" << B::r1::den
+	       << ", " << B::r2::num << "/" << B::r2::den
+	       << ", " << B::r3::num << "/" << B::r3::den
+	       << ")"
+	       << " [" << B::dim::d1 << "," << B::dim::d2 << "," << B::dim::d3 << "]";
+}
+
 template <typename R1, typename R2>
 using CommonRatio = typename std::common_type<std::chrono::duration<int,R1>, std::chrono::duration<int,R2>>::type::period;
 
@@ -256,18 +278,21 @@ template <int n, int d> using BaseRatio = BaseUnit<Dim<1>, std::ratio<n,d>>;
 
 template <typename r> using Length  = BaseUnit<Dim<1>, r>;
 template <typename r> using Length2 = BaseUnit<Dim<2>, r>;
-template <typename r> using Length3 = BaseUnit<Dim<2>, r>;
-template <typename r> using Time    = BaseUnit<Dim<0,1>, r>;
-template <typename r> using Time2   = BaseUnit<Dim<0,2>, r>;
-template <typename r> using Mass    = BaseUnit<Dim<0,0,1>, r>;
+template <typename r> using Length3 = BaseUnit<Dim<3>, r>;
+// The scale of each dimension goes in its own slot (r1 length, r2 time, r3 mass)
+template <typename r> using Time    = BaseUnit<Dim<0,1>, std::ratio<1>, r>;
+template <typename r> using Time2   = BaseUnit<Dim<0,2>, std::ratio<1>, r>;
+template <typename r> using Mass    = BaseUnit<Dim<0,0,1>, std::ratio<1>, std::ratio<1>, r>;
 
 // Derived dimensions
 
+template <typename r> using Frequency = BaseUnit<Dim<0,-1>, std::ratio<1>, r>;
+
 template <typename r1, typename r2> using Velocity       = BaseUnit<Dim<1,-1>, r1, r2>;
 template <typename r1, typename r2> using Acceleration   = BaseUnit<Dim<1,-2>, r1, r2>;
 template <typename r1, typename r2> using VolumetricFlux = BaseUnit<Dim<2,-1>, r1, r2>;
 
-template <typename r1, typename r2, typename r3> using Force = BaseUnit<Dim<1,1,-2>, r1, r2, r3>;
+template <typename r1, typename r2, typename r3> using Force = BaseUnit<Dim<1,-2,1>, r1, r2, r3>;
 
 
 namespace si {
@@ -309,6 +334,9 @@ namespace si {
 
 	// Derived units (long)
 
+	using Hertz = Unit<float, Frequency<second>>;
+	using Kilohertz = Unit<float, Frequency<std::milli>>;
+
 	using Meters_Second = Unit<float, Velocity<meter, second>>;
 	using Meters_Second2 = Unit<float, Acceleration<meter, second>>;
 	using Inches_Hour = Unit<float, Velocity<inch, hour>>;
@@ -333,27 +361,27 @@ namespace si {
 
 // Examples, to fill out
 
-std::ostream& operator<<(std::ostream& os, const si::Meters& q)
+inline std::ostream& operator<<(std::ostream& os, const si::Meters& q)
 { return os << q.value() << " m"; }
-std::ostream& operator<<(std::ostream& os, const si::Centimeters& q)
+inline std::ostream& operator<<(std::ostream& os, const si::Centimeters& q)
 { return os << q.value() << " cm"; }
-std::ostream& operator<<(std::ostream& os, const si::Millimeters& q)
+inline std::ostream& operator<<(std::ostream& os, const si::Millimeters& q)
 { return os << q.value() << " mm"; }
 
-std::ostream& operator<<(std::ostream& os, const si::Meters2_Second& q)
+inline std::ostream& operator<<(std::ostream& os, const si::Meters2_Second& q)
 { return os << q.value() << " m^2/s"; }
-std::ostream& operator<<(std::ostream& os, const si::Inches2_Second& q)
+inline std::ostream& operator<<(std::ostream& os, const si::Inches2_Second& q)
 { return os << q.value() << " in^2/s"; }
 
-std::ostream& operator<<(std::ostream& os, const si::Meters2& q)
+inline std::ostream& operator<<(std::ostream& os, const si::Meters2& q)
 { return os << q.value() << " m^2"; }
-std::ostream& operator<<(std::ostream& os, const si::Centimeters2& q)
+inline std::ostream& operator<<(std::ostream& os, const si::Centimeters2& q)
 { return os << q.value() << " cm^2"; }
 
-std::ostream& operator<<(std::ostream& os, const si::m_s& q)
+inline std::ostream& operator<<(std::ostream& os, const si::m_s& q)
 { return os << q.value() << " m/s"; }
 
-std::ostream& operator<<(std::ostream& os, const si::in_hr& q)
+inline std::ostream& operator<<(std::ostream& os, const si::in_hr& q)
 { return os << q.value() << " in/hr"; }
 
 } // sunit
@@ -0,0 +1,153 @@
+#pragma once
+
+#include "simpleunit/Unit.h"
+#include <cstddef>
+#include <memory>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace sunit {
+
+// Owning, contiguous storage of units. A Unit<T,B> is the same size as T, so this is
+// laid out exactly as an array of T.
+template <typename T, typename B = BaseUnit<>, typename Alloc = std::allocator<Unit<T,B>>>
+using UnitArray = std::vector<Unit<T,B>, Alloc>;
+
+// A non-owning view over contiguous units, in the style of std::span.
+// A `const T` gives a read-only view, e.g. UnitSpan<const float, Length<meter>>
+template <typename T, typename B = BaseUnit<>>
+class UnitSpan
+{
+public:
+	using rep = std::remove_const_t<T>;
+	using base = B;
+	using unit = Unit<rep,B>;
+	using element_type = std::conditional_t<std::is_const<T>::value, const unit, unit>;
+	using iterator = element_type*;
+
+	static_assert(sizeof(unit) == sizeof(rep), "Unit must have the same layout as its rep");
+
+	UnitSpan() : data_(nullptr), size_(0) {}
+	UnitSpan(element_type* data, std::size_t size) : data_(data), size_(size) {}
+
+	// Re-type a buffer of plain values as units of this base, without copying
+	UnitSpan(T* values, std::size_t size)
+		: data_(reinterpret_cast<element_type*>(values)), size_(size) {}
+
+	template <typename Alloc>
+	UnitSpan(std::vector<unit,Alloc>& v) : data_(v.data()), size_(v.size()) {}
+
+	template <typename Alloc, typename U = T,
+	          typename std::enable_if_t<std::is_const<U>::value, int> = 0>
+	UnitSpan(const std::vector<unit,Alloc>& v) : data_(v.data()), size_(v.size()) {}
+
+	// Mutable to read-only
+	template <typename U = T,
+	          typename std::enable_if_t<std::is_const<U>::value, int> = 0>
+	UnitSpan(const UnitSpan<rep,B>& rhs) : data_(rhs.data()), size_(rhs.size()) {}
+
+	element_type* data() const { return data_; }
+	T* values() const { return reinterpret_cast<T*>(data_); }
+
+	std::size_t size() const { return size_; }
+	bool empty() const { return size_ == 0; }
+
+	iterator begin() const { return data_; }
+	iterator end() const { return data_ + size_; }
+
+	element_type& operator[](std::size_t i) const { return data_[i]; }
+
+	UnitSpan subspan(std::size_t offset, std::size_t count) const
+	{
+		return UnitSpan(data_ + offset, count);
+	}
+
+private:
+	element_type* data_;
+	std::size_t size_;
+};
+
+template <typename T, typename B, typename Alloc>
+UnitSpan<T,B> make_span(std::vector<Unit<T,B>,Alloc>& v) { return UnitSpan<T,B>(v); }
+
+template <typename T, typename B, typename Alloc>
+UnitSpan<const T,B> make_span(const std::vector<Unit<T,B>,Alloc>& v) { return UnitSpan<const T,B>(v); }
+
+
+// Columns of units of the same length, one UnitArray per unit (structure of arrays). Columns are
+// allocated by Alloc, rebound to each unit, so may come from an arena (see Arena.h)
+//
+//     UnitSoA<Seconds, Meters_Second> log(n);
+//     auto speed = log.column<1>();  // UnitSpan<float, Velocity<meter, second>>
+template <typename Alloc, typename... Units>
+class BasicUnitSoA;
+
+template <typename... Units>
+using UnitSoA = BasicUnitSoA<std::allocator<void>, Units...>;
+
+template <typename Alloc, typename... T, typename... B>
+class BasicUnitSoA<Alloc, Unit<T,B>...>
+{
+public:
+	using allocator_type = Alloc;
+
+	static constexpr std::size_t columns = sizeof...(T);
+
+	template <std::size_t I>
+	using column_unit = std::tuple_element_t<I, std::tuple<Unit<T,B>...>>;
+
+	BasicUnitSoA() = default;
+	explicit BasicUnitSoA(const Alloc& alloc) : columns_(Column<T,B>(alloc)...) {}
+	explicit BasicUnitSoA(std::size_t n, const Alloc& alloc = Alloc()) : columns_(Column<T,B>(alloc)...) { resize(n); }
+
+	std::size_t size() const { return std::get<0>(columns_).size(); }
+	bool empty() const { return size() == 0; }
+
+	void resize(std::size_t n) { for_each_column([n](auto& c) { c.resize(n); }); }
+	void reserve(std::size_t n) { for_each_column([n](auto& c) { c.reserve(n); }); }
+	void clear() { for_each_column([](auto& c) { c.clear(); }); }
+
+	void push_back(const Unit<T,B>&... values) { push_back(std::index_sequence_for<T...>(), values...); }
+
+	template <std::size_t I>
+	UnitSpan<typename column_unit<I>::rep, typename column_unit<I>::base> column()
+	{
+		return std::get<I>(columns_);
+	}
+
+	template <std::size_t I>
+	UnitSpan<const typename column_unit<I>::rep, typename column_unit<I>::base> column() const
+	{
+		return std::get<I>(columns_);
+	}
+
+private:
+	template <typename U, typename BU>
+	using Column = UnitArray<U, BU, typename std::allocator_traits<Alloc>::template rebind_alloc<Unit<U,BU>>>;
+
+	template <typename F>
+	void for_each_column(F f) { for_each_column(f, std::index_sequence_for<T...>()); }
+
+	template <typename F, std::size_t... I>
+	void for_each_column(F& f, std::index_sequence<I...>)
+	{
+		using expand = int[];
+		(void)expand{0, (f(std::get<I>(columns_)), 0)...};
+	}
+
+	template <std::size_t... I>
+	void push_back(std::index_sequence<I...>, const Unit<T,B>&... values)
+	{
+		using expand = int[];
+		(void)expand{0, (std::get<I>(columns_).push_back(values), 0)...};
+	}
+
+	std::tuple<Column<T,B>...> columns_;
+};
+
+template <typename Alloc, typename... T, typename... B>
+constexpr std::size_t BasicUnitSoA<Alloc, Unit<T,B>...>::columns;
+
+} // sunit
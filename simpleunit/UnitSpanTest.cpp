@@ -0,0 +1,72 @@
+#include "simpleunit/UnitSpan.h"
+#include "gtest/gtest.h"
+
+using namespace std;
+using namespace sunit;
+
+TEST(UnitSpanTest, View)
+{
+	using namespace si;
+
+	UnitArray<float, Length<meter>> a = {Meters(1), Meters(2), Meters(3)};
+	auto span = make_span(a);
+	EXPECT_EQ(3u, span.size());
+	EXPECT_FLOAT_EQ(2, span[1].value());
+
+	span[1] = Meters(5);
+	EXPECT_FLOAT_EQ(5, a[1].value());
+
+	auto sub = span.subspan(1, 2);
+	EXPECT_EQ(2u, sub.size());
+	EXPECT_FLOAT_EQ(3, sub[1].value());
+
+	float total = 0;
+	for (const auto& m : span) total += m.value();
+	EXPECT_FLOAT_EQ(9, total);
+}
+
+TEST(UnitSpanTest, ConstView)
+{
+	using namespace si;
+
+	const UnitArray<float, Length<meter>> a = {Meters(1), Meters(2)};
+	auto span = make_span(a);
+	EXPECT_EQ(1, std::is_const<std::remove_reference_t<decltype(span[0])>>::value);
+
+	UnitArray<float, Length<meter>> b = {Meters(1), Meters(2)};
+	UnitSpan<const float, Length<meter>> cspan = make_span(b);
+	EXPECT_FLOAT_EQ(2, cspan[1].value());
+}
+
+TEST(UnitSpanTest, Retype)
+{
+	float raw[] = {1, 2, 3};
+	UnitSpan<float, Length<std::centi>> span(raw, 3);
+	EXPECT_FLOAT_EQ(0.03f, span[2].as<si::Meters>().value());
+	EXPECT_EQ(raw, span.values());
+}
+
+TEST(UnitSpanTest, SoA)
+{
+	using namespace si;
+
+	UnitSoA<Seconds, Meters_Second> log;
+	EXPECT_EQ(2u, (UnitSoA<Seconds, Meters_Second>::columns));
+	EXPECT_TRUE(log.empty());
+	log.push_back(Seconds(1), Meters_Second(10));
+	log.push_back(Seconds(2), Meters_Second(20));
+	EXPECT_EQ(2u, log.size());
+
+	auto speed = log.column<1>();
+	EXPECT_EQ(1, (std::is_same<UnitSpan<float, Velocity<meter, second>>, decltype(speed)>::value));
+	EXPECT_FLOAT_EQ(20, speed[1].value());
+	speed[0] = Meters_Second(15);
+
+	const auto& view = log;
+	EXPECT_FLOAT_EQ(15, view.column<1>()[0].value());
+	EXPECT_FLOAT_EQ(2, view.column<0>()[1].value());
+
+	log.resize(5);
+	EXPECT_EQ(5u, log.column<0>().size());
+	EXPECT_EQ(5u, log.column<1>().size());
+}
@@ -519,6 +519,25 @@ TEST(UnitTest, ScalarDivType)
 	EXPECT_EQ(1, std::is_floating_point<decltype(result4)>::value);
 }
 
+TEST(UnitTest, Aliases)
+{
+	using namespace si;
+
+	// Each dimension's scale sits in its own slot
+	EXPECT_FLOAT_EQ(120, Minutes(2).as<Seconds>().value());
+	EXPECT_FLOAT_EQ(2, Hours(2).as<Hours>().value());
+	EXPECT_EQ(3, int(Meters3::base::dim::d1));
+
+	auto f = Kilograms(2) * Meters_Second2(3);
+	EXPECT_EQ(1, (std::is_same<KilogramMeters_Second2, decltype(f)>::value));
+	EXPECT_FLOAT_EQ(6, f.value());
+
+	EXPECT_FLOAT_EQ(2000, Kilohertz(2).as<Hertz>().value());
+	auto cycles = Hertz(50) * Minutes(1);
+	EXPECT_EQ(0, int(decltype(cycles)::base::dim::d2));
+	EXPECT_FLOAT_EQ(3000, cycles.value());
+}
+
 // TEST(UnitTest, OutputUnits)
 // {
 // 	Millimeter a(7);
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "simpleunit/Unit.h"
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+namespace sunit {
+
+namespace detail
+{
+	template <bool... B>
+	using all_of = std::is_same<std::integer_sequence<bool, true, B...>, std::integer_sequence<bool, B..., true>>;
+}
+
+// A fixed-size vector of units of one base, as positions, velocities or forces
+//
+//     UnitVec<3, float, Length<meter>> p(Meters(1), Meters(2), Meters(3));
+//     Meters r = norm(p);
+//     auto w = dot(p, p);  // square metres
+template <std::size_t N, typename T, typename B>
+class UnitVec
+{
+public:
+	using unit = Unit<T,B>;
+	using rep = T;
+	using base = B;
+
+	static constexpr std::size_t size = N;
+
+	UnitVec() : components_() {}
+
+	template <typename... U, typename = std::enable_if_t<sizeof...(U) == N && detail::all_of<std::is_convertible<U, unit>::value...>::value>>
+	UnitVec(const U&... components) : components_{{unit(components)...}} {}
+
+	explicit UnitVec(const std::array<unit, N>& components) : components_(components) {}
+
+	// From another unit of the same dimension, converting each component where Unit converts
+	// implicitly: lossy conversions go through unit_cast of the components
+	template <typename X, typename Bx, typename = std::enable_if_t<std::is_convertible<Unit<X,Bx>, unit>::value>>
+	UnitVec(const UnitVec<N,X,Bx>& rhs)
+	{
+		for (std::size_t i = 0; i < N; ++i)
+			components_[i] = rhs[i];
+	}
+
+	unit& operator[](std::size_t i) { return components_[i]; }
+	const unit& operator[](std::size_t i) const { return components_[i]; }
+
+	UnitVec& operator+=(const UnitVec& rhs) { for (std::size_t i = 0; i < N; ++i) components_[i] += rhs[i]; return *this; }
+	UnitVec& operator-=(const UnitVec& rhs) { for (std::size_t i = 0; i < N; ++i) components_[i] -= rhs[i]; return *this; }
+	UnitVec& operator*=(T s) { for (auto& c : components_) c *= s; return *this; }
+	UnitVec& operator/=(T s) { for (auto& c : components_) c /= s; return *this; }
+
+	friend UnitVec operator+(UnitVec lhs, const UnitVec& rhs) { return lhs += rhs; }
+	friend UnitVec operator-(UnitVec lhs, const UnitVec& rhs) { return lhs -= rhs; }
+	friend UnitVec operator*(UnitVec lhs, T s) { return lhs *= s; }
+	friend UnitVec operator*(T s, UnitVec rhs) { return rhs *= s; }
+	friend UnitVec operator/(UnitVec lhs, T s) { return lhs /= s; }
+
+	friend bool operator==(const UnitVec& lhs, const UnitVec& rhs)
+	{
+		for (std::size_t i = 0; i < N; ++i)
+			if (lhs[i].value() != rhs[i].value()) return false;
+		return true;
+	}
+	friend bool operator!=(const UnitVec& lhs, const UnitVec& rhs) { return !(lhs == rhs); }
+
+private:
+	std::array<unit, N> components_;
+};
+
+template <std::size_t N, typename T, typename B>
+constexpr std::size_t UnitVec<N,T,B>::size;
+
+// The dot product, in the product of the units
+template <std::size_t N, typename X, typename B1, typename Y, typename B2>
+auto dot(const UnitVec<N,X,B1>& a, const UnitVec<N,Y,B2>& b) -> decltype(a[0] * b[0])
+{
+	decltype(a[0] * b[0]) sum = a[0] * b[0];
+	for (std::size_t i = 1; i < N; ++i)
+		sum += a[i] * b[i];
+	return sum;
+}
+
+// The cross product, in the product of the units
+template <typename X, typename B1, typename Y, typename B2>
+auto cross(const UnitVec<3,X,B1>& a, const UnitVec<3,Y,B2>& b)
+	-> UnitVec<3, typename decltype(a[0] * b[0])::rep, typename decltype(a[0] * b[0])::base>
+{
+	return {a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0]};
+}
+
+// The Euclidean length, in the vector's unit
+template <std::size_t N, typename T, typename B>
+Unit<T,B> norm(const UnitVec<N,T,B>& v)
+{
+	T sum = 0;
+	for (std::size_t i = 0; i < N; ++i)
+		sum += v[i].value() * v[i].value();
+	return Unit<T,B>(static_cast<T>(std::sqrt(sum)));
+}
+
+} // sunit
@@ -0,0 +1,54 @@
+#include "simpleunit/UnitVec.h"
+#include "gtest/gtest.h"
+
+using namespace std;
+using namespace sunit;
+
+namespace
+{
+	using Millimeters = Unit<float, Length<std::milli>>;
+	using Position = UnitVec<3, float, Length<si::meter>>;
+}
+
+TEST(UnitVecTest, Arithmetic)
+{
+	const Position a(si::Meters(1), si::Meters(2), si::Meters(3));
+	const Position b(si::Meters(4), si::Meters(5), si::Meters(6));
+	EXPECT_EQ(Position(si::Meters(5), si::Meters(7), si::Meters(9)), a + b);
+	EXPECT_EQ(Position(si::Meters(3), si::Meters(3), si::Meters(3)), b - a);
+	EXPECT_EQ(Position(si::Meters(2), si::Meters(4), si::Meters(6)), 2.f * a);
+	EXPECT_EQ(a, (a * 4.f) / 4.f);
+	EXPECT_FLOAT_EQ(5, norm(Position(si::Meters(3), si::Meters(4), si::Meters(0))).value());
+}
+
+TEST(UnitVecTest, Products)
+{
+	const Position a(si::Meters(1), si::Meters(0), si::Meters(0));
+	const Position b(si::Meters(0), si::Meters(2), si::Meters(0));
+	const auto area = dot(a + b, b);
+	static_assert(is_same<decltype(area)::base::dim, Dim<2>>::value, "dot of lengths is an area");
+	EXPECT_FLOAT_EQ(4, area.value());
+
+	const auto c = cross(a, b);
+	static_assert(is_same<decltype(c)::base::dim, Dim<2>>::value, "cross of lengths is an area");
+	EXPECT_FLOAT_EQ(0, c[0].value());
+	EXPECT_FLOAT_EQ(0, c[1].value());
+	EXPECT_FLOAT_EQ(2, c[2].value());
+}
+
+TEST(UnitVecTest, Conversion)
+{
+	const UnitVec<3, float, Length<std::milli>> mm(Millimeters(1500), Millimeters(-20), Millimeters(0));
+	const Position m = mm;
+	EXPECT_FLOAT_EQ(1.5f, m[0].value());
+	EXPECT_FLOAT_EQ(-0.02f, m[1].value());
+	EXPECT_FLOAT_EQ(0, m[2].value());
+
+	// As for Unit, conversions that may lose information are not implicit
+	using IntMillimeters = UnitVec<3, int, Length<std::milli>>;
+	using IntMeters = UnitVec<3, int, Length<si::meter>>;
+	static_assert(is_convertible<IntMeters, IntMillimeters>::value, "metres to millimetres is exact");
+	static_assert(!is_convertible<IntMillimeters, IntMeters>::value, "millimetres to metres truncates");
+	static_assert(!is_convertible<Position, IntMeters>::value, "float to int truncates");
+	static_assert(is_convertible<IntMillimeters, Position>::value, "int to float");
+}